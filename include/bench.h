@@ -0,0 +1,19 @@
+/**
+ * @file bench.h
+ * @brief Scanner throughput benchmark against the emulated DW3000
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @brief Start the benchmark thread
+ *
+ * Steps the emulated traffic through 10, 100 and 1000 frames/s and the
+ * configured scenario, if any, sends one "bench" record per step and a
+ * "bench_end" verdict, then exits the process on native_sim with status 1
+ * if a budget was missed.
+ */
+void bench_start(void);
+
+#endif /* BENCH_H */
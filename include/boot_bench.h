@@ -0,0 +1,22 @@
+/**
+ * @file boot_bench.h
+ * @brief Boot-to-first-frame measurement against the emulated DW3000
+ */
+
+#ifndef BOOT_BENCH_H
+#define BOOT_BENCH_H
+
+#include "uart_output.h"
+
+/**
+ * @brief Start the boot measurement thread
+ *
+ * Waits for the scanner's first frame, sends a "boot_bench" record with
+ * the boot phase times, then exits the process on native_sim with status
+ * 1 if scanning or the first frame came later than its budget.
+ *
+ * @param boot Boot phase timestamps from main()
+ */
+void boot_bench_start(const uart_output_boot_t *boot);
+
+#endif /* BOOT_BENCH_H */
@@ -0,0 +1,70 @@
+/**
+ * @file clock_sync.h
+ * @brief Inter-scanner clock synchronisation for passive TDoA
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Synchronisation role of this scanner
+ */
+typedef enum {
+    CLOCK_SYNC_ROLE_NONE = 0,  /* Sync disabled */
+    CLOCK_SYNC_ROLE_REFERENCE, /* Transmits sync beacons */
+    CLOCK_SYNC_ROLE_LISTENER,  /* Fits local clock against beacons */
+} clock_sync_role_t;
+
+/**
+ * @brief Initialize clock synchronisation
+ *
+ * @param role Role of this scanner
+ * @return 0 on success, negative error code otherwise
+ */
+int clock_sync_init(clock_sync_role_t role);
+
+/**
+ * @brief Get the configured synchronisation role
+ *
+ * @return Current role
+ */
+clock_sync_role_t clock_sync_get_role(void);
+
+/**
+ * @brief Transmit a sync beacon if one is due (reference role only)
+ *
+ * Must be called from the scanner thread between RX windows.
+ *
+ * @return 0 if nothing to do or beacon sent, negative error code otherwise
+ */
+int clock_sync_poll_beacon(void);
+
+/**
+ * @brief Feed a received frame to the synchronisation fit
+ *
+ * @param frame Frame data
+ * @param length Frame length
+ * @param rx_timestamp 40-bit local RX timestamp
+ * @return true if the frame was a sync beacon and has been consumed; always
+ *         false with CLOCK_SYNC_ROLE_NONE
+ */
+bool clock_sync_process_frame(const uint8_t *frame, uint16_t length,
+                              uint64_t rx_timestamp);
+
+/**
+ * @brief Map a local RX timestamp into the shared timebase
+ *
+ * The result is an unwrapped 64-bit count of reference DW3000 ticks
+ * (~15.65 ps each). Propagation delay from the reference to this scanner
+ * is a constant offset that the host removes using scanner positions.
+ *
+ * @param rx_timestamp 40-bit local RX timestamp
+ * @param shared_ts Filled with the timestamp in the shared timebase
+ * @return true if locked and @p shared_ts is valid, false otherwise
+ */
+bool clock_sync_map(uint64_t rx_timestamp, uint64_t *shared_ts);
+
+#endif /* CLOCK_SYNC_H */
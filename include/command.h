@@ -0,0 +1,24 @@
+/**
+ * @file command.h
+ * @brief Host command channel
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+
+#include "uart_output.h"
+
+/**
+ * @brief Parse and execute one command line from the host
+ *
+ * Suitable as a uart_input line handler.
+ *
+ * @param line NUL-terminated command line
+ * @param rx_time_us Uptime in microseconds when the line arrived
+ * @param channel Interface the line arrived on, replies go back there
+ */
+void command_handle_line(const char *line, uint64_t rx_time_us, uart_channel_t channel);
+
+#endif /* COMMAND_H */
@@ -0,0 +1,87 @@
+/**
+ * @file device_table.h
+ * @brief Table of recently seen UWB devices
+ */
+
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "uwb_scanner.h"
+
+/* Cursor returned by device_table_foreach() once every entry was visited */
+#define DEVICE_TABLE_END UINT32_MAX
+
+/**
+ * @brief Per-device sighting state
+ */
+typedef struct {
+    uint64_t device_addr;      /* Device address, 0 for a free slot */
+    uint32_t first_seen_ms;    /* Uptime of the first sighting */
+    uint32_t last_seen_ms;     /* Uptime of the latest sighting */
+    uint32_t last_output_ms;   /* Uptime the device was last reported */
+    uint32_t count;            /* Sightings since first seen */
+    uint32_t pending;          /* Sightings since last reported */
+    float last_rssi_dbm;       /* RSSI of the latest sighting */
+    float best_rssi_dbm;       /* Strongest RSSI since last reported */
+} device_entry_t;
+
+/**
+ * @brief Callback for device_table_foreach()
+ *
+ * @param entry Table entry, may be modified
+ * @param user_data Opaque pointer passed to device_table_foreach()
+ * @return true to continue, false to stop at this entry
+ */
+typedef bool (*device_table_cb_t)(device_entry_t *entry, void *user_data);
+
+/**
+ * @brief Record a sighting
+ *
+ * When the table is full the least recently seen device is evicted. The
+ * table is not locked; callers serialise access.
+ *
+ * @param info Sighting to record
+ * @return Entry for the device
+ */
+device_entry_t *device_table_update(const uwb_device_info_t *info);
+
+/**
+ * @brief Mark a device as reported
+ *
+ * @param entry Entry returned by device_table_update()
+ * @param now_ms Current uptime in milliseconds
+ */
+void device_table_mark_output(device_entry_t *entry, uint32_t now_ms);
+
+/**
+ * @brief Look up a device without recording a sighting
+ *
+ * @param device_addr Device address
+ * @return Entry for the device, or NULL if it is not in the table
+ */
+device_entry_t *device_table_find(uint64_t device_addr);
+
+/**
+ * @brief Call @p cb for every device in the table
+ *
+ * Iteration can be resumed: pass the returned cursor as @p cursor to
+ * continue after the entry where @p cb stopped.
+ *
+ * @param cursor Slot to start from, 0 for the whole table
+ * @param cb Callback
+ * @param user_data Passed through to @p cb
+ * @return Cursor of the entry @p cb stopped at, or DEVICE_TABLE_END
+ */
+uint32_t device_table_foreach(uint32_t cursor, device_table_cb_t cb, void *user_data);
+
+/**
+ * @brief Get the number of devices in the table
+ *
+ * @return Device count
+ */
+uint32_t device_table_count(void);
+
+#endif /* DEVICE_TABLE_H */
@@ -19,10 +19,30 @@
 #define DW3000_REG_RX_TTCKI         0x13
 #define DW3000_REG_RX_TIME          0x15
 #define DW3000_REG_TX_TIME          0x17
+#define DW3000_REG_TX_BUFFER        0x14
+#define DW3000_REG_SYS_TIME         0x1C
+#define DW3000_REG_DX_TIME          0x2C
 #define DW3000_REG_SYS_STATUS       0x44
 #define DW3000_REG_RX_FINFO         0x10
 #define DW3000_REG_CIA_CONF         0x50
 #define DW3000_REG_IP_CONF          0x52
+#define DW3000_REG_RX_SNIFF         0x009C     /* File 0x01, offset 0x1C */
+
+/* Always-on (AON) registers, file 0x0A */
+#define DW3000_REG_AON_DIG_CFG      0x0500
+#define DW3000_REG_AON_CTRL         0x0504
+#define DW3000_REG_AON_CFG          0x0514
+
+/* AON_DIG_CFG: actions on wake */
+#define DW3000_AON_ONW_AON_DLD      (1 << 0)   /* Restore configuration from AON */
+#define DW3000_AON_ONW_GO2IDLE      (1 << 8)   /* Lock the PLL and enter IDLE */
+
+/* AON_CTRL */
+#define DW3000_AON_CTRL_SAVE        (1 << 1)   /* Save configuration and sleep */
+
+/* AON_CFG */
+#define DW3000_AON_SLEEP_EN         (1 << 0)   /* Sleep when configuration is saved */
+#define DW3000_AON_WAKE_WUP         (1 << 4)   /* Wake on the WAKEUP pin */
 
 /* DW3000 Configuration */
 #define DW3000_CHANNEL_5            5
@@ -39,6 +59,41 @@
 #define DW3000_STATUS_RXRFTO        (1 << 17)  /* Receiver Frame Wait Timeout */
 #define DW3000_STATUS_RXPTO         (1 << 21)  /* Preamble Timeout */
 #define DW3000_STATUS_RXFR          (1 << 13)  /* Frame Ready */
+#define DW3000_STATUS_CPLOCK        (1 << 1)   /* Clock PLL locked */
+#define DW3000_STATUS_TXFRS         (1 << 7)   /* Transmit Frame Sent */
+#define DW3000_STATUS_SPIRDY        (1 << 23)  /* SPI ready after reset or wakeup */
+#define DW3000_STATUS_RCINIT        (1 << 24)  /* RC oscillator up, IDLE_RC reached */
+
+/* Fast commands (single-byte SPI transactions) */
+#define DW3000_CMD_TXRXOFF          0x00
+#define DW3000_CMD_TX               0x01
+#define DW3000_CMD_RX               0x02
+#define DW3000_CMD_DTX              0x03
+
+/* Preamble symbol duration at 64 MHz PRF, in ns (508 chips at 499.2 MHz) */
+#define DW3000_SYMBOL_NS            1018
+#define DW3000_SNIFF_OFF_UNIT_NS    1026       /* SNIFF_OFF count unit */
+
+/* Device time: 40-bit counter clocked at 499.2 MHz * 128 (~15.65 ps/tick) */
+#define DW3000_TIME_MASK            0xFFFFFFFFFFULL
+#define DW3000_TIME_TICKS_PER_SEC   63897600000ULL
+
+/**
+ * @brief Signed difference between two 40-bit device times
+ *
+ * Correct across a counter wrap as long as the true difference is under
+ * half the wrap period (~8.6 s).
+ */
+static inline int64_t dw3000_time_delta(uint64_t now, uint64_t then)
+{
+    int64_t delta = (int64_t)((now - then) & DW3000_TIME_MASK);
+
+    if (delta & (1LL << 39)) {
+        delta -= (1LL << 40);
+    }
+
+    return delta;
+}
 
 /**
  * @brief DW3000 configuration structure
@@ -50,6 +105,8 @@ typedef struct {
     uint8_t pac_size;          /* Preamble acquisition chunk size */
     uint16_t tx_preamble_code; /* TX preamble code */
     uint16_t rx_preamble_code; /* RX preamble code */
+    uint8_t sniff_on_pac;      /* Sniff mode receiver on time in PACs, 0 disables */
+    uint8_t sniff_off;         /* Sniff mode receiver off time (~1 us units) */
 } dw3000_config_t;
 
 /**
@@ -72,6 +129,25 @@ typedef struct {
  */
 int dw3000_init(void);
 
+/**
+ * @brief Initialize DW3000 chip at a known good SPI clock
+ *
+ * Skips the discovery probe: resets the chip, verifies the device ID with
+ * a single read at the slow clock, then switches SPI to @p spi_hz. Callers
+ * fall back to dw3000_init() on failure.
+ *
+ * @param spi_hz SPI clock the chip was last run at
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_init_warm(uint32_t spi_hz);
+
+/**
+ * @brief Get the SPI clock currently used for the DW3000
+ *
+ * @return SPI clock in Hz
+ */
+uint32_t dw3000_get_spi_frequency(void);
+
 /**
  * @brief Configure DW3000 for operation
  *
@@ -80,6 +156,47 @@ int dw3000_init(void);
  */
 int dw3000_configure(const dw3000_config_t *config);
 
+/**
+ * @brief Derive sniff mode timing from PAC size and preamble length
+ *
+ * While hunting for preamble the receiver is on for two PACs and then off
+ * for as long as still leaves half the preamble for acquisition after a
+ * detection, so no frame is missed that the receiver would catch fully on.
+ *
+ * @param config Configuration whose sniff fields are set
+ * @param preamble_symbols Preamble length in symbols
+ * @return 0 on success, -ENOTSUP if the preamble is too short to sniff
+ */
+int dw3000_sniff_timing(dw3000_config_t *config, uint16_t preamble_symbols);
+
+/**
+ * @brief Estimated receiver on-time share while hunting for preamble
+ *
+ * @param config Radio configuration
+ * @return On-time in permille, 1000 with sniff mode off
+ */
+uint16_t dw3000_sniff_duty_permille(const dw3000_config_t *config);
+
+/**
+ * @brief Put the DW3000 into DEEPSLEEP
+ *
+ * The current configuration is saved in the always-on block and restored
+ * by the chip itself on wake, so dw3000_configure() need not run again.
+ * The device time counter stops while asleep.
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_sleep(void);
+
+/**
+ * @brief Wake the DW3000 from DEEPSLEEP
+ *
+ * Returns once the configuration is restored and the PLL is locked.
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_wake(void);
+
 /**
  * @brief Enable receiver mode
  *
@@ -99,10 +216,54 @@ int dw3000_read_frame(dw3000_rx_frame_t *frame);
 /**
  * @brief Check if frame is ready to be read
  *
- * @return true if frame ready, false otherwise
+ * @return 1 if a good frame is ready, 0 if not, negative error code if
+ *         SYS_STATUS could not be read or reads as all ones
+ */
+int dw3000_poll_frame(void);
+
+/**
+ * @brief Check if frame is ready to be read
+ *
+ * @return true if frame ready, false otherwise (read errors included)
  */
 bool dw3000_is_frame_ready(void);
 
+/**
+ * @brief Read the current 40-bit device time
+ *
+ * @param time Filled with the device time in DW3000 ticks
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_read_sys_time(uint64_t *time);
+
+/**
+ * @brief Transmit a frame at a scheduled device time
+ *
+ * The low 9 bits of @p tx_time are ignored by the chip, so callers should
+ * clear them to know the exact transmit time.
+ *
+ * @param data Frame payload (without FCS, the chip appends it)
+ * @param len Payload length
+ * @param tx_time Device time at which transmission starts
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_tx_frame_delayed(const uint8_t *data, uint16_t len, uint64_t tx_time);
+
+/**
+ * @brief Check if the last transmission has completed
+ *
+ * @return true if frame sent, false otherwise
+ */
+bool dw3000_is_tx_done(void);
+
+/**
+ * @brief Issue a fast command
+ *
+ * @param cmd Fast command code (DW3000_CMD_*)
+ * @return 0 on success, negative error code otherwise
+ */
+int dw3000_fast_command(uint8_t cmd);
+
 /**
  * @brief Get device ID
  *
@@ -110,6 +271,15 @@ bool dw3000_is_frame_ready(void);
  */
 uint32_t dw3000_get_device_id(void);
 
+/**
+ * @brief Check that the DW3000 still answers with its device ID
+ *
+ * One register read, cheap enough to run between RX windows.
+ *
+ * @return 0 if the ID matches, negative error code otherwise
+ */
+int dw3000_check_id(void);
+
 /**
  * @brief Set device address (EUI-64)
  *
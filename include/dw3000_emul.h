@@ -0,0 +1,84 @@
+/**
+ * @file dw3000_emul.h
+ * @brief Emulated DW3000 on the SPI emulator bus
+ *
+ * Answers the driver's register accesses with a minimal model of the
+ * receiver and feeds it synthetic traffic from the scenario engine
+ * (scenario.h): either the CONFIG_UWB_DW3000_EMUL_SCENARIO file or data
+ * frames from a set of tags arriving as a Poisson process at a given
+ * rate. A frame source can take the place of the engine. SPI transfers take the bus time they would take at the
+ * configured clock, so on native_sim the frame path costs simulated time
+ * in proportion to its SPI traffic.
+ */
+
+#ifndef DW3000_EMUL_H
+#define DW3000_EMUL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "scenario.h"
+
+/**
+ * @brief Traffic counters
+ */
+typedef struct {
+    uint32_t generated;        /* Frames sent on air */
+    uint32_t received;         /* Frames the receiver caught */
+    uint32_t missed;           /* Receiver off or a previous frame not read yet */
+    uint32_t collided;         /* Frames lost to collisions */
+    uint32_t errors;           /* Collisions the receiver caught as RXFCE */
+    uint32_t spi_bytes;        /* Bytes clocked on the bus */
+} dw3000_emul_stats_t;
+
+/**
+ * @brief Replace the traffic with Poisson arrivals from 16 tags
+ *
+ * @param frames_per_s Mean frame rate, 0 for silence
+ */
+void dw3000_emul_set_rate(uint32_t frames_per_s);
+
+/**
+ * @brief Replace the traffic with the configured scenario, from its start
+ *
+ * @return 0 on success, -ENOENT if no scenario is configured, negative
+ *         errno if it does not parse
+ */
+int dw3000_emul_play_scenario(void);
+
+/**
+ * @brief Frame source replacing the scenario engine
+ *
+ * @param frame Filled with the next frame, times relative to when the
+ *        source was set and in arrival order
+ * @return false at the end of the traffic
+ */
+typedef bool (*dw3000_emul_source_t)(scenario_frame_t *frame);
+
+/**
+ * @brief Replace the traffic with frames from a source
+ *
+ * The source is called with the emulator's lock held and must not call
+ * back into the emulator.
+ *
+ * @param source Frame source, NULL for silence
+ * @param asap Ignore the arrival times and send each frame as soon as the
+ *        receiver is on and the previous frame has been read
+ */
+void dw3000_emul_set_source(dw3000_emul_source_t source, bool asap);
+
+/**
+ * @brief Get the nominal rate of the current traffic
+ *
+ * @return Frames/s, 0 for silence
+ */
+uint32_t dw3000_emul_rate(void);
+
+/**
+ * @brief Read and clear the traffic counters
+ *
+ * @param stats Filled with the counters since the previous call
+ */
+void dw3000_emul_take_stats(dw3000_emul_stats_t *stats);
+
+#endif /* DW3000_EMUL_H */
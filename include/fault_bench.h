@@ -0,0 +1,19 @@
+/**
+ * @file fault_bench.h
+ * @brief SPI fault recovery benchmark against the emulated DW3000
+ */
+
+#ifndef FAULT_BENCH_H
+#define FAULT_BENCH_H
+
+/**
+ * @brief Start the fault benchmark thread
+ *
+ * Holds steady emulated traffic, arms each SPI fault class briefly and
+ * then for CONFIG_UWB_FAULT_BENCH_SUSTAINED_MS, sends one "fault" record
+ * per run and a "fault_end" verdict, then exits the process on native_sim
+ * with status 1 if scanning did not resume in time.
+ */
+void fault_bench_start(void);
+
+#endif /* FAULT_BENCH_H */
@@ -0,0 +1,106 @@
+/**
+ * @file flight_recorder.h
+ * @brief Ring of recent frames and events kept in retained RAM
+ *
+ * Always-on, fixed-size binary log for post-mortem analysis. The ring
+ * lives in RAM that is not cleared at startup, so it survives a warm
+ * reboot and the previous boot's tail can still be dumped afterwards.
+ * With CONFIG_UWB_FLIGHT_RECORDER off the FLIGHT_RECORD() calls compile
+ * away.
+ */
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Entry types; meaning of a/b/c per type */
+typedef enum {
+    FR_BOOT = 1,               /* a: boot count */
+    FR_FRAME,                  /* a: length, b: header bytes 0-3, c: bytes 4-7 (little endian) */
+    FR_STATUS,                 /* b: SYS_STATUS when it changed */
+    FR_SPI_ERROR,              /* a: register key (see spi_profile.h), b: result */
+    FR_RX_ERROR,               /* a: 0 RX enable, 1 frame read, 2 status, b: result */
+    FR_CONFIG,                 /* a: configuration version applied */
+    FR_SLEEP,                  /* b: sleep time (ms) */
+    FR_WAKE,                   /* b: result */
+    FR_SCANNER_STOP,           /* Scanner thread found stopped */
+    FR_RESTART,                /* b: restart result */
+    FR_FATAL,                  /* a: reason, b: faulting thread */
+    FR_RECOVERY,               /* a: attempt, b: re-init result */
+    FR_TYPE_COUNT,
+} fr_type_t;
+
+/**
+ * @brief One 16-byte flight recorder entry
+ */
+typedef struct {
+    uint32_t time_us;          /* Uptime in the boot it was written in (wraps after ~71 min) */
+    uint8_t type;              /* fr_type_t */
+    uint8_t boot;              /* Boot count, low 8 bits */
+    uint16_t a;
+    uint32_t b;
+    uint32_t c;
+} fr_entry_t;
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+
+#define FLIGHT_RECORD(type, a, b, c) \
+    flight_recorder_log((type), (uint16_t)(a), (uint32_t)(b), (uint32_t)(c))
+
+/**
+ * @brief Adopt the ring left by the previous boot, or start a new one
+ *
+ * Call before anything is recorded.
+ */
+void flight_recorder_init(void);
+
+/**
+ * @brief Append an entry; lock-free, safe from any thread or ISR
+ */
+void flight_recorder_log(fr_type_t type, uint16_t a, uint32_t b, uint32_t c);
+
+/**
+ * @brief Sequence number the next entry will get
+ *
+ * Sequence numbers continue across warm reboots.
+ */
+uint32_t flight_recorder_head(void);
+
+/**
+ * @brief Sequence number of the oldest entry still in the ring
+ */
+uint32_t flight_recorder_oldest(void);
+
+/**
+ * @brief Copy one entry
+ *
+ * @param seq Sequence number
+ * @param entry Filled with the entry
+ * @return false if the entry has been overwritten or not written yet
+ */
+bool flight_recorder_get(uint32_t seq, fr_entry_t *entry);
+
+/**
+ * @brief Boots recorded since the ring was last started afresh
+ */
+uint32_t flight_recorder_boots(void);
+
+/**
+ * @brief Check whether the previous boot ended in a fatal error
+ */
+bool flight_recorder_prev_fatal(void);
+
+/**
+ * @brief Short name of an entry type
+ */
+const char *flight_recorder_type_name(uint8_t type);
+
+#else
+
+#define FLIGHT_RECORD(type, a, b, c) do { } while (0)
+
+#endif /* CONFIG_UWB_FLIGHT_RECORDER */
+
+#endif /* FLIGHT_RECORDER_H */
@@ -0,0 +1,67 @@
+/**
+ * @file frame_parse.h
+ * @brief IEEE 802.15.4 frame header parsing and RSSI distance estimate
+ *
+ * Pure functions with no Zephyr dependency, shared by the scanner and the
+ * host tools (tools/frame_bench.c).
+ */
+
+#ifndef FRAME_PARSE_H
+#define FRAME_PARSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* IEEE 802.15.4 frame types */
+#define IEEE154_FRAME_TYPE_BEACON 0x00
+#define IEEE154_FRAME_TYPE_DATA   0x01
+#define IEEE154_FRAME_TYPE_ACK    0x02
+#define IEEE154_FRAME_TYPE_MAC    0x03
+
+/* Addressing modes */
+#define IEEE154_ADDR_NONE         0x00
+#define IEEE154_ADDR_SHORT        0x02
+#define IEEE154_ADDR_EXTENDED     0x03
+
+/**
+ * @brief Frame control field
+ */
+typedef struct {
+    uint8_t frame_type;
+    bool security_enabled;
+    bool frame_pending;
+    bool ack_request;
+    bool pan_id_compress;
+    uint8_t dest_addr_mode;
+    uint8_t src_addr_mode;
+} ieee154_fcf_t;
+
+/**
+ * @brief Split a frame control field into its parts
+ *
+ * @param fcf Frame control field (first two frame bytes, little endian)
+ * @param parsed Filled with the fields
+ */
+void frame_parse_fcf(uint16_t fcf, ieee154_fcf_t *parsed);
+
+/**
+ * @brief Extract the source address
+ *
+ * @param frame Frame bytes, starting with the frame control field
+ * @param length Frame length
+ * @param fcf Parsed frame control field
+ * @return Short or extended source address, 0 if there is none or the
+ *         frame is too short to hold it
+ */
+uint64_t frame_parse_source_address(const uint8_t *frame, uint16_t length,
+                                    const ieee154_fcf_t *fcf);
+
+/**
+ * @brief Estimate distance from received power with a log-distance path loss model
+ *
+ * @param rssi_dbm Received signal level (dBm)
+ * @return Distance (cm)
+ */
+float frame_parse_distance_cm(float rssi_dbm);
+
+#endif /* FRAME_PARSE_H */
@@ -0,0 +1,20 @@
+/**
+ * @file journal_bench.h
+ * @brief Sighting journal spill and flush check on native_sim
+ */
+
+#ifndef JOURNAL_BENCH_H
+#define JOURNAL_BENCH_H
+
+/**
+ * @brief Start the journal check thread
+ *
+ * Takes the console host away, feeds CONFIG_UWB_JOURNAL_BENCH_RECORDS
+ * sightings so the journal spills into the flash simulator, brings the
+ * host back and sends a "journal_bench" record once the backlog is
+ * flushed, then exits the process on native_sim with status 1 if any
+ * sighting was dropped or not flushed.
+ */
+void journal_bench_start(void);
+
+#endif /* JOURNAL_BENCH_H */
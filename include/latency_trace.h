@@ -0,0 +1,129 @@
+/**
+ * @file latency_trace.h
+ * @brief Per-frame latency tracing from RX to the host link
+ *
+ * Each sighting carries cycle counter stamps taken as it passes through
+ * the pipeline. Once written to a sink the stage durations go into
+ * log-linear histograms reported as p50/p99/max. With
+ * CONFIG_UWB_LATENCY_TRACE off the trace field and all marks compile
+ * away.
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Points in the pipeline a frame is stamped at */
+typedef enum {
+    LATENCY_MARK_READY = 0,    /* Frame ready seen (stands in for the RX IRQ) */
+    LATENCY_MARK_READ,         /* SPI read of the frame complete */
+    LATENCY_MARK_PARSE,        /* Frame parsed, device info filled in */
+    LATENCY_MARK_SERIALIZE,    /* JSON record formatted */
+    LATENCY_MARK_SINK,         /* Record written to the console or taken by the CDC driver */
+    LATENCY_MARK_COUNT,
+} latency_mark_t;
+
+/* Histogram stages */
+typedef enum {
+    LATENCY_STAGE_AIR = 0,     /* Antenna to frame ready */
+    LATENCY_STAGE_READ,        /* Frame ready to SPI read complete */
+    LATENCY_STAGE_PARSE,       /* Read to parsed */
+    LATENCY_STAGE_SERIALIZE,   /* Parsed to formatted */
+    LATENCY_STAGE_SINK,        /* Formatted to written */
+    LATENCY_STAGE_PIPELINE,    /* Frame ready to written */
+    LATENCY_STAGE_TOTAL,       /* Antenna to written */
+    LATENCY_STAGE_COUNT,
+} latency_stage_t;
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+
+#include <zephyr/timing/timing.h>
+
+#define LATENCY_AIR_UNKNOWN UINT32_MAX
+
+typedef struct {
+    timing_t t[LATENCY_MARK_COUNT];
+    uint32_t air_us;           /* Antenna to LATENCY_MARK_READY, if the timebase is locked */
+} latency_trace_t;
+
+#define LATENCY_TRACE_MARK(trace, mark) ((trace)->t[(mark)] = timing_counter_get())
+#define LATENCY_TRACE_AIR(trace, valid, rx_time_ns) \
+    latency_trace_set_air((trace), (valid), (rx_time_ns))
+
+/**
+ * @brief Start the cycle counter used for the stamps
+ */
+void latency_trace_init(void);
+
+/**
+ * @brief Derive the antenna-to-ready time from the frame's RX timestamp
+ *
+ * Call right after LATENCY_MARK_PARSE.
+ *
+ * @param trace Frame trace
+ * @param valid True if @p rx_time_ns is valid
+ * @param rx_time_ns RX timestamp mapped onto uptime
+ */
+void latency_trace_set_air(latency_trace_t *trace, bool valid, uint64_t rx_time_ns);
+
+/**
+ * @brief Add a completed trace (LATENCY_MARK_SINK set) to the histograms
+ *
+ * @param trace Frame trace
+ */
+void latency_trace_record(const latency_trace_t *trace);
+
+/**
+ * @brief Hold a trace until the link has drained past its record
+ *
+ * The sink mark is taken by latency_trace_drained(). If too many records
+ * are outstanding the oldest is dropped.
+ *
+ * @param trace Frame trace, marked up to LATENCY_MARK_SERIALIZE
+ * @param end Link byte count at which the record has been fully drained
+ */
+void latency_trace_defer(const latency_trace_t *trace, uint32_t end);
+
+/**
+ * @brief Complete held traces whose records the link has drained
+ *
+ * Called from the CDC ACM interrupt.
+ *
+ * @param drained Total bytes taken by the driver since boot
+ */
+void latency_trace_drained(uint32_t drained);
+
+/**
+ * @brief Serialize per-stage p50/p99/max into one JSON record
+ *
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @return Record length, or -ENOMEM if it did not fit
+ */
+int latency_trace_format(char *buf, size_t size);
+
+/**
+ * @brief Get one percentile of a stage
+ *
+ * @param stage Stage
+ * @param permille Share of samples at or below the result (500 for p50)
+ * @return Duration (us), within 25% of the true value; 0 without samples
+ */
+uint32_t latency_trace_percentile(latency_stage_t stage, uint32_t permille);
+
+/**
+ * @brief Clear all histograms
+ */
+void latency_trace_reset(void);
+
+#else
+
+#define LATENCY_TRACE_MARK(trace, mark) do { } while (0)
+#define LATENCY_TRACE_AIR(trace, valid, rx_time_ns) do { } while (0)
+
+#endif /* CONFIG_UWB_LATENCY_TRACE */
+
+#endif /* LATENCY_TRACE_H */
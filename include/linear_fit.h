@@ -0,0 +1,77 @@
+/**
+ * @file linear_fit.h
+ * @brief Incremental exponentially weighted least-squares line fit
+ */
+
+#ifndef LINEAR_FIT_H
+#define LINEAR_FIT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Fit state for y = y0 + a + b * (x - x0)
+ *
+ * The origin (x0, y0) follows the newest sample so the running sums stay
+ * small enough for double precision even when x and y are large 64-bit
+ * counters. Adding a sample and evaluating the line are both O(1).
+ */
+typedef struct {
+    uint32_t count;
+    double forget;      /* Per-sample weight decay (0 < forget <= 1) */
+    int64_t x0;         /* Newest sample (fit origin) */
+    int64_t y0;
+    double sw, st, sd, stt, std;
+    double a;           /* Intercept relative to the origin */
+    double b;           /* Slope */
+} linear_fit_t;
+
+/**
+ * @brief Initialize or reset a fit
+ *
+ * @param fit Fit state
+ * @param forget Per-sample weight decay
+ */
+void linear_fit_init(linear_fit_t *fit, double forget);
+
+/**
+ * @brief Add a sample
+ *
+ * @param fit Fit state
+ * @param x Sample abscissa
+ * @param y Sample ordinate
+ */
+void linear_fit_add(linear_fit_t *fit, int64_t x, int64_t y);
+
+/**
+ * @brief Evaluate the fitted line
+ *
+ * @param fit Fit state (at least one sample)
+ * @param x Abscissa
+ * @return Fitted y at @p x
+ */
+int64_t linear_fit_eval(const linear_fit_t *fit, int64_t x);
+
+/**
+ * @brief Residual of a point against the fitted line
+ *
+ * @param fit Fit state (at least one sample)
+ * @param x Abscissa
+ * @param y Ordinate
+ * @return y minus the fitted value at x
+ */
+double linear_fit_residual(const linear_fit_t *fit, int64_t x, int64_t y);
+
+/**
+ * @brief Move the fitted line so it passes through a point
+ *
+ * Keeps the slope and the sample history, for an ordinate that jumped by
+ * a constant (e.g. a counter that restarted) while its rate stayed the
+ * same.
+ *
+ * @param fit Fit state (at least one sample)
+ * @param x Abscissa
+ * @param y Ordinate the line must pass through at @p x
+ */
+void linear_fit_rebase(linear_fit_t *fit, int64_t x, int64_t y);
+
+#endif /* LINEAR_FIT_H */
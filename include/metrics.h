@@ -0,0 +1,166 @@
+/**
+ * @file metrics.h
+ * @brief Statically registered counters, gauges and histograms
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/iterable_sections.h>
+
+/* Histogram bucket i holds samples in [2^(i-1), 2^i), bucket 0 holds 0 */
+#define METRIC_HIST_BUCKETS 24
+
+/*
+ * Buckets of a histogram that splits every power of two into
+ * 2^sub_bits: samples below 2^sub_bits map one to one, then each
+ * log2 bucket from there on is divided evenly
+ */
+#define METRIC_HIST_SIZE(_sub_bits) \
+    ((unsigned int)(METRIC_HIST_BUCKETS - (_sub_bits)) << (_sub_bits))
+
+typedef enum {
+    METRIC_COUNTER,            /* Monotonic total */
+    METRIC_GAUGE,              /* Last set value */
+    METRIC_HISTOGRAM,          /* Log2 or log-linear bucketed distribution */
+} metric_type_t;
+
+/**
+ * @brief One registered metric
+ *
+ * Defined with the METRIC_*_DEFINE macros; all metrics are collected in
+ * an iterable section and found by the serializer without registration
+ * calls. Updates are single atomic operations, safe from any thread or
+ * ISR.
+ */
+struct metric {
+    const char *name;
+    metric_type_t type;
+    atomic_t value;            /* Counter total, gauge value or sample count */
+    atomic_t sum;              /* Histogram: sum of samples */
+    atomic_t max;              /* Histogram: largest sample */
+    atomic_t *buckets;         /* Histogram: METRIC_HIST_SIZE(sub_bits) buckets */
+    uint8_t sub_bits;          /* Histogram: log2 of the buckets per power of two */
+};
+
+#define METRIC_COUNTER_DEFINE(_name) \
+    STRUCT_SECTION_ITERABLE(metric, _name) = { \
+        .name = #_name, .type = METRIC_COUNTER, \
+    }
+
+#define METRIC_GAUGE_DEFINE(_name) \
+    STRUCT_SECTION_ITERABLE(metric, _name) = { \
+        .name = #_name, .type = METRIC_GAUGE, \
+    }
+
+#define METRIC_HISTOGRAM_DEFINE(_name) METRIC_HISTOGRAM_SUB_DEFINE(_name, 0)
+
+/* Histogram with 2^_sub_bits buckets per power of two, for percentiles
+ * within 1/2^_sub_bits of the true value
+ */
+#define METRIC_HISTOGRAM_SUB_DEFINE(_name, _sub_bits) \
+    static atomic_t _name##_buckets[METRIC_HIST_SIZE(_sub_bits)]; \
+    STRUCT_SECTION_ITERABLE(metric, _name) = { \
+        .name = #_name, .type = METRIC_HISTOGRAM, .buckets = _name##_buckets, \
+        .sub_bits = (_sub_bits), \
+    }
+
+/* Use a metric defined in another file */
+#define METRIC_DECLARE(_name) extern struct metric _name
+
+static inline void metric_add(struct metric *m, uint32_t n)
+{
+    atomic_add(&m->value, (atomic_val_t)n);
+}
+
+static inline void metric_inc(struct metric *m)
+{
+    atomic_inc(&m->value);
+}
+
+static inline void metric_set(struct metric *m, int32_t value)
+{
+    atomic_set(&m->value, value);
+}
+
+/* Histogram bucket a sample falls into */
+static inline unsigned int metric_bucket(const struct metric *m, uint32_t sample)
+{
+    unsigned int sub_bits = m->sub_bits;
+
+    if (sample < (1U << sub_bits)) {
+        return sample;
+    }
+
+    unsigned int log2 = 31 - __builtin_clz(sample);
+    if (log2 >= METRIC_HIST_BUCKETS - 1) {
+        return METRIC_HIST_SIZE(sub_bits) - 1;
+    }
+
+    return ((log2 - sub_bits + 1) << sub_bits) +
+           ((sample >> (log2 - sub_bits)) & ((1U << sub_bits) - 1));
+}
+
+static inline void metric_observe(struct metric *m, uint32_t sample)
+{
+    atomic_val_t max;
+
+    atomic_inc(&m->buckets[metric_bucket(m, sample)]);
+    atomic_add(&m->sum, (atomic_val_t)sample);
+    atomic_inc(&m->value);
+
+    do {
+        max = atomic_get(&m->max);
+        if ((uint32_t)max >= sample) {
+            break;
+        }
+    } while (!atomic_cas(&m->max, max, (atomic_val_t)sample));
+}
+
+static inline uint32_t metric_get(const struct metric *m)
+{
+    return (uint32_t)atomic_get((atomic_t *)&m->value);
+}
+
+/**
+ * @brief Get one percentile of a histogram
+ *
+ * @param m Histogram
+ * @param permille Share of samples at or below the result (500 for p50)
+ * @return Upper bound of the bucket holding that sample, capped at the
+ *         largest sample; 0 without samples
+ */
+uint32_t metric_percentile(const struct metric *m, uint32_t permille);
+
+/**
+ * @brief Largest sample seen by a histogram
+ */
+static inline uint32_t metric_max(const struct metric *m)
+{
+    return (uint32_t)atomic_get((atomic_t *)&m->max);
+}
+
+/**
+ * @brief Clear a metric, including the buckets of a histogram
+ */
+void metric_reset(struct metric *m);
+
+/**
+ * @brief Serialize all metrics into one JSON record
+ *
+ * Counters and gauges map to their value, histograms to
+ * [count, sum, bucket0, ...] with trailing empty buckets trimmed.
+ * Log-linear histograms are folded into log2 buckets, so every
+ * histogram reads the same.
+ *
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @return Record length including the line ending, or -ENOMEM if it did
+ *         not fit
+ */
+int metrics_format(char *buf, size_t size);
+
+#endif /* METRICS_H */
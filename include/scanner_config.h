@@ -0,0 +1,136 @@
+/**
+ * @file scanner_config.h
+ * @brief Versioned runtime configuration of the scanner
+ */
+
+#ifndef SCANNER_CONFIG_H
+#define SCANNER_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dw3000_driver.h"
+
+/* output_mode value letting the link monitor pick the fidelity */
+#define SCANNER_CONFIG_OUTPUT_AUTO  (-1)
+
+/**
+ * @brief Scanner power profiles
+ */
+typedef enum {
+    SCANNER_POWER_FULL = 0,    /* Receiver fully on while listening */
+    SCANNER_POWER_SNIFF,       /* Receiver duty cycled until preamble is detected */
+    SCANNER_POWER_COUNT,
+} scanner_power_profile_t;
+
+/**
+ * @brief One configuration snapshot
+ */
+typedef struct {
+    uint32_t version;          /* Incremented on every update */
+    dw3000_config_t radio;     /* Radio configuration */
+    uint32_t rx_window_ms;     /* Receive window per scan cycle */
+    uint32_t sleep_ms;         /* DW3000 DEEPSLEEP between cycles, 0 stays awake */
+    uint8_t power_profile;     /* scanner_power_profile_t, sets the radio sniff fields */
+    float min_rssi_dbm;        /* Weaker sightings are not reported */
+    uint8_t min_frame_quality; /* Lower quality sightings are not reported */
+    int8_t output_mode;        /* Fixed uart_output_mode_t or SCANNER_CONFIG_OUTPUT_AUTO */
+    uint8_t allow_count;       /* Entries in allow_list, 0 reports every device */
+    uint64_t allow_list[CONFIG_UWB_ALLOW_LIST_SIZE]; /* Only these devices are reported */
+} scanner_config_t;
+
+/**
+ * @brief Initialize the configuration service
+ *
+ * @param initial Initial configuration, NULL for the built-in defaults
+ * @return 0 on success, negative error code otherwise
+ */
+int scanner_config_init(const scanner_config_t *initial);
+
+/**
+ * @brief Get the current snapshot for reading
+ *
+ * The snapshot stays valid and unchanged until released, even if a new
+ * configuration is published meanwhile. Hold it for at most one scan
+ * cycle; writers wait for it.
+ *
+ * @return Current configuration snapshot
+ */
+const scanner_config_t *scanner_config_acquire(void);
+
+/**
+ * @brief Release a snapshot returned by scanner_config_acquire()
+ *
+ * @param config Snapshot to release
+ */
+void scanner_config_release(const scanner_config_t *config);
+
+/**
+ * @brief Copy the current configuration
+ *
+ * @param config Filled with the current configuration
+ */
+void scanner_config_get(scanner_config_t *config);
+
+/**
+ * @brief Check a configuration for valid values
+ *
+ * @param config Configuration to check
+ * @return 0 if valid, -EINVAL otherwise
+ */
+int scanner_config_validate(const scanner_config_t *config);
+
+/**
+ * @brief Check a device against the allow-list
+ *
+ * @param config Configuration snapshot
+ * @param device_addr Device address
+ * @return true if the device may be reported
+ */
+bool scanner_config_allows(const scanner_config_t *config, uint64_t device_addr);
+
+/**
+ * @brief Publish a new configuration
+ *
+ * The version field of @p config is ignored and assigned here. The
+ * scanner thread picks the new snapshot up at the start of its next
+ * scan cycle.
+ *
+ * @param config New configuration
+ * @return New version number on success, negative error code otherwise
+ */
+int scanner_config_update(const scanner_config_t *config);
+
+/**
+ * @brief Convert a preamble length code to symbols
+ *
+ * @param code DW3000_PLEN_* code
+ * @return Preamble length in symbols, 0 for an unknown code
+ */
+uint16_t scanner_config_plen_symbols(uint8_t code);
+
+/**
+ * @brief Convert a preamble length in symbols to its code
+ *
+ * @param symbols Preamble length in symbols
+ * @return DW3000_PLEN_* code, or -EINVAL if unsupported
+ */
+int scanner_config_plen_code(uint32_t symbols);
+
+/**
+ * @brief Get the name of a power profile
+ *
+ * @param profile scanner_power_profile_t value
+ * @return Profile name
+ */
+const char *scanner_config_power_name(uint8_t profile);
+
+/**
+ * @brief Look up a power profile by name
+ *
+ * @param name Profile name
+ * @return scanner_power_profile_t value, or -EINVAL if unknown
+ */
+int scanner_config_power_parse(const char *name);
+
+#endif /* SCANNER_CONFIG_H */
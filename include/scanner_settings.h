@@ -0,0 +1,54 @@
+/**
+ * @file scanner_settings.h
+ * @brief Persisted scanner settings for warm boot
+ */
+
+#ifndef SCANNER_SETTINGS_H
+#define SCANNER_SETTINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "scanner_config.h"
+
+/**
+ * @brief Initialize the settings subsystem and load stored settings
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int scanner_settings_init(void);
+
+/**
+ * @brief Get the stored scanner configuration
+ *
+ * @param config Filled with the stored configuration
+ * @return true if a valid configuration was stored
+ */
+bool scanner_settings_get_config(scanner_config_t *config);
+
+/**
+ * @brief Get the last SPI clock the DW3000 was verified at
+ *
+ * @return SPI clock in Hz, 0 if none is stored
+ */
+uint32_t scanner_settings_get_spi_hz(void);
+
+/**
+ * @brief Store the scanner configuration
+ *
+ * @param config Configuration to store
+ * @return 0 on success, negative error code otherwise
+ */
+int scanner_settings_save_config(const scanner_config_t *config);
+
+/**
+ * @brief Store the last good SPI clock
+ *
+ * Does not touch flash if the value is already stored.
+ *
+ * @param spi_hz SPI clock in Hz
+ * @return 0 on success, negative error code otherwise
+ */
+int scanner_settings_save_spi_hz(uint32_t spi_hz);
+
+#endif /* SCANNER_SETTINGS_H */
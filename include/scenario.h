@@ -0,0 +1,192 @@
+/**
+ * @file scenario.h
+ * @brief Deterministic synthetic RF scenarios
+ *
+ * A scenario is a set of tag groups, each with a blink schedule, address
+ * and frame type and a distance from the scanner. The engine turns it into
+ * the time-ordered sequence of frames the receiver would see: on-air
+ * arrival, airtime, RX timestamp and received power from a log-distance
+ * path loss model. Overlapping frames collide; the stronger one survives
+ * if it is SCENARIO_CAPTURE_DB (or the scenario's "capture") above the
+ * other, otherwise the receiver sees a corrupted frame.
+ *
+ * The same seed and scenario always give the same frames. No Zephyr
+ * dependency: used by the DW3000 emulator and by tools/scenario_dump.c.
+ *
+ * Scenario files are text, one directive per line, '#' starts a comment:
+ *
+ *   seed 42
+ *   capture 6
+ *   group count=200 interval=1000 jitter=10 addr=extended type=blink distance=2-40
+ *   group count=4 interval=20 arrivals=poisson type=data distance=3 fade=4
+ *
+ * Group keys: count, interval (ms per tag), jitter (percent of interval,
+ * up to 90, periodic only), arrivals (periodic|poisson), addr (short|extended),
+ * type (data|blink|beacon|ack), distance (m, or min-max drawn per tag),
+ * tx (dBm), fade (dB, uniform per frame), payload (bytes), pan (PAN ID).
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SCENARIO_MAX_GROUPS     8
+#define SCENARIO_FRAME_MAX      127
+#define SCENARIO_CAPTURE_DB     6.0f
+
+/**
+ * @brief Frame shapes
+ */
+typedef enum {
+    SCENARIO_TYPE_DATA = 0,    /* Data, broadcast short destination, PAN ID compressed */
+    SCENARIO_TYPE_BLINK,       /* Data, no destination, source with PAN ID */
+    SCENARIO_TYPE_BEACON,      /* Beacon, no destination */
+    SCENARIO_TYPE_ACK,         /* Acknowledgement, no addresses */
+} scenario_type_t;
+
+/**
+ * @brief Tag group
+ */
+typedef struct {
+    uint16_t count;            /* Tags in the group */
+    uint64_t interval_ns;      /* Mean blink interval per tag */
+    uint8_t jitter_pct;        /* Periodic blinks: uniform +/- share of the interval */
+    bool poisson;              /* Exponential intervals instead of periodic */
+    uint8_t addr_mode;         /* IEEE154_ADDR_SHORT or IEEE154_ADDR_EXTENDED */
+    scenario_type_t type;
+    float distance_min_m;      /* Drawn uniformly per tag */
+    float distance_max_m;
+    float tx_dbm;
+    float fade_db;             /* Drawn uniformly per frame */
+    uint8_t payload;           /* MAC payload bytes */
+    uint16_t pan_id;
+} scenario_group_t;
+
+/**
+ * @brief Per-tag state
+ */
+typedef struct {
+    uint64_t next_ns;          /* Next blink on air */
+    uint64_t addr;
+    float distance_m;
+    uint8_t group;
+    uint8_t seq;
+} scenario_tag_t;
+
+/**
+ * @brief A frame as the receiver sees it
+ */
+typedef struct {
+    uint64_t at_ns;            /* Start of the preamble */
+    uint64_t rmarker_ns;       /* RX timestamp point (end of SFD) */
+    uint32_t airtime_ns;       /* Until the last bit */
+    float rssi_dbm;
+    float fp_level_db;         /* First path amplitude, 10 * log10 */
+    uint16_t fp_index;         /* First path index in the CIR */
+    uint8_t quality;           /* Frame quality indicator */
+    uint16_t tag;
+    bool corrupt;              /* Collision the receiver could not resolve */
+    uint16_t length;           /* Including the FCS */
+    uint8_t data[SCENARIO_FRAME_MAX];
+} scenario_frame_t;
+
+/**
+ * @brief Counters since scenario_start()
+ */
+typedef struct {
+    uint32_t generated;        /* Frames put on air */
+    uint32_t delivered;        /* Frames returned intact */
+    uint32_t corrupted;        /* Corrupted frames returned */
+    uint32_t collided;         /* Frames lost to collisions */
+} scenario_stats_t;
+
+/**
+ * @brief Scenario state
+ */
+typedef struct {
+    scenario_group_t groups[SCENARIO_MAX_GROUPS];
+    uint8_t group_count;
+    scenario_tag_t *tags;
+    uint16_t tag_count;
+    uint16_t max_tags;
+    uint64_t seed;
+    uint64_t rng;
+    float capture_db;
+    scenario_frame_t ahead;    /* Next frame on air, not yet resolved */
+    bool have_ahead;
+    scenario_stats_t stats;
+} scenario_t;
+
+/**
+ * @brief Initialize an empty scenario
+ *
+ * @param sc Scenario
+ * @param tags Tag storage
+ * @param max_tags Capacity of the tag storage
+ * @param seed Random seed, replaced by a "seed" directive
+ */
+void scenario_init(scenario_t *sc, scenario_tag_t *tags, uint16_t max_tags, uint64_t seed);
+
+/**
+ * @brief Defaults for a group: one extended-address data tag at 10 m, 1 blink/s
+ *
+ * @param group Filled with the defaults
+ */
+void scenario_group_defaults(scenario_group_t *group);
+
+/**
+ * @brief Add a tag group
+ *
+ * @param sc Scenario
+ * @param group Group description
+ * @return 0 on success, -EINVAL for an invalid group, -ENOMEM if the groups
+ *         or tags do not fit
+ */
+int scenario_add_group(scenario_t *sc, const scenario_group_t *group);
+
+/**
+ * @brief Add the directives of a scenario file
+ *
+ * @param sc Scenario
+ * @param text File contents, need not be NUL terminated
+ * @param len Length of text
+ * @param err_line Set to the failing line number on error, may be NULL
+ * @return 0 on success, negative errno on error
+ */
+int scenario_parse(scenario_t *sc, const char *text, size_t len, unsigned int *err_line);
+
+/**
+ * @brief Draw tag addresses, distances and first blinks
+ *
+ * Restarts the frame sequence and clears the counters.
+ *
+ * @param sc Scenario
+ * @param start_ns Time of the first possible blink
+ */
+void scenario_start(scenario_t *sc, uint64_t start_ns);
+
+/**
+ * @brief Get the next frame the receiver sees
+ *
+ * @param sc Scenario
+ * @param frame Filled with the frame
+ * @return false if the scenario has no tags
+ */
+bool scenario_next(scenario_t *sc, scenario_frame_t *frame);
+
+/**
+ * @brief Set a frame's RX timestamp point and airtime from its start and length
+ *
+ * @param frame Frame with at_ns and length set
+ */
+void scenario_frame_timing(scenario_frame_t *frame);
+
+/**
+ * @brief Nominal frame rate over all tags (frames/s)
+ */
+float scenario_rate(const scenario_t *sc);
+
+#endif /* SCENARIO_H */
@@ -0,0 +1,70 @@
+/**
+ * @file sighting_journal.h
+ * @brief Buffer for sightings recorded while no host is connected
+ */
+
+#ifndef SIGHTING_JOURNAL_H
+#define SIGHTING_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "uwb_scanner.h"
+
+/**
+ * @brief Journal occupancy and loss counters
+ */
+typedef struct {
+    uint32_t pending;          /* Records waiting to be flushed */
+    uint32_t capacity;         /* RAM plus flash capacity in records */
+    uint32_t dropped;          /* Records overwritten since the last report */
+    uint32_t dropped_total;    /* Records overwritten since boot */
+    uint32_t flushed_total;    /* Records handed back for output since boot */
+} journal_stats_t;
+
+/**
+ * @brief Initialize the journal
+ *
+ * The RAM ring is always available. With CONFIG_UWB_JOURNAL_FLASH the
+ * journal partition is used as an overflow area; failing to open it is
+ * not fatal.
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int journal_init(void);
+
+/**
+ * @brief Store a sighting
+ *
+ * When the journal is full the oldest record is overwritten and counted
+ * as dropped.
+ *
+ * @param info Sighting to store
+ */
+void journal_append(const uwb_device_info_t *info);
+
+/**
+ * @brief Remove the oldest sighting
+ *
+ * @param info Filled with the oldest stored sighting
+ * @return true if a sighting was returned, false if the journal is empty
+ */
+bool journal_pop(uwb_device_info_t *info);
+
+/**
+ * @brief Move older records from RAM to flash
+ *
+ * Called from a low-priority thread so flash erases never stall the
+ * scanner. Does nothing without CONFIG_UWB_JOURNAL_FLASH.
+ */
+void journal_maintain(void);
+
+/**
+ * @brief Get journal counters
+ *
+ * @param stats Filled with the current counters
+ * @param reset_dropped Clear the dropped-since-last-report counter
+ */
+void journal_get_stats(journal_stats_t *stats, bool reset_dropped);
+
+#endif /* SIGHTING_JOURNAL_H */
@@ -0,0 +1,89 @@
+/**
+ * @file spi_fault.h
+ * @brief Fault injection on the DW3000 SPI path
+ *
+ * Sits between the driver and spi_transceive(). While a fault is armed,
+ * each transfer is hit with the given probability by one fault class.
+ * Draws come from a fixed-seed generator restarted on every
+ * spi_fault_start(), so a run repeats exactly against the emulator.
+ * With CONFIG_UWB_SPI_FAULT off the hook is a plain spi_transceive().
+ */
+
+#ifndef SPI_FAULT_H
+#define SPI_FAULT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Fault classes
+ */
+typedef enum {
+    SPI_FAULT_NONE = 0,
+    SPI_FAULT_ERROR,           /* Transfer fails with -EIO, nothing clocked */
+    SPI_FAULT_BITFLIP,         /* One bit of the read data (not the header echo) inverted */
+    SPI_FAULT_STUCK,           /* MISO stuck high, every byte read is 0xFF */
+    SPI_FAULT_DELAY,           /* Completes CONFIG_UWB_SPI_FAULT_DELAY_US late */
+    SPI_FAULT_COUNT,
+} spi_fault_class_t;
+
+#ifdef CONFIG_UWB_SPI_FAULT
+
+#include <zephyr/drivers/spi.h>
+
+#define SPI_FAULT_TRANSCEIVE(dev, cfg, tx, rx) spi_fault_transceive((dev), (cfg), (tx), (rx))
+
+/**
+ * @brief spi_transceive() with the armed fault applied
+ */
+int spi_fault_transceive(const struct device *dev, const struct spi_config *config,
+                         const struct spi_buf_set *tx, const struct spi_buf_set *rx);
+
+/**
+ * @brief Arm a fault
+ *
+ * @param fault Fault class, SPI_FAULT_NONE disarms
+ * @param permille Share of transfers hit, 1 to 1000
+ * @param duration_ms Disarm after this long, 0 to stay armed until stopped
+ * @return 0 on success, -EINVAL for an invalid class or probability
+ */
+int spi_fault_start(spi_fault_class_t fault, uint16_t permille, uint32_t duration_ms);
+
+/**
+ * @brief Disarm the fault
+ */
+void spi_fault_stop(void);
+
+/**
+ * @brief Fault class currently armed (SPI_FAULT_NONE once the duration ran out)
+ */
+spi_fault_class_t spi_fault_active(void);
+
+/**
+ * @brief Transfers hit since boot, per class
+ *
+ * @param fault Fault class
+ */
+uint32_t spi_fault_injected(spi_fault_class_t fault);
+
+/**
+ * @brief Name of a fault class ("error", "bitflip", "stuck", "delay")
+ */
+const char *spi_fault_name(spi_fault_class_t fault);
+
+/**
+ * @brief Fault class by name
+ *
+ * @param name Name, need not be NUL terminated
+ * @param len Length of the name
+ * @return Fault class, or SPI_FAULT_NONE if the name is unknown
+ */
+spi_fault_class_t spi_fault_parse(const char *name, size_t len);
+
+#else
+
+#define SPI_FAULT_TRANSCEIVE(dev, cfg, tx, rx) spi_transceive((dev), (cfg), (tx), (rx))
+
+#endif /* CONFIG_UWB_SPI_FAULT */
+
+#endif /* SPI_FAULT_H */
@@ -0,0 +1,94 @@
+/**
+ * @file spi_profile.h
+ * @brief DW3000 SPI transaction profiler
+ *
+ * Keeps per-register (per direction) and per-fast-command tables of
+ * transaction count, bytes, bus time and errors. With
+ * CONFIG_UWB_SPI_PROFILE off the hooks compile away.
+ */
+
+#ifndef SPI_PROFILE_H
+#define SPI_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Table keys: driver register address, direction and fast command flags */
+#define SPI_PROFILE_WRITE       0x4000
+#define SPI_PROFILE_FAST_CMD    0x8000
+#define SPI_PROFILE_REG(reg, write) ((uint16_t)((reg) | ((write) ? SPI_PROFILE_WRITE : 0)))
+#define SPI_PROFILE_CMD(cmd)    ((uint16_t)(SPI_PROFILE_FAST_CMD | (cmd)))
+
+/**
+ * @brief Accumulated traffic for one register, direction or fast command
+ */
+typedef struct {
+    uint16_t key;              /* SPI_PROFILE_REG() or SPI_PROFILE_CMD() */
+    uint32_t count;            /* Transactions */
+    uint32_t bytes;            /* Bytes on the bus, headers included */
+    uint64_t bus_ns;           /* Time spent in spi_transceive() */
+    uint32_t errors;           /* Failed transactions */
+} spi_profile_entry_t;
+
+#ifdef CONFIG_UWB_SPI_PROFILE
+
+#include <zephyr/timing/timing.h>
+
+#define SPI_PROFILE_BEGIN(start) timing_t start = timing_counter_get()
+#define SPI_PROFILE_END(start, key, bytes, ret) \
+    spi_profile_record((key), (bytes), (start), (ret))
+
+/**
+ * @brief Start the cycle counter used for bus time
+ */
+void spi_profile_init(void);
+
+/**
+ * @brief Account one finished transaction
+ *
+ * @param key Table key
+ * @param bytes Bytes clocked, header included
+ * @param start Cycle counter before the transfer
+ * @param ret Transfer result
+ */
+void spi_profile_record(uint16_t key, uint32_t bytes, timing_t start, int ret);
+
+/**
+ * @brief Copy one table slot
+ *
+ * @param index Slot, 0 to CONFIG_UWB_SPI_PROFILE_SLOTS - 1
+ * @param entry Filled with the slot contents
+ * @return true if the slot is in use
+ */
+bool spi_profile_get(unsigned int index, spi_profile_entry_t *entry);
+
+/**
+ * @brief Sum of all slots
+ *
+ * @param total Filled with the totals (key unused)
+ * @param untracked Filled with transactions that found no free slot
+ * @return Milliseconds since the tables were last cleared
+ */
+uint32_t spi_profile_totals(spi_profile_entry_t *total, uint32_t *untracked);
+
+/**
+ * @brief Name of the register or fast command behind a key
+ *
+ * @param key Table key
+ * @return Register name, or NULL if the driver has no name for it
+ */
+const char *spi_profile_name(uint16_t key);
+
+/**
+ * @brief Clear all tables
+ */
+void spi_profile_reset(void);
+
+#else
+
+#define SPI_PROFILE_BEGIN(start)
+#define SPI_PROFILE_END(start, key, bytes, ret) do { } while (0)
+
+#endif /* CONFIG_UWB_SPI_PROFILE */
+
+#endif /* SPI_PROFILE_H */
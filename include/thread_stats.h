@@ -0,0 +1,24 @@
+/**
+ * @file thread_stats.h
+ * @brief Per-thread CPU usage and stack high-water marks
+ */
+
+#ifndef THREAD_STATS_H
+#define THREAD_STATS_H
+
+#include <stddef.h>
+
+/**
+ * @brief Serialize per-thread CPU share and stack use into one JSON record
+ *
+ * CPU share covers the time since the previous call (since boot on the
+ * first). Stack use is the high-water mark from the thread analyzer.
+ * Not reentrant; callers serialize.
+ *
+ * @param buf Output buffer
+ * @param size Buffer size
+ * @return Record length, or -ENOMEM if it did not fit
+ */
+int thread_stats_format(char *buf, size_t size);
+
+#endif /* THREAD_STATS_H */
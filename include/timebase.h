@@ -0,0 +1,56 @@
+/**
+ * @file timebase.h
+ * @brief Unified 64-bit timebase relating DW3000 device time to uptime
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Initialize the timebase
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int timebase_init(void);
+
+/**
+ * @brief Sample both clocks if a sample is due
+ *
+ * Must be called regularly (well within the ~17.2 s DW3000 counter wrap)
+ * from the thread that owns the radio.
+ *
+ * @return 0 on success or nothing to do, negative error code otherwise
+ */
+int timebase_poll(void);
+
+/**
+ * @brief Re-anchor the timebase after the device clock restarted
+ *
+ * Call after waking the DW3000 from sleep. The measured drift is kept and
+ * a single sample fixes the new offset, so conversions stay valid without
+ * waiting for a fresh fit.
+ *
+ * @return 0 on success, negative error code otherwise
+ */
+int timebase_resync(void);
+
+/**
+ * @brief Convert a 40-bit DW3000 timestamp into uptime nanoseconds
+ *
+ * @param dw_time 40-bit device timestamp (e.g. an RX timestamp)
+ * @param uptime_ns Filled with the corresponding uptime in nanoseconds
+ * @return true if the timebase is locked and @p uptime_ns is valid
+ */
+bool timebase_dw_to_ns(uint64_t dw_time, uint64_t *uptime_ns);
+
+/**
+ * @brief Get the measured DW3000 clock drift against the system clock
+ *
+ * @return Drift in parts per million (0 until locked)
+ */
+float timebase_get_drift_ppm(void);
+
+#endif /* TIMEBASE_H */
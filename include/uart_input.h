@@ -0,0 +1,36 @@
+/**
+ * @file uart_input.h
+ * @brief Line-based host input over the USB CDC ACM link
+ */
+
+#ifndef UART_INPUT_H
+#define UART_INPUT_H
+
+#include <stdint.h>
+
+#include "uart_output.h"
+
+/* Maximum length of one input line (excluding terminator) */
+#define UART_INPUT_LINE_MAX 127
+
+/**
+ * @brief Callback for a complete line received from the host
+ *
+ * Runs in the system work queue, not in interrupt context.
+ *
+ * @param line NUL-terminated line without CR/LF
+ * @param rx_time_us Uptime in microseconds when the line terminator arrived
+ * @param channel Interface the line arrived on
+ */
+typedef void (*uart_input_line_handler_t)(const char *line, uint64_t rx_time_us,
+                                          uart_channel_t channel);
+
+/**
+ * @brief Initialize host input
+ *
+ * @param handler Function to call for every received line
+ * @return 0 on success, negative error code otherwise
+ */
+int uart_input_init(uart_input_line_handler_t handler);
+
+#endif /* UART_INPUT_H */
@@ -6,8 +6,41 @@
 #ifndef UART_OUTPUT_H
 #define UART_OUTPUT_H
 
+#include <zephyr/device.h>
+
 #include "uwb_scanner.h"
 
+/**
+ * @brief Host link interface
+ *
+ * Without a dedicated command interface in the devicetree both map onto
+ * the data interface.
+ */
+typedef enum {
+    UART_CHANNEL_DATA = 0,      /* Sighting stream, status records */
+    UART_CHANNEL_COMMAND,       /* Command replies */
+} uart_channel_t;
+
+/**
+ * @brief Fidelity of the sighting stream sent to the host
+ */
+typedef enum {
+    UART_OUTPUT_MODE_FULL = 0,  /* Every sighting */
+    UART_OUTPUT_MODE_THROTTLED, /* At most one sighting per device per interval */
+    UART_OUTPUT_MODE_SUMMARY,   /* Periodic per-device summaries only */
+    UART_OUTPUT_MODE_COUNT,
+} uart_output_mode_t;
+
+/**
+ * @brief Boot phase completion times, in microseconds since boot
+ */
+typedef struct {
+    uint32_t output_us;        /* Host output ready */
+    uint32_t radio_us;         /* DW3000 up and configured */
+    uint32_t scan_us;          /* Scanner thread started */
+    bool warm;                 /* Radio brought up from stored settings */
+} uart_output_boot_t;
+
 /**
  * @brief Initialize UART output
  *
@@ -36,4 +69,187 @@ void uart_output_status(const char *message);
  */
 void uart_output_error(const char *error_msg);
 
+/**
+ * @brief Output the startup status record with boot phase times
+ *
+ * If the host has not opened the data interface yet, the record is held
+ * and sent once it does.
+ *
+ * @param boot Boot phase times
+ */
+void uart_output_boot(const uart_output_boot_t *boot);
+
+/**
+ * @brief Output a host time sync response
+ *
+ * Answers an NTP-style sync request. The transmit timestamp is taken
+ * immediately before the response is written to the link.
+ *
+ * @param channel Interface the request arrived on
+ * @param t1_us Host transmit time echoed from the request
+ * @param t2_us Device uptime (us) when the request arrived
+ */
+void uart_output_sync_response(uart_channel_t channel, uint64_t t1_us, uint64_t t2_us);
+
+/**
+ * @brief Send the device table to the host
+ *
+ * Emits one "device" record per entry followed by "devices_end". The dump
+ * is paged out as the link drains, so large tables never stall callers.
+ *
+ * @param channel Interface to reply on
+ * @param max_age_ms Only include devices seen within this many ms, 0 for all
+ * @return 0 on success, -EBUSY if a dump is already in progress
+ */
+int uart_output_device_table(uart_channel_t channel, uint32_t max_age_ms);
+
+/**
+ * @brief Send one device table entry to the host
+ *
+ * @param channel Interface to reply on
+ * @param device_addr Device address
+ * @return 0 on success, -ENOENT if the device is not in the table
+ */
+int uart_output_device(uart_channel_t channel, uint64_t device_addr);
+
+/**
+ * @brief Send sighting, link and journal counters to the host
+ *
+ * @param channel Interface to reply on
+ */
+void uart_output_counters(uart_channel_t channel);
+
+/**
+ * @brief Send the current scanner configuration to the host
+ *
+ * @param channel Interface to reply on
+ */
+void uart_output_config(uart_channel_t channel);
+
+/**
+ * @brief Send a snapshot of all registered metrics to the host
+ *
+ * @param channel Interface to send on
+ */
+void uart_output_metrics(uart_channel_t channel);
+
+#ifdef CONFIG_UWB_THREAD_STATS
+/**
+ * @brief Send per-thread CPU share and stack use to the host
+ *
+ * CPU share covers the time since the previous thread record.
+ *
+ * @param channel Interface to send on
+ */
+void uart_output_threads(uart_channel_t channel);
+#endif
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+/**
+ * @brief Send per-stage frame latency percentiles to the host
+ *
+ * @param channel Interface to send on
+ * @param reset Clear the histograms after the snapshot
+ */
+void uart_output_latency(uart_channel_t channel, bool reset);
+#endif
+
+#ifdef CONFIG_UWB_SPI_PROFILE
+/**
+ * @brief Dump the SPI profiler tables
+ *
+ * Emits one "spi_reg" record per register, direction or fast command
+ * followed by "spi_end" with the totals.
+ *
+ * @param channel Interface to reply on
+ * @param reset Clear the tables after the dump
+ */
+void uart_output_spi_profile(uart_channel_t channel, bool reset);
+
+/**
+ * @brief Send SPI totals and the registers with the most bus time
+ *
+ * @param channel Interface to send on
+ */
+void uart_output_spi_summary(uart_channel_t channel);
+#endif
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+/**
+ * @brief Dump the flight recorder, oldest entry first
+ *
+ * Sends one "flight" record per entry and a "flight_end" record, paced
+ * by the link like the device table dump. The data channel dump is held
+ * until the host connects.
+ *
+ * @param channel Interface to send on
+ * @return 0 on success, -EBUSY if a dump is already running
+ */
+int uart_output_flight(uart_channel_t channel);
+
+/**
+ * @brief Write the flight recorder to the console from the fatal error handler
+ *
+ * Polls the UART directly without locking or scheduling.
+ */
+void uart_output_flight_panic(void);
+#endif
+
+/**
+ * @brief Enable or disable per-sighting streaming
+ *
+ * The device table keeps being updated while streaming is off.
+ *
+ * @param enable true to stream every sighting
+ */
+void uart_output_set_streaming(bool enable);
+
+/**
+ * @brief Check whether per-sighting streaming is enabled
+ *
+ * @return true if sightings are streamed
+ */
+bool uart_output_get_streaming(void);
+
+/**
+ * @brief Report whether the host is reading the console
+ *
+ * Builds without USB CDC ACM have no DTR line to watch, so the console
+ * is the host link and whoever owns it reports the host coming and going
+ * (the native_sim journal bench stands in for a PTY being opened and
+ * closed). The host starts out connected. Ignored with CDC ACM.
+ *
+ * @param connected true while the host is there
+ */
+void uart_output_set_host_connected(bool connected);
+
+/**
+ * @brief Send a command response to the host
+ *
+ * @param channel Interface to reply on
+ * @param cmd Command name
+ * @param status 0 on success, negative error code otherwise
+ * @param message Optional detail, NULL for none
+ */
+void uart_output_response(uart_channel_t channel, const char *cmd, int status,
+                          const char *message);
+
+/**
+ * @brief Get the current host output fidelity
+ *
+ * @return Current mode, fixed by the scanner configuration or chosen from
+ *         the measured link drain rate
+ */
+uart_output_mode_t uart_output_get_mode(void);
+
+/**
+ * @brief Feed queued output to the CDC ACM link
+ *
+ * Called from the CDC ACM interrupt callback when the driver can accept
+ * more data.
+ *
+ * @param dev CDC ACM device
+ */
+void uart_output_tx_isr(const struct device *dev);
+
 #endif /* UART_OUTPUT_H */
@@ -9,12 +9,16 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "scanner_config.h"
+#include "latency_trace.h"
+
 /**
  * @brief Structure containing information about a discovered UWB device
  */
 typedef struct {
     uint64_t device_addr;      /* EUI-64 address of the device */
     uint32_t timestamp_ms;     /* System timestamp when device was detected */
+    uint64_t timestamp_us;     /* Same timestamp in microseconds (no wrap) */
     float distance_cm;         /* Estimated distance in centimeters */
     float rssi_dbm;           /* Received signal strength in dBm */
     uint16_t fpp_index;       /* First path power index */
@@ -22,8 +26,31 @@ typedef struct {
     uint8_t channel;          /* UWB channel used */
     uint8_t prf;              /* Pulse repetition frequency (16 or 64 MHz) */
     uint8_t frame_quality;    /* Frame quality indicator (0-255) */
+    uint8_t seq_num;          /* IEEE 802.15.4 sequence number */
+    uint64_t rx_timestamp;    /* 40-bit local DW3000 RX timestamp */
+    bool rx_time_valid;       /* True if rx_time_ns is valid */
+    uint64_t rx_time_ns;      /* RX timestamp mapped to uptime in nanoseconds */
+    bool sync_valid;          /* True if sync_timestamp is valid */
+    uint64_t sync_timestamp;  /* RX timestamp in the shared sync timebase */
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    latency_trace_t trace;    /* Pipeline stamps, completed by the output */
+#endif
 } uwb_device_info_t;
 
+/**
+ * @brief Radio duty cycling statistics
+ */
+typedef struct {
+    uint32_t sleeps;           /* DEEPSLEEP periods so far */
+    uint32_t wake_us_last;     /* Wake to RX enabled, last wake */
+    uint32_t wake_us_max;      /* Wake to RX enabled, worst case */
+    uint16_t duty_permille;    /* Share of time the radio was awake */
+    uint16_t rx_duty_permille; /* Estimated receiver on-time share (sniff and sleep) */
+    uint8_t profile;           /* Power profile in effect */
+    uint32_t profile_frames[SCANNER_POWER_COUNT]; /* Frames received per profile */
+    uint32_t profile_ms[SCANNER_POWER_COUNT];     /* Time spent per profile */
+} uwb_scanner_power_stats_t;
+
 /**
  * @brief Callback function type for device discovery
  *
@@ -34,6 +61,11 @@ typedef void (*uwb_device_callback_t)(const uwb_device_info_t *info);
 /**
  * @brief Initialize the UWB scanner
  *
+ * Brings up and configures the DW3000. The configuration service must
+ * already hold the initial configuration (scanner_config_init()), and
+ * with CONFIG_UWB_SETTINGS the stored settings must be loaded
+ * (scanner_settings_init()) for the warm boot path.
+ *
  * @param callback Function to call when a device is discovered
  * @return 0 on success, negative error code otherwise
  */
@@ -60,4 +92,25 @@ int uwb_scanner_stop(void);
  */
 bool uwb_scanner_is_active(void);
 
+/**
+ * @brief Check whether the radio was brought up from stored settings
+ *
+ * @return true after a warm boot, false after the full discovery probe
+ */
+bool uwb_scanner_is_warm_boot(void);
+
+/**
+ * @brief Get the time of the first frame read since boot
+ *
+ * @return Microseconds since boot, 0 if no frame has been read yet
+ */
+uint32_t uwb_scanner_get_first_frame_us(void);
+
+/**
+ * @brief Get radio duty cycling statistics
+ *
+ * @param stats Filled with the statistics
+ */
+void uwb_scanner_get_power_stats(uwb_scanner_power_stats_t *stats);
+
 #endif /* UWB_SCANNER_H */
@@ -0,0 +1,26 @@
+/**
+ * @file uwb_trace.h
+ * @brief Scanner tracepoints for the Zephyr tracing subsystem
+ *
+ * Emitted as CTF named events (a name of up to 20 characters and two
+ * 32-bit arguments) next to the kernel's own thread and ISR events.
+ * Compiled out unless CONFIG_UWB_TRACE is set.
+ */
+
+#ifndef UWB_TRACE_H
+#define UWB_TRACE_H
+
+#ifdef CONFIG_UWB_TRACE
+
+#include <zephyr/tracing/tracing.h>
+
+#define UWB_TRACE(name, arg0, arg1) \
+    sys_trace_named_event((name), (uint32_t)(arg0), (uint32_t)(arg1))
+
+#else
+
+#define UWB_TRACE(name, arg0, arg1) do { } while (0)
+
+#endif /* CONFIG_UWB_TRACE */
+
+#endif /* UWB_TRACE_H */
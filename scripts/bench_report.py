@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+UWB Scanner Bench Report
+Reads the console output of a bench.conf run (the bench_baseline, bench
+and bench_end records) and prints the results table for TECHNICAL.md and
+CONFIG_UWB_BENCH_* budgets derived from it with headroom, as a Kconfig
+fragment for bench.conf or the Kconfig defaults.
+
+    build/zephyr/zephyr.exe | tee bench.log
+    scripts/bench_report.py bench.log
+"""
+
+import argparse
+import json
+import math
+import sys
+
+# Margin kept between a measured figure and its budget
+RATE_HEADROOM = 0.9         # Capture and cycle rate budgets: 90% of the worst step
+TIME_HEADROOM = 2.0         # Time budgets: twice the worst p99
+
+
+def read_records(lines):
+    """bench_baseline, bench steps and bench_end records, log lines skipped"""
+    baseline, steps, end = None, [], None
+    for line in lines:
+        start = line.find('{')
+        if start == -1:
+            continue
+        try:
+            rec = json.loads(line[start:])
+        except json.JSONDecodeError:
+            continue
+        kind = rec.get('type')
+        if kind == 'bench_baseline':
+            baseline = rec
+        elif kind == 'bench':
+            steps.append(rec)
+        elif kind == 'bench_end':
+            end = rec
+    return baseline, steps, end
+
+
+def cycle_permille(step, baseline):
+    """Scan cycles in a step against the quiet baseline rate"""
+    if not baseline or baseline['ms'] == 0 or baseline['cycles'] == 0 or step['ms'] == 0:
+        return None
+    expected = baseline['cycles'] * step['ms'] / baseline['ms']
+    return int(step['cycles'] * 1000 / expected)
+
+
+def step_name(step):
+    return step['source'] if step['rate'] == 0 else f"{step['rate']}/s"
+
+
+def print_table(baseline, steps, out):
+    if baseline:
+        print(f"Baseline: {baseline['cycles']} scan cycles in {baseline['ms']} ms "
+              f"without traffic.\n", file=out)
+    print('| Traffic | Received | Sightings | Capture ‰ | Cycles ‰ | Output B/s '
+          '| Processing p50/p99 (µs) | Latency p50/p99/max (µs) |', file=out)
+    print('|---|---|---|---|---|---|---|---|', file=out)
+    for s in steps:
+        received = s['received']
+        capture = s['sightings'] * 1000 // received if received else 0
+        cycles = cycle_permille(s, baseline)
+        print(f"| {step_name(s)} | {received} | {s['sightings']} | {capture} "
+              f"| {cycles if cycles is not None else '-'} | {s['out_bps']} "
+              f"| {s['process_us']['p50']}/{s['process_us']['p99']} "
+              f"| {s['latency_us']['p50']}/{s['latency_us']['p99']}/{s['latency_us']['max']} |",
+              file=out)
+
+
+def budgets(baseline, steps):
+    """CONFIG_UWB_BENCH_* values the measured run clears with headroom"""
+    captures = [s['sightings'] * 1000 / s['received'] for s in steps if s['received']]
+    cycles = [c for c in (cycle_permille(s, baseline) for s in steps) if c is not None]
+    latency = max(s['latency_us']['p99'] for s in steps)
+    process = max(s['process_us']['p99'] for s in steps)
+
+    result = {}
+    if captures:
+        result['CONFIG_UWB_BENCH_CAPTURE_PERMILLE'] = int(min(captures) * RATE_HEADROOM)
+    if cycles:
+        result['CONFIG_UWB_BENCH_CYCLE_PERMILLE'] = int(min(cycles) * RATE_HEADROOM)
+    result['CONFIG_UWB_BENCH_LATENCY_P99_MS'] = max(1, math.ceil(latency * TIME_HEADROOM / 1000))
+    result['CONFIG_UWB_BENCH_PROCESS_P99_US'] = max(100, math.ceil(process * TIME_HEADROOM / 100) * 100)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Summarize a bench.conf run')
+    parser.add_argument('log', nargs='?', help='Console output of the run (default: stdin)')
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log) as f:
+            baseline, steps, end = read_records(f)
+    else:
+        baseline, steps, end = read_records(sys.stdin)
+
+    if not steps:
+        print('No bench records found', file=sys.stderr)
+        return 1
+    if end is None:
+        print('Warning: no bench_end record, the run did not finish', file=sys.stderr)
+
+    print_table(baseline, steps, sys.stdout)
+    if end is not None:
+        print(f"\nVerdict: {end['steps']} steps, {end['failures']} failures")
+
+    print('\n# Budgets with headroom over this run')
+    for name, value in budgets(baseline, steps).items():
+        print(f'{name}={value}')
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
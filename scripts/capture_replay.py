@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+UWB Scanner Capture Replay
+Feeds recorded scanner sessions back through the firmware on native_sim
+(emulated DW3000, CONFIG_UWB_REPLAY) and compares the sightings it reports
+with the original ones
+
+  convert  capture -> replay trace (one frame per device_found record)
+  run      convert, play the trace through a native_sim build, then diff
+  diff     compare the device_found records of two captures
+
+With --check, run and diff exit with status 1 unless every sighting was
+matched, with none missing or extra.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+# Fields compared between matched sightings, with the difference that counts
+FIELDS = {
+    'rssi_dbm': 0.05,
+    'distance_cm': 1.0,
+    'fpp_index': 0,
+    'fpp_level': 0.05,
+    'frame_quality': 0,
+}
+
+
+def load_sightings(path):
+    """Load the device_found records of a capture (raw monitor output or JSON lines)"""
+    records = []
+    with open(path, 'r', errors='replace') as f:
+        for line in f:
+            start = line.find('{')
+            if start == -1:
+                continue
+            try:
+                record = json.loads(line[start:line.rfind('}') + 1])
+            except json.JSONDecodeError:
+                continue
+            if record.get('type') == 'device_found':
+                records.append(record)
+    return records
+
+
+def record_us(record):
+    if 'timestamp_us' in record:
+        return int(record['timestamp_us'])
+    return int(record.get('timestamp_ms', 0)) * 1000
+
+
+def convert(capture, trace):
+    """Write the replay trace for a capture; returns the number of frames"""
+    frames = sorted(load_sightings(capture), key=record_us)
+    with open(trace, 'w') as f:
+        f.write('# t_us device_addr seq rssi_dbm fpp_index fpp_level frame_quality\n')
+        for r in frames:
+            f.write(f"{record_us(r)} {r['device_addr']} {r.get('seq', 0)} "
+                    f"{r.get('rssi_dbm', -90.0):.2f} {r.get('fpp_index', 0)} "
+                    f"{r.get('fpp_level', 0.0):.2f} {r.get('frame_quality', 0)}\n")
+    return len(frames)
+
+
+def diff(original, replayed):
+    """Match sightings by device and sequence number, in order
+
+    Captures without sequence numbers on either side (older firmware)
+    are matched per device in order.
+    """
+    use_seq = all('seq' in r for r in original) and all('seq' in r for r in replayed)
+
+    def key(r):
+        return (r['device_addr'], r['seq'] if use_seq else 0)
+
+    pending = {}
+    for i, r in enumerate(original):
+        pending.setdefault(key(r), []).append(i)
+
+    matched = []
+    extra = 0
+    for r in replayed:
+        queue = pending.get(key(r))
+        if queue:
+            matched.append((original[queue.pop(0)], r))
+        else:
+            extra += 1
+
+    missing = {}
+    for (addr, _), queue in pending.items():
+        if queue:
+            missing[addr] = missing.get(addr, 0) + len(queue)
+
+    fields = {}
+    for name, tolerance in FIELDS.items():
+        deltas = [abs(float(b[name]) - float(a[name]))
+                  for a, b in matched if name in a and name in b]
+        fields[name] = {
+            'differ': sum(1 for d in deltas if d > tolerance),
+            'mean_abs': round(sum(deltas) / len(deltas), 3) if deltas else 0,
+            'max_abs': round(max(deltas), 3) if deltas else 0,
+        }
+
+    return {
+        'type': 'replay_diff',
+        'original': len(original),
+        'replayed': len(replayed),
+        'matched': len(matched),
+        'missing': sum(missing.values()),
+        'extra': extra,
+        'suppressed': [sum(r.get('suppressed', 0) for r in original),
+                       sum(r.get('suppressed', 0) for r in replayed)],
+        'fields': fields,
+        'missing_by_device': dict(sorted(missing.items(), key=lambda kv: -kv[1])[:10]),
+    }
+
+
+def print_report(report, as_json):
+    if as_json:
+        print(json.dumps(report))
+        return
+
+    print(f"Original sightings:  {report['original']}")
+    print(f"Replayed sightings:  {report['replayed']}")
+    print(f"Matched:             {report['matched']}")
+    print(f"Missing in replay:   {report['missing']}")
+    print(f"Extra in replay:     {report['extra']}")
+    print(f"Suppressed (orig/replay): {report['suppressed'][0]}/{report['suppressed'][1]}")
+    print(f"{'field':<14} {'differ':>8} {'mean abs':>10} {'max abs':>10}")
+    for name, f in report['fields'].items():
+        print(f"{name:<14} {f['differ']:>8} {f['mean_abs']:>10} {f['max_abs']:>10}")
+    for addr, count in report['missing_by_device'].items():
+        print(f"  missing {count:>6}  {addr}")
+
+
+def cmd_convert(args):
+    count = convert(args.capture, args.trace)
+    print(f"Wrote {count} frames to {args.trace}", file=sys.stderr)
+    return 0
+
+
+def check_status(report, check):
+    """Exit status: with check, any missing or extra sighting fails"""
+    if check and (report['missing'] > 0 or report['extra'] > 0):
+        print(f"FAIL: {report['missing']} missing, {report['extra']} extra", file=sys.stderr)
+        return 1
+    return 0
+
+
+def cmd_diff(args):
+    report = diff(load_sightings(args.original), load_sightings(args.replayed))
+    print_report(report, args.json)
+    return check_status(report, args.check)
+
+
+def cmd_run(args):
+    with tempfile.TemporaryDirectory() as tmp:
+        trace = args.trace or os.path.join(tmp, 'replay.trace')
+        frames = convert(args.capture, trace)
+        print(f"Replaying {frames} frames at "
+              f"{'full rate' if args.speed <= 0 else f'{args.speed:g}x'}", file=sys.stderr)
+
+        cmd = [args.exe, f'--replay={trace}', f'--replay-speed={args.speed}']
+        if not args.rt:
+            cmd.append('--no-rt')
+        result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                                text=True, errors='replace')
+
+    output = args.output or os.path.join(tempfile.gettempdir(), 'replay_output.log')
+    with open(output, 'w') as f:
+        f.write(result.stdout)
+
+    for line in result.stdout.splitlines():
+        if '"replay_end"' in line:
+            print(line[line.find('{'):], file=sys.stderr)
+
+    if result.returncode != 0:
+        print(f"{args.exe} exited with {result.returncode}, output in {output}", file=sys.stderr)
+        return 1
+
+    report = diff(load_sightings(args.capture), load_sightings(output))
+    print_report(report, args.json)
+    return check_status(report, args.check)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Replay scanner captures through the firmware')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('convert', help='Convert a capture to a replay trace')
+    p.add_argument('capture', help='Capture (monitor.py --output file or JSON lines)')
+    p.add_argument('trace', help='Replay trace to write')
+    p.set_defaults(func=cmd_convert)
+
+    p = sub.add_parser('run', help='Replay a capture through a native_sim build and diff')
+    p.add_argument('exe', help='native_sim image built with replay.conf (zephyr.exe)')
+    p.add_argument('capture', help='Capture (monitor.py --output file or JSON lines)')
+    p.add_argument('-s', '--speed', type=float, default=1.0,
+                   help='Replay speed multiplier, 0 for as fast as the scanner '
+                        'takes frames (default: 1.0)')
+    p.add_argument('--rt', action='store_true',
+                   help='Run the simulation in wall-clock time')
+    p.add_argument('-o', '--output', help='Keep the replay output in this file')
+    p.add_argument('-t', '--trace', help='Keep the replay trace in this file')
+    p.add_argument('-j', '--json', action='store_true', help='Write the diff as JSON')
+    p.add_argument('-c', '--check', action='store_true',
+                   help='Exit with status 1 on any missing or extra sighting')
+    p.set_defaults(func=cmd_run)
+
+    p = sub.add_parser('diff', help='Compare the sightings of two captures')
+    p.add_argument('original', help='Original capture')
+    p.add_argument('replayed', help='Replay output')
+    p.add_argument('-j', '--json', action='store_true', help='Write the diff as JSON')
+    p.add_argument('-c', '--check', action='store_true',
+                   help='Exit with status 1 on any missing or extra sighting')
+    p.set_defaults(func=cmd_diff)
+
+    args = parser.parse_args()
+    sys.exit(args.func(args))
+
+
+if __name__ == '__main__':
+    main()
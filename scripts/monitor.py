@@ -58,6 +58,9 @@ def main():
                        help='Baud rate (default: 115200)')
     parser.add_argument('-o', '--output', type=str,
                        help='Output file for logging')
+    parser.add_argument('-d', '--data', action='store_true',
+                       help='Port is the dedicated data interface: every line '
+                            'is a JSON record, no log text to strip')
 
     args = parser.parse_args()
 
@@ -86,6 +89,13 @@ def main():
                         output_file.write(line + '\n')
                         output_file.flush()
 
+                    # The data interface carries nothing but JSON records
+                    if args.data:
+                        info = parse_device_info(line)
+                        if info:
+                            format_device_info(info)
+                        continue
+
                     # Split out any leading non-JSON text (e.g. Zephyr logs)
                     stripped = line.strip()
                     if not stripped:
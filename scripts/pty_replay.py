@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+UWB Scanner PTY Replay
+Replays recorded scanner captures through pseudo-terminals so host tools
+(e.g. tools/uwb_aggregator) can be exercised without hardware
+"""
+
+import argparse
+import json
+import os
+import sys
+import time
+import tty
+
+
+def load_capture(path):
+    """Load a capture as (timestamp_ms, line) pairs"""
+    records = []
+    with open(path, 'r') as f:
+        for line in f:
+            line = line.rstrip('\r\n')
+            if not line:
+                continue
+            ts = None
+            start = line.find('{')
+            if start != -1:
+                try:
+                    ts = json.loads(line[start:]).get('timestamp_ms')
+                except json.JSONDecodeError:
+                    pass
+            records.append((ts, line))
+    return records
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Replay scanner captures through ptys')
+    parser.add_argument('captures', nargs='+',
+                       help='Capture files (one pty is created per file)')
+    parser.add_argument('-s', '--speed', type=float, default=1.0,
+                       help='Replay speed multiplier (default: 1.0)')
+    parser.add_argument('--fast', action='store_true',
+                       help='Replay as fast as possible, ignoring timestamps')
+    parser.add_argument('-l', '--loop', type=int, default=1,
+                       help='Number of times to replay each capture')
+    parser.add_argument('-w', '--wait', type=float, default=1.0,
+                       help='Seconds to wait for readers before starting and '
+                            'before closing (default: 1.0)')
+
+    args = parser.parse_args()
+
+    ptys = []
+    for path in args.captures:
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        ptys.append({
+            'master': master,
+            'slave': slave,
+            'name': os.ttyname(slave),
+            'records': load_capture(path),
+            'index': 0,
+            'loop': 0,
+            'base_ts': None,
+            'offset_ms': 0,
+        })
+        print(os.ttyname(slave), flush=True)
+
+    time.sleep(args.wait)
+    start = time.monotonic()
+    sent = 0
+
+    # Merge all captures on a single replay clock
+    while True:
+        active = [p for p in ptys if p['loop'] < args.loop]
+        if not active:
+            break
+
+        for p in active:
+            ts, line = p['records'][p['index']]
+
+            if not args.fast and ts is not None:
+                if p['base_ts'] is None:
+                    p['base_ts'] = ts
+                due = (ts - p['base_ts'] + p['offset_ms']) / 1000.0 / args.speed
+                delay = start + due - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+
+            os.write(p['master'], (line + '\r\n').encode('utf-8'))
+            sent += 1
+
+            p['index'] += 1
+            if p['index'] == len(p['records']):
+                p['index'] = 0
+                p['loop'] += 1
+                if p['base_ts'] is not None:
+                    last_ts = max((r[0] for r in p['records'] if r[0] is not None),
+                                  default=p['base_ts'])
+                    p['offset_ms'] += last_ts - p['base_ts'] + 1
+
+    elapsed = time.monotonic() - start
+    print(f"Replayed {sent} lines in {elapsed:.2f} s "
+          f"({sent / elapsed if elapsed > 0 else 0:.0f} lines/s)", file=sys.stderr)
+
+    # Give readers time to drain; closing the master discards unread data
+    time.sleep(args.wait)
+
+    # Closing both ends signals end of stream to the reader
+    for p in ptys:
+        os.close(p['slave'])
+        os.close(p['master'])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+UWB Scanner Trace Gaps
+Reads a CTF trace captured with tracing.conf and reports receiver-off time,
+span durations (SPI transactions, sighting callbacks, ISRs) and the gaps
+between successive tracepoints. Needs the babeltrace2 Python bindings
+(python3-bt2); the trace directory must contain Zephyr's CTF metadata.
+"""
+
+import argparse
+import sys
+from collections import defaultdict
+
+try:
+    import bt2
+except ImportError:
+    print("babeltrace2 Python bindings (bt2) not found; install python3-bt2",
+          file=sys.stderr)
+    sys.exit(1)
+
+
+# Begin/end tracepoint pairs measured as spans, keyed by their first argument
+SPANS = {
+    'spi': ('spi_begin', 'spi_end'),
+    'callback': ('cb_enter', 'cb_exit'),
+}
+
+
+def field_str(field):
+    """CTF bounded strings come through as str or as an array of bytes"""
+    if isinstance(field, bt2._StringFieldConst):
+        return str(field)
+    return bytes(int(c) for c in field).split(b'\0')[0].decode('ascii', 'replace')
+
+
+def read_events(path):
+    """Yield (time_ns, name, arg0, arg1) for named events and ISRs"""
+    for msg in bt2.TraceCollectionMessageIterator(path):
+        if type(msg) is not bt2._EventMessageConst:
+            continue
+        event = msg.event
+        t = msg.default_clock_snapshot.ns_from_origin
+        if event.name == 'named_event':
+            yield (t, field_str(event.payload_field['name']),
+                   int(event.payload_field['arg0']), int(event.payload_field['arg1']))
+        elif event.name in ('isr_enter', 'isr_exit'):
+            yield (t, event.name, 0, 0)
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def report(title, values_ns):
+    us = [v / 1000 for v in values_ns]
+    print(f"  {title:<16} n={len(us):<7} p50={percentile(us, 50):10.1f} us"
+          f"  p99={percentile(us, 99):10.1f} us  max={max(us, default=0):10.1f} us"
+          f"  total={sum(us) / 1000:10.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Gap statistics from a scanner CTF trace')
+    parser.add_argument('trace', help='CTF trace directory (metadata + channel files)')
+    args = parser.parse_args()
+
+    events = sorted(read_events(args.trace))
+    if not events:
+        print("No scanner tracepoints in trace (built without CONFIG_UWB_TRACE?)")
+        return 1
+
+    start, end = events[0][0], events[-1][0]
+
+    # Receiver on from rx_enable until a frame, its timeout, sleep or the next enable
+    rx_on = []
+    rx_off = []
+    on_since = None
+    on_until = None
+    off_since = start
+    for t, name, arg0, _ in events:
+        if on_since is not None and on_until is not None and t >= on_until:
+            rx_on.append(on_until - on_since)
+            on_since, off_since = None, on_until
+        if name == 'rx_enable':
+            if on_since is not None:
+                rx_on.append(t - on_since)
+            elif off_since is not None:
+                rx_off.append(t - off_since)
+            on_since = t
+            on_until = t + arg0 * 1000000 if arg0 > 0 else None
+            off_since = None
+        elif name in ('rx_ready', 'sleep') and on_since is not None:
+            rx_on.append(t - on_since)
+            on_since, off_since = None, t
+
+    # Begin/end spans
+    spans = defaultdict(list)
+    open_spans = {}
+    for t, name, arg0, _ in events:
+        for span, (begin, finish) in SPANS.items():
+            if name == begin:
+                open_spans[(span, arg0)] = t
+            elif name == finish and (span, arg0) in open_spans:
+                spans[span].append(t - open_spans.pop((span, arg0)))
+        if name == 'isr_enter':
+            open_spans[('isr', 0)] = t
+        elif name == 'isr_exit' and ('isr', 0) in open_spans:
+            spans['isr'].append(t - open_spans.pop(('isr', 0)))
+
+    # Time between successive occurrences of each tracepoint
+    last = {}
+    gaps = defaultdict(list)
+    for t, name, _, _ in events:
+        if name in last:
+            gaps[name].append(t - last[name])
+        last[name] = t
+
+    duration = end - start
+    print(f"Trace: {len(events)} events over {duration / 1e9:.3f} s")
+
+    print("Receiver:")
+    on_total = sum(rx_on)
+    print(f"  on {on_total / 1e6:.1f} ms, off {sum(rx_off) / 1e6:.1f} ms"
+          f" ({100.0 * on_total / duration if duration else 0:.1f}% on)")
+    report('off gaps', rx_off)
+    report('on periods', rx_on)
+
+    print("Spans:")
+    for name in sorted(spans):
+        report(name, spans[name])
+
+    print("Gaps between tracepoints:")
+    for name in sorted(gaps):
+        report(name, gaps[name])
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,205 @@
+/**
+ * @file bench.c
+ * @brief Scanner throughput benchmark against the emulated DW3000
+ *
+ * Runs the real firmware against synthetic traffic and checks the
+ * results against the CONFIG_UWB_BENCH_* budgets. A quiet step first
+ * measures the scan cycle rate without traffic. Every traffic step then
+ * resets the latency histograms and the emulator counters, holds a rate
+ * for CONFIG_UWB_BENCH_STEP_MS and reports:
+ *
+ * - capture: sightings reported per frame sent on air
+ * - cycles: scan cycles, checked against the quiet baseline
+ * - processing: frame ready to record written (pipeline stage)
+ * - latency: antenna to record written (total stage)
+ * - output and SPI bytes per second
+ *
+ * A final step plays CONFIG_UWB_DW3000_EMUL_SCENARIO when one is set.
+ *
+ * The receiver takes one frame per RX window, so capture budgets are
+ * relative to what was measured in the same step: sightings against the
+ * frames the receiver caught, and the cycle rate against the baseline.
+ *
+ * On native_sim code runs in zero simulated time; the emulator charges
+ * SPI bus time, so processing and latency come out as the radio, bus and
+ * scheduling cost of the design rather than the host's speed.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_ARCH_POSIX
+#include "posix_board_if.h"
+#endif
+
+#include "bench.h"
+#include "dw3000_emul.h"
+#include "latency_trace.h"
+#include "metrics.h"
+
+LOG_MODULE_REGISTER(bench, LOG_LEVEL_INF);
+
+#define BENCH_STACK_SIZE    2048
+#define BENCH_PRIORITY      6
+#define BENCH_SETTLE_MS     3000    /* Timebase needs two samples a second apart */
+
+METRIC_DECLARE(scanner_cycles);
+METRIC_DECLARE(scanner_sightings);
+METRIC_DECLARE(output_bytes);
+
+static K_THREAD_STACK_DEFINE(bench_stack, BENCH_STACK_SIZE);
+static struct k_thread bench_thread;
+
+static const uint32_t rates[] = {10, 100, 1000};
+
+/* Scan cycles without traffic */
+static uint32_t baseline_cycles;
+static uint32_t baseline_ms;
+
+static void measure_baseline(void)
+{
+    uint32_t cycles = metric_get(&scanner_cycles);
+    int64_t start = k_uptime_get();
+
+    k_sleep(K_MSEC(CONFIG_UWB_BENCH_STEP_MS));
+
+    baseline_ms = (uint32_t)(k_uptime_get() - start);
+    baseline_cycles = metric_get(&scanner_cycles) - cycles;
+
+    printk("{\"type\":\"bench_baseline\",\"ms\":%u,\"cycles\":%u}\n",
+           baseline_ms, baseline_cycles);
+}
+
+/* Run one traffic step, Poisson at rate or the scenario if rate is 0;
+ * returns the number of budgets missed
+ */
+static int bench_step(uint32_t rate)
+{
+    const char *source = rate > 0 ? "poisson" : "scenario";
+    dw3000_emul_stats_t radio;
+    int failures = 0;
+
+    dw3000_emul_take_stats(&radio);
+    latency_trace_reset();
+    uint32_t cycles = metric_get(&scanner_cycles);
+    uint32_t sightings = metric_get(&scanner_sightings);
+    uint32_t bytes = metric_get(&output_bytes);
+    int64_t start = k_uptime_get();
+
+    if (rate > 0) {
+        dw3000_emul_set_rate(rate);
+    } else {
+        if (dw3000_emul_play_scenario() < 0) {
+            LOG_ERR("Scenario did not load");
+            failures++;
+        }
+        rate = dw3000_emul_rate();
+    }
+    k_sleep(K_MSEC(CONFIG_UWB_BENCH_STEP_MS));
+    dw3000_emul_set_rate(0);
+
+    uint32_t ms = (uint32_t)(k_uptime_get() - start);
+    dw3000_emul_take_stats(&radio);
+    cycles = metric_get(&scanner_cycles) - cycles;
+    sightings = metric_get(&scanner_sightings) - sightings;
+    bytes = metric_get(&output_bytes) - bytes;
+
+    uint32_t process_p50 = latency_trace_percentile(LATENCY_STAGE_PIPELINE, 500);
+    uint32_t process_p99 = latency_trace_percentile(LATENCY_STAGE_PIPELINE, 990);
+    uint32_t latency_p50 = latency_trace_percentile(LATENCY_STAGE_TOTAL, 500);
+    uint32_t latency_p99 = latency_trace_percentile(LATENCY_STAGE_TOTAL, 990);
+    uint32_t latency_max = latency_trace_percentile(LATENCY_STAGE_TOTAL, 1000);
+
+    /* Every frame the receiver caught should come out as a sighting */
+    uint32_t expected = (uint32_t)((uint64_t)radio.received *
+                                   CONFIG_UWB_BENCH_CAPTURE_PERMILLE / 1000U);
+
+    if (sightings < expected) {
+        LOG_ERR("%u frames/s: %u sightings of %u received, budget %u", rate, sightings,
+                radio.received, expected);
+        failures++;
+    }
+
+    /* Frame handling must not slow the scan cycle, or the receiver is
+     * off for longer and catches fewer frames
+     */
+    uint32_t expected_cycles = baseline_ms > 0 ?
+        (uint32_t)((uint64_t)baseline_cycles * ms / baseline_ms *
+                   CONFIG_UWB_BENCH_CYCLE_PERMILLE / 1000U) : 0;
+
+    if (cycles < expected_cycles) {
+        LOG_ERR("%u frames/s: %u scan cycles, budget %u", rate, cycles, expected_cycles);
+        failures++;
+    }
+    if (sightings > 0 && latency_max == 0) {
+        LOG_ERR("%u frames/s: no antenna-to-output samples (timebase not locked?)", rate);
+        failures++;
+    }
+    if (latency_p99 > CONFIG_UWB_BENCH_LATENCY_P99_MS * 1000U) {
+        LOG_ERR("%u frames/s: p99 latency %u us, budget %u ms", rate, latency_p99,
+                CONFIG_UWB_BENCH_LATENCY_P99_MS);
+        failures++;
+    }
+    if (process_p99 > CONFIG_UWB_BENCH_PROCESS_P99_US) {
+        LOG_ERR("%u frames/s: p99 processing %u us, budget %u us", rate, process_p99,
+                CONFIG_UWB_BENCH_PROCESS_P99_US);
+        failures++;
+    }
+
+    printk("{\"type\":\"bench\",\"source\":\"%s\",\"rate\":%u,\"ms\":%u,"
+           "\"generated\":%u,\"collided\":%u,\"received\":%u,\"errors\":%u,"
+           "\"sightings\":%u,\"capture_permille\":%u,\"cycles\":%u,"
+           "\"out_bps\":%u,\"spi_bps\":%u,"
+           "\"process_us\":{\"p50\":%u,\"p99\":%u},"
+           "\"latency_us\":{\"p50\":%u,\"p99\":%u,\"max\":%u},\"pass\":%s}\n",
+           source, rate, ms, radio.generated, radio.collided, radio.received, radio.errors,
+           sightings,
+           radio.generated > 0 ? (uint32_t)((uint64_t)sightings * 1000 / radio.generated) : 0,
+           cycles,
+           ms > 0 ? (uint32_t)((uint64_t)bytes * 1000 / ms) : 0,
+           ms > 0 ? (uint32_t)((uint64_t)radio.spi_bytes * 1000 / ms) : 0,
+           process_p50, process_p99, latency_p50, latency_p99, latency_max,
+           failures == 0 ? "true" : "false");
+
+    return failures;
+}
+
+static void bench_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    uint32_t steps = ARRAY_SIZE(rates);
+    int failures = 0;
+
+    /* Silence until the first step, even with a scenario playing from boot */
+    dw3000_emul_set_rate(0);
+    k_sleep(K_MSEC(BENCH_SETTLE_MS));
+    measure_baseline();
+
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+        failures += bench_step(rates[i]);
+    }
+
+    /* Then the configured scenario, if there is one */
+    if (sizeof(CONFIG_UWB_DW3000_EMUL_SCENARIO) > 1) {
+        failures += bench_step(0);
+        steps++;
+    }
+
+    printk("{\"type\":\"bench_end\",\"steps\":%u,\"failures\":%d}\n", steps, failures);
+
+#ifdef CONFIG_ARCH_POSIX
+    posix_exit(failures > 0 ? 1 : 0);
+#endif
+}
+
+void bench_start(void)
+{
+    k_thread_create(&bench_thread, bench_stack, BENCH_STACK_SIZE,
+                    bench_thread_fn, NULL, NULL, NULL,
+                    BENCH_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&bench_thread, "bench");
+}
@@ -0,0 +1,84 @@
+/**
+ * @file boot_bench.c
+ * @brief Boot-to-first-frame measurement against the emulated DW3000
+ *
+ * Traffic plays from boot (CONFIG_UWB_DW3000_EMUL_SCENARIO), so the first
+ * frame arrives as soon as the receiver is listening. Settings live in NVS
+ * on the native_sim flash simulator, which is backed by a host file: the
+ * first run with a fresh file is a cold boot that stores the SPI clock,
+ * the next run with the same file is a warm boot.
+ *
+ * Either way, scanning must start within CONFIG_UWB_BOOT_BENCH_SCAN_US and
+ * the first frame be read within CONFIG_UWB_BOOT_BENCH_FIRST_FRAME_US.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_ARCH_POSIX
+#include "posix_board_if.h"
+#endif
+
+#include "boot_bench.h"
+#include "uwb_scanner.h"
+
+LOG_MODULE_REGISTER(boot_bench, LOG_LEVEL_INF);
+
+#define BOOT_BENCH_STACK_SIZE   1024
+#define BOOT_BENCH_PRIORITY     6
+#define BOOT_BENCH_POLL_MS      1
+#define BOOT_BENCH_TIMEOUT_MS   10000
+
+static K_THREAD_STACK_DEFINE(boot_bench_stack, BOOT_BENCH_STACK_SIZE);
+static struct k_thread boot_bench_thread;
+static uart_output_boot_t boot_info;
+
+static void boot_bench_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    uint32_t first_frame_us;
+
+    while ((first_frame_us = uwb_scanner_get_first_frame_us()) == 0 &&
+           k_uptime_get() < BOOT_BENCH_TIMEOUT_MS) {
+        k_sleep(K_MSEC(BOOT_BENCH_POLL_MS));
+    }
+
+    int failures = 0;
+
+    if (first_frame_us == 0) {
+        LOG_ERR("No frame within %u ms of boot", BOOT_BENCH_TIMEOUT_MS);
+        failures++;
+    } else if (first_frame_us > CONFIG_UWB_BOOT_BENCH_FIRST_FRAME_US) {
+        LOG_ERR("First frame %u us after boot, budget %u us", first_frame_us,
+                CONFIG_UWB_BOOT_BENCH_FIRST_FRAME_US);
+        failures++;
+    }
+    if (boot_info.scan_us > CONFIG_UWB_BOOT_BENCH_SCAN_US) {
+        LOG_ERR("Scanning %u us after boot, budget %u us", boot_info.scan_us,
+                CONFIG_UWB_BOOT_BENCH_SCAN_US);
+        failures++;
+    }
+
+    printk("{\"type\":\"boot_bench\",\"warm\":%s,\"output_us\":%u,\"radio_us\":%u,"
+           "\"scan_us\":%u,\"first_frame_us\":%u,\"pass\":%s}\n",
+           boot_info.warm ? "true" : "false", boot_info.output_us, boot_info.radio_us,
+           boot_info.scan_us, first_frame_us, failures == 0 ? "true" : "false");
+
+#ifdef CONFIG_ARCH_POSIX
+    posix_exit(failures > 0 ? 1 : 0);
+#endif
+}
+
+void boot_bench_start(const uart_output_boot_t *boot)
+{
+    boot_info = *boot;
+
+    k_thread_create(&boot_bench_thread, boot_bench_stack, BOOT_BENCH_STACK_SIZE,
+                    boot_bench_thread_fn, NULL, NULL, NULL,
+                    BOOT_BENCH_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&boot_bench_thread, "boot_bench");
+}
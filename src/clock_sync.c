@@ -0,0 +1,245 @@
+/**
+ * @file clock_sync.c
+ * @brief Inter-scanner clock synchronisation for passive TDoA
+ *
+ * The reference scanner transmits beacons at a scheduled device time and
+ * carries that time in the payload. Each listener pairs the beacon's
+ * reference TX time with its own RX timestamp and tracks the clock offset
+ * with an exponentially weighted least-squares line (linear_fit), so each
+ * beacon and each mapped frame cost O(1).
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <math.h>
+
+#include "clock_sync.h"
+#include "dw3000_driver.h"
+#include "linear_fit.h"
+
+LOG_MODULE_REGISTER(clock_sync, LOG_LEVEL_INF);
+
+/* Beacon frame layout (IEEE 802.15.4 data frame, short addresses) */
+#define SYNC_FCF                0x8841  /* Data, PAN ID compress, short dst/src */
+#define SYNC_BROADCAST          0xFFFF
+#define SYNC_HDR_LEN            9       /* FCF + seq + dst PAN + dst + src */
+#define SYNC_PAYLOAD_LEN        13      /* magic + version + 64-bit TX time */
+#define SYNC_FRAME_LEN          (SYNC_HDR_LEN + SYNC_PAYLOAD_LEN)
+#define SYNC_VERSION            1
+
+static const uint8_t sync_magic[4] = {'S', 'Y', 'N', 'C'};
+
+/* Schedule beacons 1 ms ahead, enough to load the frame over SPI */
+#define SYNC_TX_DELAY_TICKS     (DW3000_TIME_TICKS_PER_SEC / 1000)
+#define SYNC_TX_ANTENNA_DELAY   16385
+#define SYNC_TX_WAIT_US         200
+#define SYNC_TX_WAIT_ATTEMPTS   10
+
+/* Fit parameters */
+#define SYNC_FORGET             0.9     /* Per-beacon weight decay */
+#define SYNC_MIN_BEACONS        3       /* Beacons needed before locking */
+#define SYNC_RESET_TICKS        63898.0 /* 1 us residual forces a refit */
+#define SYNC_STALE_TICKS        (5 * (int64_t)DW3000_TIME_TICKS_PER_SEC)
+
+/* Unwraps a 40-bit counter into 64 bits */
+typedef struct {
+    bool valid;
+    uint64_t last_raw;
+    int64_t unwrapped;
+} unwrap40_t;
+
+static clock_sync_role_t sync_role = CLOCK_SYNC_ROLE_NONE;
+static uint8_t beacon_seq;
+static uint32_t next_beacon_ms;
+
+static unwrap40_t local_clock;
+
+/* Listener fit: offset (ref - local) against unwrapped local time */
+static linear_fit_t fit;
+
+static int64_t unwrap40_update(unwrap40_t *u, uint64_t raw)
+{
+    raw &= DW3000_TIME_MASK;
+
+    if (!u->valid) {
+        u->valid = true;
+        u->unwrapped = (int64_t)raw;
+    } else {
+        u->unwrapped += dw3000_time_delta(raw, u->last_raw);
+    }
+    u->last_raw = raw;
+
+    return u->unwrapped;
+}
+
+static int64_t unwrap40_peek(const unwrap40_t *u, uint64_t raw)
+{
+    return u->unwrapped + dw3000_time_delta(raw, u->last_raw);
+}
+
+static void fit_add(int64_t x, int64_t d)
+{
+    if (fit.count >= SYNC_MIN_BEACONS) {
+        double residual = linear_fit_residual(&fit, x, d);
+        if (fabs(residual) > SYNC_RESET_TICKS) {
+            LOG_WRN("Sync residual %.0f ticks, refitting", residual);
+            linear_fit_init(&fit, SYNC_FORGET);
+        }
+    }
+
+    linear_fit_add(&fit, x, d);
+
+    if (fit.count == SYNC_MIN_BEACONS) {
+        LOG_INF("Sync locked: drift=%.3f ppm", fit.b * 1e6);
+    }
+}
+
+int clock_sync_init(clock_sync_role_t role)
+{
+    sync_role = role;
+    beacon_seq = 0;
+    next_beacon_ms = k_uptime_get_32();
+    memset(&local_clock, 0, sizeof(local_clock));
+    linear_fit_init(&fit, SYNC_FORGET);
+
+    LOG_INF("Clock sync role: %s",
+            role == CLOCK_SYNC_ROLE_REFERENCE ? "reference" :
+            role == CLOCK_SYNC_ROLE_LISTENER ? "listener" : "none");
+
+    return 0;
+}
+
+clock_sync_role_t clock_sync_get_role(void)
+{
+    return sync_role;
+}
+
+int clock_sync_poll_beacon(void)
+{
+    if (sync_role != CLOCK_SYNC_ROLE_REFERENCE) {
+        return 0;
+    }
+
+    if ((int32_t)(k_uptime_get_32() - next_beacon_ms) < 0) {
+        return 0;
+    }
+    next_beacon_ms += CONFIG_UWB_SYNC_BEACON_INTERVAL_MS;
+
+    uint64_t now;
+    int ret = dw3000_read_sys_time(&now);
+    if (ret < 0) {
+        return ret;
+    }
+    int64_t now_unwrapped = unwrap40_update(&local_clock, now);
+
+    /* Chip ignores the low 9 bits of the delayed TX time */
+    uint64_t tx_time = (now + SYNC_TX_DELAY_TICKS) & DW3000_TIME_MASK & ~0x1FFULL;
+
+    /*
+     * Beacons carry the unwrapped 64-bit TX time so listeners that join
+     * late still agree on the number of counter wraps.
+     */
+    uint64_t tx_stamp = (uint64_t)(now_unwrapped + dw3000_time_delta(tx_time, now)) +
+                        SYNC_TX_ANTENNA_DELAY;
+
+    uint8_t frame[SYNC_FRAME_LEN];
+    frame[0] = SYNC_FCF & 0xFF;
+    frame[1] = SYNC_FCF >> 8;
+    frame[2] = beacon_seq++;
+    frame[3] = SYNC_BROADCAST & 0xFF;
+    frame[4] = SYNC_BROADCAST >> 8;
+    frame[5] = SYNC_BROADCAST & 0xFF;
+    frame[6] = SYNC_BROADCAST >> 8;
+    frame[7] = CONFIG_UWB_SYNC_REFERENCE_ID & 0xFF;
+    frame[8] = (CONFIG_UWB_SYNC_REFERENCE_ID >> 8) & 0xFF;
+    memcpy(&frame[SYNC_HDR_LEN], sync_magic, sizeof(sync_magic));
+    frame[SYNC_HDR_LEN + 4] = SYNC_VERSION;
+    for (int i = 0; i < 8; i++) {
+        frame[SYNC_HDR_LEN + 5 + i] = (tx_stamp >> (i * 8)) & 0xFF;
+    }
+
+    ret = dw3000_tx_frame_delayed(frame, sizeof(frame), tx_time);
+    if (ret < 0) {
+        LOG_ERR("Failed to schedule sync beacon: %d", ret);
+        return ret;
+    }
+
+    for (int i = 0; i < SYNC_TX_WAIT_ATTEMPTS; i++) {
+        k_sleep(K_USEC(SYNC_TX_WAIT_US));
+        if (dw3000_is_tx_done()) {
+            return 0;
+        }
+    }
+
+    /* Transmission missed its slot, abort so RX can resume */
+    LOG_WRN("Sync beacon %u not sent", frame[2]);
+    dw3000_fast_command(DW3000_CMD_TXRXOFF);
+
+    return -ETIMEDOUT;
+}
+
+bool clock_sync_process_frame(const uint8_t *frame, uint16_t length,
+                              uint64_t rx_timestamp)
+{
+    /* Outside a sync deployment such frames are ordinary sightings */
+    if (sync_role == CLOCK_SYNC_ROLE_NONE || length < SYNC_FRAME_LEN) {
+        return false;
+    }
+
+    uint16_t fcf = frame[0] | (frame[1] << 8);
+    if (fcf != SYNC_FCF ||
+        memcmp(&frame[SYNC_HDR_LEN], sync_magic, sizeof(sync_magic)) != 0) {
+        return false;
+    }
+
+    /* With a sync role, beacons are never reported as sightings */
+    uint16_t src = frame[7] | (frame[8] << 8);
+    if (sync_role != CLOCK_SYNC_ROLE_LISTENER ||
+        src != CONFIG_UWB_SYNC_REFERENCE_ID ||
+        frame[SYNC_HDR_LEN + 4] != SYNC_VERSION) {
+        return true;
+    }
+
+    uint64_t tx_stamp = 0;
+    for (int i = 0; i < 8; i++) {
+        tx_stamp |= (uint64_t)frame[SYNC_HDR_LEN + 5 + i] << (i * 8);
+    }
+
+    int64_t x = unwrap40_update(&local_clock, rx_timestamp);
+    int64_t y = (int64_t)tx_stamp;
+
+    fit_add(x, y - x);
+
+    LOG_DBG("Sync beacon %u: offset=%lld ticks, drift=%.3f ppm",
+            frame[2], y - x, fit.b * 1e6);
+
+    return true;
+}
+
+bool clock_sync_map(uint64_t rx_timestamp, uint64_t *shared_ts)
+{
+    if (!local_clock.valid) {
+        return false;
+    }
+
+    int64_t x = unwrap40_peek(&local_clock, rx_timestamp);
+
+    if (sync_role == CLOCK_SYNC_ROLE_REFERENCE) {
+        /* The reference clock is the shared timebase */
+        *shared_ts = (uint64_t)x;
+        return true;
+    }
+
+    if (sync_role != CLOCK_SYNC_ROLE_LISTENER || fit.count < SYNC_MIN_BEACONS) {
+        return false;
+    }
+
+    int64_t dt = x - fit.x0;
+    if (dt > SYNC_STALE_TICKS || dt < -SYNC_STALE_TICKS) {
+        return false;
+    }
+
+    *shared_ts = (uint64_t)(x + linear_fit_eval(&fit, x));
+    return true;
+}
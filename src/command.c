@@ -0,0 +1,565 @@
+/**
+ * @file command.c
+ * @brief Host command channel
+ *
+ * Text commands arrive one per line over the CDC ACM link. Queries are
+ * answered straight from the device table; every other command is
+ * acknowledged with a "resp" record carrying a negative errno on failure.
+ * Replies go back on the interface the command arrived on.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "uart_output.h"
+#include "scanner_config.h"
+#include "scanner_settings.h"
+#include "spi_fault.h"
+
+LOG_MODULE_REGISTER(command, LOG_LEVEL_INF);
+
+/* Handlers reply themselves and return 0, or return an error to report */
+typedef int (*command_handler_t)(const char *args, uint64_t rx_time_us,
+                                 uart_channel_t channel);
+
+typedef struct {
+    const char *name;
+    command_handler_t handler;
+} command_t;
+
+/* Parse an unsigned number that must make up the whole argument */
+static int parse_u64(const char *str, int base, uint64_t *value)
+{
+    char *end;
+
+    if (str == NULL || *str == '\0') {
+        return -EINVAL;
+    }
+
+    *value = strtoull(str, &end, base);
+    while (*end == ' ') {
+        end++;
+    }
+
+    return *end == '\0' ? 0 : -EINVAL;
+}
+
+/* NTP-style time sync: "sync <host_t1_us>" */
+static int cmd_sync(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    uint64_t t1_us;
+
+    if (parse_u64(args, 10, &t1_us) < 0) {
+        return -EINVAL;
+    }
+
+    uart_output_sync_response(channel, t1_us, rx_time_us);
+    return 0;
+}
+
+/* "devices [max_age_ms]" */
+static int cmd_devices(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    uint64_t max_age_ms = 0;
+
+    ARG_UNUSED(rx_time_us);
+
+    if (args != NULL && parse_u64(args, 10, &max_age_ms) < 0) {
+        return -EINVAL;
+    }
+
+    return uart_output_device_table(channel, (uint32_t)MIN(max_age_ms, UINT32_MAX));
+}
+
+/* "device <addr_hex>" */
+static int cmd_device(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    uint64_t addr;
+
+    ARG_UNUSED(rx_time_us);
+
+    if (parse_u64(args, 16, &addr) < 0) {
+        return -EINVAL;
+    }
+
+    return uart_output_device(channel, addr);
+}
+
+static int cmd_counters(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    uart_output_counters(channel);
+    return 0;
+}
+
+/* "stream on|off" */
+static int cmd_stream(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(rx_time_us);
+
+    if (args != NULL && strcmp(args, "on") == 0) {
+        uart_output_set_streaming(true);
+    } else if (args != NULL && strcmp(args, "off") == 0) {
+        uart_output_set_streaming(false);
+    } else {
+        return -EINVAL;
+    }
+
+    uart_output_response(channel, "stream", 0, NULL);
+    return 0;
+}
+
+static int cmd_metrics(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    uart_output_metrics(channel);
+    return 0;
+}
+
+#ifdef CONFIG_UWB_THREAD_STATS
+static int cmd_threads(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    uart_output_threads(channel);
+    return 0;
+}
+#define THREADS_HELP ", threads"
+#else
+#define THREADS_HELP ""
+#endif
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+/* "latency [reset]" */
+static int cmd_latency(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(rx_time_us);
+
+    bool reset = args != NULL && strcmp(args, "reset") == 0;
+    if (args != NULL && !reset) {
+        return -EINVAL;
+    }
+
+    uart_output_latency(channel, reset);
+    return 0;
+}
+#define LATENCY_HELP ", latency [reset]"
+#else
+#define LATENCY_HELP ""
+#endif
+
+#ifdef CONFIG_UWB_SPI_PROFILE
+/* "spi [reset]" */
+static int cmd_spi(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(rx_time_us);
+
+    bool reset = args != NULL && strcmp(args, "reset") == 0;
+    if (args != NULL && !reset) {
+        return -EINVAL;
+    }
+
+    uart_output_spi_profile(channel, reset);
+    return 0;
+}
+#define SPI_HELP ", spi [reset]"
+#else
+#define SPI_HELP ""
+#endif
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+static int cmd_flight(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    return uart_output_flight(channel);
+}
+#define FLIGHT_HELP ", flight"
+#else
+#define FLIGHT_HELP ""
+#endif
+
+#ifdef CONFIG_UWB_SPI_FAULT
+/* "fault off" or "fault <class> [permille [ms]]", all transfers until off by default */
+static int cmd_fault(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(rx_time_us);
+
+    if (args == NULL) {
+        return -EINVAL;
+    }
+
+    if (strcmp(args, "off") == 0) {
+        spi_fault_stop();
+        uart_output_response(channel, "fault", 0, NULL);
+        return 0;
+    }
+
+    const char *end = strchr(args, ' ');
+    size_t name_len = end != NULL ? (size_t)(end - args) : strlen(args);
+    spi_fault_class_t fault = spi_fault_parse(args, name_len);
+    if (fault == SPI_FAULT_NONE) {
+        return -EINVAL;
+    }
+
+    unsigned long permille = 1000;
+    unsigned long ms = 0;
+    if (end != NULL) {
+        char *next;
+        permille = strtoul(end, &next, 10);
+        ms = strtoul(next, &next, 10);
+        if (*next != '\0') {
+            return -EINVAL;
+        }
+    }
+    if (permille == 0 || permille > 1000 || ms > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    int ret = spi_fault_start(fault, (uint16_t)permille, (uint32_t)ms);
+    if (ret < 0) {
+        return ret;
+    }
+
+    uart_output_response(channel, "fault", 0, NULL);
+    return 0;
+}
+#define FAULT_HELP ", fault <error|bitflip|stuck|delay> [permille [ms]] | off"
+#else
+#define FAULT_HELP ""
+#endif
+
+static int cmd_config(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    uart_output_config(channel);
+    return 0;
+}
+
+/* Setters for "set", each parses its value into the configuration copy */
+typedef int (*config_setter_t)(scanner_config_t *config, const char *value);
+
+static int set_channel(scanner_config_t *config, const char *value)
+{
+    uint64_t channel;
+
+    if (parse_u64(value, 10, &channel) < 0 || channel > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    config->radio.channel = (uint8_t)channel;
+    return 0;
+}
+
+static int set_preamble_code(scanner_config_t *config, const char *value)
+{
+    uint64_t code;
+
+    if (parse_u64(value, 10, &code) < 0 || code > UINT16_MAX) {
+        return -EINVAL;
+    }
+
+    config->radio.tx_preamble_code = (uint16_t)code;
+    config->radio.rx_preamble_code = (uint16_t)code;
+    return 0;
+}
+
+static int set_plen(scanner_config_t *config, const char *value)
+{
+    uint64_t symbols;
+
+    if (parse_u64(value, 10, &symbols) < 0 || symbols > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    int code = scanner_config_plen_code((uint32_t)symbols);
+    if (code < 0) {
+        return code;
+    }
+
+    config->radio.preamble_length = (uint8_t)code;
+    return 0;
+}
+
+static int set_pac(scanner_config_t *config, const char *value)
+{
+    uint64_t pac;
+
+    if (parse_u64(value, 10, &pac) < 0 || pac > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    config->radio.pac_size = (uint8_t)pac;
+    return 0;
+}
+
+static int set_rx_window(scanner_config_t *config, const char *value)
+{
+    uint64_t window_ms;
+
+    if (parse_u64(value, 10, &window_ms) < 0 || window_ms > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    config->rx_window_ms = (uint32_t)window_ms;
+    return 0;
+}
+
+static int set_sleep(scanner_config_t *config, const char *value)
+{
+    uint64_t sleep_ms;
+
+    if (parse_u64(value, 10, &sleep_ms) < 0 || sleep_ms > UINT32_MAX) {
+        return -EINVAL;
+    }
+
+    config->sleep_ms = (uint32_t)sleep_ms;
+    return 0;
+}
+
+static int set_power_profile(scanner_config_t *config, const char *value)
+{
+    int profile = scanner_config_power_parse(value);
+    if (profile < 0) {
+        return profile;
+    }
+
+    config->power_profile = (uint8_t)profile;
+    return 0;
+}
+
+static int set_min_rssi(scanner_config_t *config, const char *value)
+{
+    char *end;
+    float rssi = strtof(value, &end);
+
+    if (end == value || *end != '\0') {
+        return -EINVAL;
+    }
+
+    config->min_rssi_dbm = rssi;
+    return 0;
+}
+
+static int set_min_quality(scanner_config_t *config, const char *value)
+{
+    uint64_t quality;
+
+    if (parse_u64(value, 10, &quality) < 0 || quality > UINT8_MAX) {
+        return -EINVAL;
+    }
+
+    config->min_frame_quality = (uint8_t)quality;
+    return 0;
+}
+
+static int set_output_mode(scanner_config_t *config, const char *value)
+{
+    static const char *const names[UART_OUTPUT_MODE_COUNT] = {
+        [UART_OUTPUT_MODE_FULL] = "full",
+        [UART_OUTPUT_MODE_THROTTLED] = "throttled",
+        [UART_OUTPUT_MODE_SUMMARY] = "summary",
+    };
+
+    if (strcmp(value, "auto") == 0) {
+        config->output_mode = SCANNER_CONFIG_OUTPUT_AUTO;
+        return 0;
+    }
+
+    for (int i = 0; i < UART_OUTPUT_MODE_COUNT; i++) {
+        if (strcmp(value, names[i]) == 0) {
+            config->output_mode = (int8_t)i;
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+/* "none" or comma separated hex addresses */
+static int set_allow(scanner_config_t *config, const char *value)
+{
+    uint8_t count = 0;
+
+    if (strcmp(value, "none") == 0) {
+        config->allow_count = 0;
+        return 0;
+    }
+
+    while (*value != '\0') {
+        char *end;
+
+        if (count >= CONFIG_UWB_ALLOW_LIST_SIZE) {
+            return -ENOMEM;
+        }
+
+        config->allow_list[count++] = strtoull(value, &end, 16);
+        if (end == value || (*end != ',' && *end != '\0')) {
+            return -EINVAL;
+        }
+
+        value = *end == ',' ? end + 1 : end;
+    }
+
+    config->allow_count = count;
+    return 0;
+}
+
+static const struct {
+    const char *key;
+    config_setter_t setter;
+} config_keys[] = {
+    {"channel", set_channel},
+    {"preamble_code", set_preamble_code},
+    {"plen", set_plen},
+    {"pac", set_pac},
+    {"rx_window_ms", set_rx_window},
+    {"sleep_ms", set_sleep},
+    {"power_profile", set_power_profile},
+    {"min_rssi", set_min_rssi},
+    {"min_quality", set_min_quality},
+    {"output_mode", set_output_mode},
+    {"allow", set_allow},
+};
+
+/*
+ * "set <key> <value>": publishes a new configuration snapshot, applied by
+ * the scanner at the start of its next RX cycle, and stores it for the
+ * next boot.
+ */
+static int cmd_set(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(rx_time_us);
+
+    const char *value = args != NULL ? strchr(args, ' ') : NULL;
+    if (value == NULL) {
+        return -EINVAL;
+    }
+
+    size_t key_len = (size_t)(value - args);
+    while (*value == ' ') {
+        value++;
+    }
+
+    scanner_config_t config;
+    scanner_config_get(&config);
+
+    for (size_t i = 0; i < ARRAY_SIZE(config_keys); i++) {
+        if (strlen(config_keys[i].key) != key_len ||
+            strncmp(config_keys[i].key, args, key_len) != 0) {
+            continue;
+        }
+
+        int ret = config_keys[i].setter(&config, value);
+        if (ret < 0) {
+            return ret;
+        }
+
+        ret = scanner_config_update(&config);
+        if (ret < 0) {
+            return ret;
+        }
+
+        /* Applied either way; a failed store only affects the next boot */
+        const char *note = NULL;
+#ifdef CONFIG_UWB_SETTINGS
+        if (scanner_settings_save_config(&config) < 0) {
+            note = "not persisted";
+        }
+#endif
+
+        uart_output_response(channel, "set", 0, note);
+        uart_output_config(channel);
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+static int cmd_help(const char *args, uint64_t rx_time_us, uart_channel_t channel);
+
+static const command_t commands[] = {
+    {"sync", cmd_sync},
+    {"devices", cmd_devices},
+    {"device", cmd_device},
+    {"counters", cmd_counters},
+    {"metrics", cmd_metrics},
+#ifdef CONFIG_UWB_THREAD_STATS
+    {"threads", cmd_threads},
+#endif
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    {"latency", cmd_latency},
+#endif
+#ifdef CONFIG_UWB_SPI_PROFILE
+    {"spi", cmd_spi},
+#endif
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+    {"flight", cmd_flight},
+#endif
+#ifdef CONFIG_UWB_SPI_FAULT
+    {"fault", cmd_fault},
+#endif
+    {"stream", cmd_stream},
+    {"config", cmd_config},
+    {"set", cmd_set},
+    {"help", cmd_help},
+};
+
+static int cmd_help(const char *args, uint64_t rx_time_us, uart_channel_t channel)
+{
+    ARG_UNUSED(args);
+    ARG_UNUSED(rx_time_us);
+
+    uart_output_response(channel, "help", 0,
+                         "sync <t1_us>, devices [max_age_ms], device <addr>, "
+                         "counters, metrics, stream on|off, config, set <key> <value>"
+                         THREADS_HELP LATENCY_HELP SPI_HELP FLIGHT_HELP FAULT_HELP);
+    return 0;
+}
+
+void command_handle_line(const char *line, uint64_t rx_time_us, uart_channel_t channel)
+{
+    const char *args = strchr(line, ' ');
+    size_t name_len = args != NULL ? (size_t)(args - line) : strlen(line);
+
+    /* Arguments start at the first non-space, NULL when there are none */
+    while (args != NULL && *args == ' ') {
+        args++;
+    }
+    if (args != NULL && *args == '\0') {
+        args = NULL;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+        const command_t *cmd = &commands[i];
+
+        if (strlen(cmd->name) != name_len || strncmp(cmd->name, line, name_len) != 0) {
+            continue;
+        }
+
+        int ret = cmd->handler(args, rx_time_us, channel);
+        if (ret < 0) {
+            uart_output_response(channel, cmd->name, ret,
+                                 ret == -EINVAL ? "invalid argument" :
+                                 ret == -ENOENT ? "not found" :
+                                 ret == -EBUSY ? "busy" :
+                                 ret == -ETIMEDOUT ? "timed out" :
+                                 ret == -ENOMEM ? "too many entries" : NULL);
+        }
+        return;
+    }
+
+    LOG_WRN("Unknown host command: %s", line);
+    uart_output_response(channel, "unknown", -ENOTSUP, "unknown command");
+}
@@ -0,0 +1,118 @@
+/**
+ * @file device_table.c
+ * @brief Table of recently seen UWB devices
+ *
+ * Open addressing with linear probing. Slots are never emptied once used;
+ * eviction overwrites the stalest entry in place, so probe chains stay
+ * intact without tombstones.
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#include "device_table.h"
+
+#define DEVICE_TABLE_SIZE CONFIG_UWB_DEVICE_TABLE_SIZE
+
+BUILD_ASSERT((DEVICE_TABLE_SIZE & (DEVICE_TABLE_SIZE - 1)) == 0,
+             "device table size must be a power of two");
+
+static device_entry_t table[DEVICE_TABLE_SIZE];
+static uint32_t table_count;
+
+static uint32_t hash_addr(uint64_t addr)
+{
+    return (uint32_t)((addr * 0x9E3779B97F4A7C15ULL) >> 32) & (DEVICE_TABLE_SIZE - 1);
+}
+
+static device_entry_t *lookup(uint64_t addr)
+{
+    uint32_t slot = hash_addr(addr);
+    device_entry_t *stalest = NULL;
+
+    for (uint32_t probe = 0; probe < DEVICE_TABLE_SIZE; probe++) {
+        device_entry_t *entry = &table[(slot + probe) & (DEVICE_TABLE_SIZE - 1)];
+
+        if (entry->device_addr == addr) {
+            return entry;
+        }
+        if (entry->device_addr == 0) {
+            table_count++;
+            return entry;
+        }
+        if (stalest == NULL ||
+            (int32_t)(entry->last_seen_ms - stalest->last_seen_ms) < 0) {
+            stalest = entry;
+        }
+    }
+
+    /* Full: reuse the least recently seen device's slot */
+    memset(stalest, 0, sizeof(*stalest));
+    return stalest;
+}
+
+device_entry_t *device_table_update(const uwb_device_info_t *info)
+{
+    device_entry_t *entry = lookup(info->device_addr);
+
+    if (entry->device_addr == 0) {
+        entry->device_addr = info->device_addr;
+        entry->first_seen_ms = info->timestamp_ms;
+        entry->last_output_ms = info->timestamp_ms;
+    }
+
+    if (entry->pending == 0 || info->rssi_dbm > entry->best_rssi_dbm) {
+        entry->best_rssi_dbm = info->rssi_dbm;
+    }
+
+    entry->last_seen_ms = info->timestamp_ms;
+    entry->last_rssi_dbm = info->rssi_dbm;
+    entry->count++;
+    entry->pending++;
+
+    return entry;
+}
+
+void device_table_mark_output(device_entry_t *entry, uint32_t now_ms)
+{
+    entry->last_output_ms = now_ms;
+    entry->pending = 0;
+}
+
+device_entry_t *device_table_find(uint64_t device_addr)
+{
+    uint32_t slot = hash_addr(device_addr);
+
+    if (device_addr == 0) {
+        return NULL;
+    }
+
+    for (uint32_t probe = 0; probe < DEVICE_TABLE_SIZE; probe++) {
+        device_entry_t *entry = &table[(slot + probe) & (DEVICE_TABLE_SIZE - 1)];
+
+        if (entry->device_addr == device_addr) {
+            return entry;
+        }
+        if (entry->device_addr == 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+uint32_t device_table_foreach(uint32_t cursor, device_table_cb_t cb, void *user_data)
+{
+    for (uint32_t i = cursor; i < DEVICE_TABLE_SIZE; i++) {
+        if (table[i].device_addr != 0 && !cb(&table[i], user_data)) {
+            return i;
+        }
+    }
+
+    return DEVICE_TABLE_END;
+}
+
+uint32_t device_table_count(void)
+{
+    return table_count;
+}
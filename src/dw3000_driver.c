@@ -13,6 +13,11 @@
 #include <math.h>
 
 #include "dw3000_driver.h"
+#include "metrics.h"
+#include "spi_profile.h"
+#include "uwb_trace.h"
+#include "flight_recorder.h"
+#include "spi_fault.h"
 
 LOG_MODULE_REGISTER(dw3000, LOG_LEVEL_INF);
 
@@ -27,6 +32,7 @@ LOG_MODULE_REGISTER(dw3000, LOG_LEVEL_INF);
 /* SPI Commands */
 #define DW3000_SPI_WRITE 0x80
 #define DW3000_SPI_READ  0x00
+#define DW3000_SPI_FAST_CMD 0x81
 
 /* Device constants */
 #define DW3000_DEVICE_ID 0xDECA0302
@@ -36,6 +42,9 @@ LOG_MODULE_REGISTER(dw3000, LOG_LEVEL_INF);
 #define DW3000_WAKEUP_PIN 18
 #define DW3000_IRQ_PIN    19
 
+METRIC_COUNTER_DEFINE(dw3000_spi_transfers);
+METRIC_COUNTER_DEFINE(dw3000_spi_errors);
+
 /* Static variables */
 static const struct device *spi_dev;
 static struct spi_config spi_cfg;
@@ -49,8 +58,8 @@ static int dw3000_spi_transfer(uint16_t reg, uint8_t *data, uint16_t len, bool w
     int header_len;
 
     /* Build SPI header */
-    if (reg < 0x80) {
-        /* Short register address */
+    if (reg < 0x40) {
+        /* Short register address, 6 bits */
         header[0] = (write ? DW3000_SPI_WRITE : DW3000_SPI_READ) | (reg & 0x3F);
         header_len = 1;
     } else {
@@ -74,8 +83,15 @@ static int dw3000_spi_transfer(uint16_t reg, uint8_t *data, uint16_t len, bool w
     struct spi_buf_set tx = {.buffers = tx_bufs, .count = 2U};
     struct spi_buf_set rx = {.buffers = rx_bufs, .count = 2U};
 
-    int ret = spi_transceive(spi_dev, &spi_cfg, &tx, &rx);
+    UWB_TRACE("spi_begin", SPI_PROFILE_REG(reg, write), header_len + len);
+    SPI_PROFILE_BEGIN(start);
+    int ret = SPI_FAULT_TRANSCEIVE(spi_dev, &spi_cfg, &tx, &rx);
+    SPI_PROFILE_END(start, SPI_PROFILE_REG(reg, write), header_len + len, ret);
+    UWB_TRACE("spi_end", SPI_PROFILE_REG(reg, write), ret);
+    metric_inc(&dw3000_spi_transfers);
     if (ret < 0) {
+        metric_inc(&dw3000_spi_errors);
+        FLIGHT_RECORD(FR_SPI_ERROR, SPI_PROFILE_REG(reg, write), ret, 0);
         LOG_ERR("SPI transfer failed: %d (reg=0x%04X, len=%d, write=%d)", 
                 ret, reg, len, write);
         return ret;
@@ -104,11 +120,46 @@ int dw3000_write_reg(uint16_t reg, const uint8_t *data, uint16_t len)
     return dw3000_spi_transfer(reg, (uint8_t *)data, len, true);
 }
 
-int dw3000_init(void)
+/* Bring-up polling: the chip normally reports ready ~1-2 ms after reset */
+#define DW3000_READY_POLL_US        100
+#define DW3000_READY_TIMEOUT_US     10000
+#define DW3000_RESET_HOLD_US        500     /* WAKEUP high and RSTn low */
+
+/* Poll SYS_STATUS until all bits in @p mask are set */
+static int dw3000_wait_status(uint32_t mask)
 {
-    int ret;
+    uint8_t buf[4];
+
+    for (uint32_t waited = 0; waited < DW3000_READY_TIMEOUT_US;
+         waited += DW3000_READY_POLL_US) {
+        if (dw3000_read_reg(DW3000_REG_SYS_STATUS, buf, sizeof(buf)) == 0) {
+            uint32_t status = buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+                              ((uint32_t)buf[3] << 24);
+
+            /* All ones is a floating MISO, not a ready chip */
+            if (status != 0xFFFFFFFF && (status & mask) == mask) {
+                LOG_DBG("DW3000 status 0x%08X after %u us", mask, waited);
+                return 0;
+            }
+        }
 
-    LOG_INF("Initializing DW3000");
+        k_sleep(K_USEC(DW3000_READY_POLL_US));
+    }
+
+    LOG_WRN("DW3000 status 0x%08X not set after %u us", mask, DW3000_READY_TIMEOUT_US);
+    return -ETIMEDOUT;
+}
+
+/* Poll until the chip reports SPIRDY and RCINIT (IDLE_RC reached) */
+static int dw3000_wait_ready(void)
+{
+    return dw3000_wait_status(DW3000_STATUS_SPIRDY | DW3000_STATUS_RCINIT);
+}
+
+/* Set up GPIO and SPI, then wake and hard-reset the chip */
+static int dw3000_hw_reset(uint32_t spi_hz)
+{
+    int ret;
 
     /* Get GPIO device */
     gpio_dev = DEVICE_DT_GET(DT_NODELABEL(gpio0));
@@ -126,8 +177,7 @@ int dw3000_init(void)
     LOG_DBG("SPI device ready: %s", spi_dev->name);
 
     /* Configure SPI - DW3000 requires SPI Mode 0 (CPOL=0, CPHA=0) */
-    /* Start with slower speed for initialization */
-    spi_cfg.frequency = DW3000_SPI_FREQ_SLOW;
+    spi_cfg.frequency = spi_hz;
     spi_cfg.operation = DW3000_SPI_MODE;
     spi_cfg.slave = 0;
 
@@ -152,36 +202,36 @@ int dw3000_init(void)
         LOG_WRN("Failed to configure wakeup GPIO: %d", ret);
     }
 
-    /* Perform hardware reset sequence */
-    LOG_INF("Performing hardware reset");
-
-    /* DW3000 wakeup sequence: 
-     * The chip might be in deep sleep. We need to wake it first before reset.
-     * Wakeup requires pulling WAKEUP low briefly, then high.
+    /*
+     * Hardware reset. WAKEUP has been high since it was configured, which
+     * wakes a chip left in DEEPSLEEP (it holds RSTn low while asleep), so
+     * one hold covers both the wake pulse and the reset pulse. This is a
+     * pulse width, not a readiness wait; readiness is polled below.
      */
-    
-    /* First, try to wake the chip from deep sleep */
-    LOG_DBG("Waking chip from potential deep sleep");
-    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 0);  /* Pull WAKEUP low */
-    k_sleep(K_USEC(500));  /* 500us low pulse */
-    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 1);  /* Pull WAKEUP high */
-    k_sleep(K_MSEC(2));  /* Wait for wakeup */
-
-    /* Now perform the hardware reset */
-    LOG_DBG("Asserting reset (low)");
+    LOG_INF("Performing hardware reset");
+    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 1);
     gpio_pin_set(gpio_dev, DW3000_RESET_PIN, 0);
-    k_sleep(K_MSEC(2));  /* Hold reset for 2ms minimum */
-
-    /* Deassert reset (pull high) */
-    LOG_DBG("Deasserting reset (high)");
+    k_sleep(K_USEC(DW3000_RESET_HOLD_US));
     gpio_pin_set(gpio_dev, DW3000_RESET_PIN, 1);
-    
-    /* Keep WAKEUP high to prevent chip from going back to sleep */
-    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 1);
-    
-    /* Wait for chip to stabilize after reset - DW3000 datasheet specifies 5ms */
-    k_sleep(K_MSEC(5));
-    
+
+    /* Wait for the chip to reach IDLE_RC instead of a fixed 5 ms */
+    return dw3000_wait_ready();
+}
+
+int dw3000_init(void)
+{
+    int ret;
+
+    LOG_INF("Initializing DW3000");
+
+    /* Start with slower speed for initialization */
+    ret = dw3000_hw_reset(DW3000_SPI_FREQ_SLOW);
+    if (ret < 0 && ret != -ETIMEDOUT) {
+        return ret;
+    }
+
+    /* A chip that missed the ready poll still gets the ID retries below */
+
     LOG_DBG("Attempting to read device ID");
 
     /* Try a simple SPI loopback test first by reading a known register */
@@ -190,22 +240,21 @@ int dw3000_init(void)
     LOG_DBG("Initial SPI test: ret=%d, data=[0x%02X 0x%02X 0x%02X 0x%02X]",
             ret_test, test_buf[0], test_buf[1], test_buf[2], test_buf[3]);
 
-    /* Read and verify device ID - try multiple times */
+    /* Read and verify device ID, polling until the chip answers */
     uint32_t dev_id = 0;
-    int attempts = 0;
-    for (attempts = 0; attempts < 5; attempts++) {
+    for (uint32_t waited = 0; waited < DW3000_READY_TIMEOUT_US;
+         waited += DW3000_READY_POLL_US) {
         dev_id = dw3000_get_device_id();
-        LOG_INF("Device ID (attempt %d): 0x%08X", attempts + 1, dev_id);
-        
+
         /* Check if we got a valid response (not 0x00000000 or 0xFFFFFFFF) */
         if (dev_id != 0x00000000 && dev_id != 0xFFFFFFFF) {
+            LOG_INF("Device ID 0x%08X after %u us", dev_id, waited);
             break;
         }
-        
-        /* Wait a bit before retrying */
-        k_sleep(K_MSEC(10));
+
+        k_sleep(K_USEC(DW3000_READY_POLL_US));
     }
-    
+
     /* If we still have all 1s or all 0s, there's a communication problem */
     if (dev_id == 0x00000000) {
         LOG_ERR("Device ID reads as 0x00000000 - possible SPI connection issue");
@@ -230,6 +279,135 @@ int dw3000_init(void)
     return 0;
 }
 
+int dw3000_init_warm(uint32_t spi_hz)
+{
+    LOG_INF("Initializing DW3000, then SPI at stored clock %u Hz", spi_hz);
+
+    /* Straight after reset the chip runs from its RC clock, keep SPI slow */
+    int ret = dw3000_hw_reset(DW3000_SPI_FREQ_SLOW);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* One verification read replaces the discovery probe */
+    uint32_t dev_id = dw3000_get_device_id();
+    if ((dev_id & 0xFFFFFF00) != (DW3000_DEVICE_ID & 0xFFFFFF00)) {
+        LOG_WRN("Warm init failed: device ID 0x%08X", dev_id);
+        return -EIO;
+    }
+
+    spi_cfg.frequency = spi_hz;
+
+    LOG_INF("DW3000 initialized successfully (warm)");
+    return 0;
+}
+
+#define DW3000_SNIFF_ON_PACS        2
+
+int dw3000_sniff_timing(dw3000_config_t *config, uint16_t preamble_symbols)
+{
+    uint32_t on_ns = DW3000_SNIFF_ON_PACS * config->pac_size * DW3000_SYMBOL_NS;
+    uint32_t preamble_ns = preamble_symbols * DW3000_SYMBOL_NS;
+
+    /*
+     * A preamble starting just after the receiver turns off is detected at
+     * the next on period and must still have half its length left.
+     */
+    int32_t off_ns = (int32_t)(preamble_ns / 2) - 2 * (int32_t)on_ns;
+    uint32_t off = off_ns > 0 ? (uint32_t)off_ns / DW3000_SNIFF_OFF_UNIT_NS : 0;
+
+    if (off == 0) {
+        config->sniff_on_pac = 0;
+        config->sniff_off = 0;
+        return -ENOTSUP;
+    }
+
+    config->sniff_on_pac = DW3000_SNIFF_ON_PACS;
+    config->sniff_off = (uint8_t)MIN(off, UINT8_MAX);
+    return 0;
+}
+
+uint16_t dw3000_sniff_duty_permille(const dw3000_config_t *config)
+{
+    if (config->sniff_on_pac == 0) {
+        return 1000;
+    }
+
+    uint32_t on_ns = config->sniff_on_pac * config->pac_size * DW3000_SYMBOL_NS;
+    uint32_t off_ns = config->sniff_off * DW3000_SNIFF_OFF_UNIT_NS;
+
+    return (uint16_t)(on_ns * 1000 / (on_ns + off_ns));
+}
+
+int dw3000_sleep(void)
+{
+    int ret;
+
+    /* Clear the wake indications so dw3000_wake() sees fresh ones */
+    uint32_t clear = DW3000_STATUS_SPIRDY | DW3000_STATUS_RCINIT | DW3000_STATUS_CPLOCK;
+    uint8_t status[4] = {clear & 0xFF, (clear >> 8) & 0xFF,
+                         (clear >> 16) & 0xFF, (clear >> 24) & 0xFF};
+    ret = dw3000_write_reg(DW3000_REG_SYS_STATUS, status, sizeof(status));
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* On wake: reload the saved configuration and go straight to IDLE */
+    uint16_t on_wake = DW3000_AON_ONW_AON_DLD | DW3000_AON_ONW_GO2IDLE;
+    uint8_t dig_cfg[3] = {on_wake & 0xFF, on_wake >> 8, 0};
+    ret = dw3000_write_reg(DW3000_REG_AON_DIG_CFG, dig_cfg, sizeof(dig_cfg));
+    if (ret < 0) {
+        return ret;
+    }
+
+    uint8_t aon_cfg = DW3000_AON_SLEEP_EN | DW3000_AON_WAKE_WUP;
+    ret = dw3000_write_reg(DW3000_REG_AON_CFG, &aon_cfg, 1);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* WAKEUP must be low while asleep, raising it wakes the chip */
+    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 0);
+
+    /* Saving the configuration to AON puts the chip to sleep */
+    uint8_t aon_ctrl = 0;
+    ret = dw3000_write_reg(DW3000_REG_AON_CTRL, &aon_ctrl, 1);
+    if (ret < 0) {
+        return ret;
+    }
+
+    aon_ctrl = DW3000_AON_CTRL_SAVE;
+    return dw3000_write_reg(DW3000_REG_AON_CTRL, &aon_ctrl, 1);
+}
+
+int dw3000_wake(void)
+{
+    uint32_t spi_hz = spi_cfg.frequency;
+
+    gpio_pin_set(gpio_dev, DW3000_WAKEUP_PIN, 1);
+
+    /* Until the PLL locks the chip runs from its RC clock, keep SPI slow */
+    spi_cfg.frequency = MIN(spi_hz, DW3000_SPI_FREQ_SLOW);
+
+    int ret = dw3000_wait_ready();
+    if (ret == 0) {
+        ret = dw3000_wait_status(DW3000_STATUS_CPLOCK);
+    }
+
+    spi_cfg.frequency = spi_hz;
+
+    if (ret < 0) {
+        LOG_ERR("DW3000 did not wake: %d", ret);
+    }
+
+    return ret;
+}
+
+uint32_t dw3000_get_spi_frequency(void)
+{
+    return spi_cfg.frequency;
+}
+
 int dw3000_configure(const dw3000_config_t *config)
 {
     int ret;
@@ -258,6 +436,21 @@ int dw3000_configure(const dw3000_config_t *config)
         return ret;
     }
 
+    /* Sniff mode: duty cycle the receiver until it detects preamble */
+    uint8_t sniff_cfg[2] = {config->sniff_on_pac & 0x0F, config->sniff_off};
+
+    ret = dw3000_write_reg(DW3000_REG_RX_SNIFF, sniff_cfg, sizeof(sniff_cfg));
+    if (ret < 0) {
+        LOG_ERR("Failed to configure sniff mode");
+        return ret;
+    }
+
+    if (config->sniff_on_pac != 0) {
+        LOG_INF("Sniff mode: on %u PACs, off %u, duty %u permille",
+                config->sniff_on_pac, config->sniff_off,
+                dw3000_sniff_duty_permille(config));
+    }
+
     LOG_INF("DW3000 configuration complete");
     return 0;
 }
@@ -266,6 +459,7 @@ int dw3000_rx_enable(uint32_t timeout_ms)
 {
     uint8_t cmd[1] = {0x01}; /* RX enable command */
 
+    UWB_TRACE("rx_enable", timeout_ms, 0);
     int ret = dw3000_write_reg(DW3000_REG_SYS_CFG, cmd, sizeof(cmd));
     if (ret < 0) {
         LOG_ERR("Failed to enable RX");
@@ -275,21 +469,38 @@ int dw3000_rx_enable(uint32_t timeout_ms)
     return 0;
 }
 
-bool dw3000_is_frame_ready(void)
+int dw3000_poll_frame(void)
 {
+    static uint32_t last_status;
     uint8_t status[5] = {0};
 
     int ret = dw3000_read_reg(DW3000_REG_SYS_STATUS, status, sizeof(status));
     if (ret < 0) {
-        return false;
+        return ret;
     }
 
     uint32_t status_reg = (status[0] | (status[1] << 8) |
                           (status[2] << 16) | (status[3] << 24));
 
+    /* Polled continuously, only changes are worth a flight recorder slot */
+    if (status_reg != last_status) {
+        last_status = status_reg;
+        FLIGHT_RECORD(FR_STATUS, 0, status_reg, 0);
+    }
+
+    /* MISO floating or stuck high, not a chip with every event pending */
+    if (status_reg == 0xFFFFFFFF) {
+        return -EIO;
+    }
+
     return (status_reg & DW3000_STATUS_RXFCG) != 0;
 }
 
+bool dw3000_is_frame_ready(void)
+{
+    return dw3000_poll_frame() > 0;
+}
+
 int dw3000_read_frame(dw3000_rx_frame_t *frame)
 {
     int ret;
@@ -356,6 +567,100 @@ int dw3000_read_frame(dw3000_rx_frame_t *frame)
     return 0;
 }
 
+int dw3000_fast_command(uint8_t cmd)
+{
+    uint8_t header = DW3000_SPI_FAST_CMD | ((cmd & 0x1F) << 1);
+
+    struct spi_buf tx_buf = {.buf = &header, .len = 1};
+    struct spi_buf_set tx = {.buffers = &tx_buf, .count = 1U};
+
+    UWB_TRACE("spi_begin", SPI_PROFILE_CMD(cmd), 1);
+    SPI_PROFILE_BEGIN(start);
+    int ret = SPI_FAULT_TRANSCEIVE(spi_dev, &spi_cfg, &tx, NULL);
+    SPI_PROFILE_END(start, SPI_PROFILE_CMD(cmd), 1, ret);
+    UWB_TRACE("spi_end", SPI_PROFILE_CMD(cmd), ret);
+    metric_inc(&dw3000_spi_transfers);
+    if (ret < 0) {
+        metric_inc(&dw3000_spi_errors);
+        FLIGHT_RECORD(FR_SPI_ERROR, SPI_PROFILE_CMD(cmd), ret, 0);
+        LOG_ERR("Fast command 0x%02X failed: %d", cmd, ret);
+    }
+
+    return ret;
+}
+
+int dw3000_read_sys_time(uint64_t *time)
+{
+    uint8_t systime[4] = {0};
+
+    int ret = dw3000_read_reg(DW3000_REG_SYS_TIME, systime, sizeof(systime));
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* SYS_TIME holds the upper 32 bits of the 40-bit device time */
+    *time = ((uint64_t)systime[0] << 8) | ((uint64_t)systime[1] << 16) |
+            ((uint64_t)systime[2] << 24) | ((uint64_t)systime[3] << 32);
+
+    return 0;
+}
+
+int dw3000_tx_frame_delayed(const uint8_t *data, uint16_t len, uint64_t tx_time)
+{
+    int ret;
+
+    /* Load frame into TX buffer */
+    ret = dw3000_write_reg(DW3000_REG_TX_BUFFER, data, len);
+    if (ret < 0) {
+        LOG_ERR("Failed to write TX buffer");
+        return ret;
+    }
+
+    /* Frame length includes the 2-byte FCS appended by the chip */
+    uint16_t flen = len + 2;
+    uint8_t fctrl[2] = {flen & 0xFF, (flen >> 8) & 0x03};
+    ret = dw3000_write_reg(DW3000_REG_TX_FCTRL, fctrl, sizeof(fctrl));
+    if (ret < 0) {
+        LOG_ERR("Failed to write TX frame control");
+        return ret;
+    }
+
+    /* DX_TIME takes the upper 32 bits of the 40-bit device time */
+    uint8_t dx_time[4] = {
+        (tx_time >> 8) & 0xFF,
+        (tx_time >> 16) & 0xFF,
+        (tx_time >> 24) & 0xFF,
+        (tx_time >> 32) & 0xFF,
+    };
+    ret = dw3000_write_reg(DW3000_REG_DX_TIME, dx_time, sizeof(dx_time));
+    if (ret < 0) {
+        LOG_ERR("Failed to write delayed TX time");
+        return ret;
+    }
+
+    return dw3000_fast_command(DW3000_CMD_DTX);
+}
+
+bool dw3000_is_tx_done(void)
+{
+    uint8_t status[4] = {0};
+
+    int ret = dw3000_read_reg(DW3000_REG_SYS_STATUS, status, sizeof(status));
+    if (ret < 0) {
+        return false;
+    }
+
+    if ((status[0] & DW3000_STATUS_TXFRS) == 0) {
+        return false;
+    }
+
+    /* Clear TX status */
+    uint8_t clear_status[1] = {DW3000_STATUS_TXFRS};
+    dw3000_write_reg(DW3000_REG_SYS_STATUS, clear_status, sizeof(clear_status));
+
+    return true;
+}
+
 uint32_t dw3000_get_device_id(void)
 {
     uint8_t id[4] = {0};
@@ -368,6 +673,18 @@ uint32_t dw3000_get_device_id(void)
     return id[0] | (id[1] << 8) | (id[2] << 16) | (id[3] << 24);
 }
 
+int dw3000_check_id(void)
+{
+    uint32_t dev_id = dw3000_get_device_id();
+
+    if ((dev_id & 0xFFFFFF00) != (DW3000_DEVICE_ID & 0xFFFFFF00)) {
+        LOG_WRN("Device ID check failed: 0x%08X", dev_id);
+        return -EIO;
+    }
+
+    return 0;
+}
+
 int dw3000_set_device_address(uint64_t addr)
 {
     uint8_t addr_bytes[8];
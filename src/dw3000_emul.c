@@ -0,0 +1,435 @@
+/**
+ * @file dw3000_emul.c
+ * @brief Emulated DW3000 on the SPI emulator bus
+ *
+ * Only what the driver touches is modelled: the device ID, SYS_STATUS
+ * (ready bits always set, RXFCG/RXFCE write-one-to-clear), RX enable, the
+ * RX frame registers, SYS_TIME and sleep. Device time runs at the nominal
+ * tick rate from uptime. Traffic comes from the scenario engine or a
+ * frame source such as the capture replay: a frame
+ * is caught if the receiver was on from its first preamble symbol to its
+ * last bit and the previous one has been read; the receiver then turns
+ * off. A collision the receiver could not resolve shows up as RXFCE. The
+ * chip wakes as soon as it is asked to.
+ */
+
+#define DT_DRV_COMPAT decawave_dw3000
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+
+#include "dw3000_emul.h"
+#include "dw3000_driver.h"
+#include "frame_parse.h"
+#include "scenario.h"
+
+LOG_MODULE_REGISTER(dw3000_emul, LOG_LEVEL_INF);
+
+#define EMUL_DEVICE_ID      0xDECA0302
+#define EMUL_RATE_TAGS      16
+#define EMUL_SEED           0x9E3779B97F4A7C15ULL
+#define EMUL_TIME_MASK      ((1ULL << 40) - 1)
+#define STATUS_READY        (DW3000_STATUS_SPIRDY | DW3000_STATUS_RCINIT | DW3000_STATUS_CPLOCK)
+
+#ifdef UWB_DW3000_EMUL_SCENARIO_INC
+/* CONFIG_UWB_DW3000_EMUL_SCENARIO, baked in at build time */
+static const char scenario_text[] = {
+#include "scenario.inc"
+};
+#endif
+
+static scenario_tag_t tags[CONFIG_UWB_DW3000_EMUL_MAX_TAGS];
+
+static struct {
+    struct k_spinlock lock;
+    scenario_t sc;
+    dw3000_emul_source_t source;    /* Replaces the scenario when set */
+    bool asap;
+    uint64_t origin_ns;
+    bool playing;
+    scenario_frame_t next;      /* Next frame on air */
+    bool have_next;
+    scenario_stats_t base;      /* Scenario counters at the last take */
+    bool rx_on;
+    uint64_t rx_on_ns;
+    uint32_t status;
+    scenario_frame_t rx;        /* Frame caught by the receiver */
+    uint16_t cir_pwr;
+    uint16_t fp_ampl;
+    dw3000_emul_stats_t stats;
+} emul = {
+    .status = STATUS_READY,
+};
+
+static uint64_t now_ns(void)
+{
+    return k_cyc_to_ns_floor64(k_cycle_get_64());
+}
+
+static uint64_t device_time(uint64_t ns)
+{
+    /* 63.8976 GHz = 39936 / 625 ticks per ns */
+    return (ns / 625 * 39936 + ns % 625 * 39936 / 625) & EMUL_TIME_MASK;
+}
+
+/* Register value the driver turns back into db with 10 * log10(value) */
+static uint16_t from_db(float db)
+{
+    float value = powf(10.0f, db / 10.0f);
+
+    return value >= 65535.0f ? 65535 : value < 1.0f ? 1 : (uint16_t)(value + 0.5f);
+}
+
+static void receive(const scenario_frame_t *frame)
+{
+    if (frame->corrupt) {
+        emul.status |= DW3000_STATUS_RXFCE;
+        emul.stats.errors++;
+    } else {
+        emul.rx = *frame;
+        emul.cir_pwr = from_db(frame->rssi_dbm + 115.0f);
+        emul.fp_ampl = from_db(frame->fp_level_db);
+        emul.status |= DW3000_STATUS_RXFCG;
+        emul.stats.received++;
+    }
+    emul.rx_on = false;
+}
+
+static bool fetch(scenario_frame_t *frame)
+{
+    if (emul.source == NULL) {
+        return scenario_next(&emul.sc, frame);
+    }
+
+    if (!emul.source(frame)) {
+        return false;
+    }
+    frame->at_ns += emul.origin_ns;
+    frame->rmarker_ns += emul.origin_ns;
+    emul.stats.generated++;
+    return true;
+}
+
+/* Play out the traffic up to now; called with the lock held */
+static void advance(void)
+{
+    uint64_t now = now_ns();
+
+    while (emul.playing) {
+        if (!emul.have_next) {
+            emul.have_next = fetch(&emul.next);
+            emul.playing = emul.have_next;
+            continue;
+        }
+
+        if (emul.asap) {
+            /* Send the frame as soon as the receiver can take it */
+            if (!emul.rx_on || (emul.status & DW3000_STATUS_RXFCG)) {
+                break;
+            }
+            emul.next.rmarker_ns = emul.rx_on_ns + (emul.next.rmarker_ns - emul.next.at_ns);
+            emul.next.at_ns = emul.rx_on_ns;
+        }
+
+        if (emul.next.at_ns + emul.next.airtime_ns > now) {
+            break;
+        }
+
+        if (emul.rx_on && emul.rx_on_ns <= emul.next.at_ns &&
+            !(emul.status & DW3000_STATUS_RXFCG)) {
+            receive(&emul.next);
+        } else {
+            emul.stats.missed++;
+        }
+        emul.have_next = false;
+    }
+}
+
+static void rx_enable(void)
+{
+    emul.rx_on = true;
+    emul.rx_on_ns = now_ns();
+}
+
+/* Replace the traffic; called with the lock held */
+static void play(bool playing)
+{
+    emul.source = NULL;
+    emul.asap = false;
+    emul.playing = playing;
+    emul.have_next = false;
+    if (playing) {
+        scenario_start(&emul.sc, now_ns());
+    }
+    emul.base = emul.sc.stats;
+}
+
+static void put_le(uint8_t *dst, uint64_t value, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+/* Register contents as the driver reads them; called with the lock held */
+static void read_reg(uint16_t reg, uint8_t *data, size_t len)
+{
+    uint8_t val[16] = {0};
+    const uint8_t *src = val;
+    size_t avail = sizeof(val);
+
+    switch (reg) {
+    case DW3000_REG_DEV_ID:
+        put_le(val, EMUL_DEVICE_ID, 4);
+        break;
+    case DW3000_REG_SYS_STATUS:
+        put_le(val, emul.status, 4);
+        break;
+    case DW3000_REG_RX_FINFO:
+        put_le(val, emul.rx.length, 2);
+        break;
+    case DW3000_REG_RX_BUFFER:
+        src = emul.rx.data;
+        avail = emul.rx.length;
+        break;
+    case DW3000_REG_RX_TIME:
+        put_le(val, device_time(emul.rx.rmarker_ns), 5);
+        break;
+    case DW3000_REG_RX_FQUAL:
+        put_le(val, emul.cir_pwr, 2);
+        put_le(val + 2, emul.rx.fp_index, 2);
+        put_le(val + 4, emul.fp_ampl, 2);
+        val[6] = emul.rx.quality;
+        break;
+    case DW3000_REG_SYS_TIME:
+        /* Upper 32 bits of the 40-bit device time */
+        put_le(val, device_time(now_ns()) >> 8, 4);
+        break;
+    default:
+        break;
+    }
+
+    memset(data, 0, len);
+    memcpy(data, src, MIN(len, avail));
+}
+
+/* Called with the lock held */
+static void write_reg(uint16_t reg, const uint8_t *data, size_t len)
+{
+    uint32_t value = 0;
+
+    for (size_t i = 0; i < MIN(len, sizeof(value)); i++) {
+        value |= (uint32_t)data[i] << (i * 8);
+    }
+
+    switch (reg) {
+    case DW3000_REG_SYS_CFG:
+        /* A single byte is the driver's RX enable, longer writes configure */
+        if (len == 1 && (value & 0x01)) {
+            rx_enable();
+        }
+        break;
+    case DW3000_REG_SYS_STATUS:
+        emul.status = (emul.status & ~value) | STATUS_READY;
+        break;
+    case DW3000_REG_AON_CTRL:
+        if (value & DW3000_AON_CTRL_SAVE) {
+            emul.rx_on = false;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void fast_command(uint8_t cmd)
+{
+    if (cmd == DW3000_CMD_RX) {
+        rx_enable();
+    } else if (cmd == DW3000_CMD_TXRXOFF) {
+        emul.rx_on = false;
+    }
+}
+
+static int dw3000_emul_io(const struct emul *target, const struct spi_config *config,
+                          const struct spi_buf_set *tx_bufs,
+                          const struct spi_buf_set *rx_bufs)
+{
+    uint8_t tx[8] = {0};
+    size_t tx_len = 0;
+    size_t total = 0;
+
+    ARG_UNUSED(target);
+
+    /* Header plus the first few data bytes is all a write needs */
+    for (size_t b = 0; tx_bufs != NULL && b < tx_bufs->count; b++) {
+        const struct spi_buf *buf = &tx_bufs->buffers[b];
+        for (size_t i = 0; i < buf->len && buf->buf != NULL; i++) {
+            if (tx_len < sizeof(tx)) {
+                tx[tx_len] = ((const uint8_t *)buf->buf)[i];
+            }
+            tx_len++;
+        }
+    }
+    total = tx_len;
+
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+
+    advance();
+
+    if (tx_len == 1 && (tx[0] & 0x81) == 0x81) {
+        fast_command((tx[0] >> 1) & 0x1F);
+    } else if (tx_len > 0) {
+        bool write = (tx[0] & 0x80) != 0;
+        size_t header = (tx[0] & 0x40) ? 3 : 1;
+        uint16_t reg = header == 3 ? (tx[1] & 0x7F) | ((uint16_t)tx[2] << 7) : (tx[0] & 0x3F);
+
+        if (write) {
+            write_reg(reg, tx + header, tx_len > header ? tx_len - header : 0);
+        } else if (rx_bufs != NULL) {
+            /* The data phase follows the header in the receive buffers */
+            size_t pos = 0;
+            for (size_t b = 0; b < rx_bufs->count; b++) {
+                const struct spi_buf *buf = &rx_bufs->buffers[b];
+                if (buf->buf != NULL && pos + buf->len > header) {
+                    size_t skip = pos < header ? header - pos : 0;
+                    uint8_t data[128];
+                    size_t offset = pos + skip - header;
+                    size_t len = MIN(buf->len - skip, sizeof(data) - offset);
+
+                    read_reg(reg, data, offset + len);
+                    memcpy((uint8_t *)buf->buf + skip, data + offset, len);
+                }
+                pos += buf->len;
+            }
+            total = MAX(total, pos);
+        }
+    }
+
+    emul.stats.spi_bytes += total;
+
+    k_spin_unlock(&emul.lock, key);
+
+    /* Bus time at the configured clock; on native_sim this advances simulated time */
+    if (config->frequency > 0) {
+        k_busy_wait((uint32_t)DIV_ROUND_UP(total * 8ULL * USEC_PER_SEC, config->frequency));
+    }
+
+    return 0;
+}
+
+void dw3000_emul_set_rate(uint32_t frames_per_s)
+{
+    scenario_group_t group;
+
+    scenario_group_defaults(&group);
+    group.count = EMUL_RATE_TAGS;
+    group.poisson = true;
+    group.distance_min_m = 5.0f;
+    group.distance_max_m = 50.0f;
+    if (frames_per_s > 0) {
+        group.interval_ns = (uint64_t)EMUL_RATE_TAGS * NSEC_PER_SEC / frames_per_s;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+
+    advance();
+    scenario_init(&emul.sc, tags, ARRAY_SIZE(tags), EMUL_SEED);
+    play(frames_per_s > 0 && scenario_add_group(&emul.sc, &group) == 0);
+
+    k_spin_unlock(&emul.lock, key);
+}
+
+int dw3000_emul_play_scenario(void)
+{
+#ifdef UWB_DW3000_EMUL_SCENARIO_INC
+    unsigned int line = 0;
+    int ret;
+
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+
+    advance();
+    scenario_init(&emul.sc, tags, ARRAY_SIZE(tags), EMUL_SEED);
+    ret = scenario_parse(&emul.sc, scenario_text, sizeof(scenario_text), &line);
+    play(ret == 0);
+
+    k_spin_unlock(&emul.lock, key);
+
+    if (ret < 0) {
+        LOG_ERR("%s:%u: invalid scenario (%d)", CONFIG_UWB_DW3000_EMUL_SCENARIO, line, ret);
+    }
+    return ret;
+#else
+    return -ENOENT;
+#endif
+}
+
+void dw3000_emul_set_source(dw3000_emul_source_t source, bool asap)
+{
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+
+    advance();
+    emul.source = source;
+    emul.asap = asap;
+    emul.origin_ns = now_ns();
+    emul.have_next = false;
+    emul.playing = source != NULL;
+
+    k_spin_unlock(&emul.lock, key);
+}
+
+uint32_t dw3000_emul_rate(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+    uint32_t rate = emul.playing ? (uint32_t)scenario_rate(&emul.sc) : 0;
+
+    k_spin_unlock(&emul.lock, key);
+    return rate;
+}
+
+void dw3000_emul_take_stats(dw3000_emul_stats_t *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&emul.lock);
+
+    advance();
+    *stats = emul.stats;
+    if (emul.source == NULL) {
+        stats->generated = emul.sc.stats.generated - emul.base.generated;
+        stats->collided = emul.sc.stats.collided - emul.base.collided;
+    }
+    memset(&emul.stats, 0, sizeof(emul.stats));
+    emul.base = emul.sc.stats;
+
+    k_spin_unlock(&emul.lock, key);
+}
+
+static const struct spi_emul_api dw3000_emul_api = {
+    .io = dw3000_emul_io,
+};
+
+static int dw3000_emul_init(const struct emul *target, const struct device *parent)
+{
+    ARG_UNUSED(target);
+
+    LOG_INF("Emulated DW3000 on %s", parent->name);
+
+    /* A configured scenario plays from boot */
+    if (dw3000_emul_play_scenario() == 0) {
+        LOG_INF("Scenario %s: %u tags, %u frames/s", CONFIG_UWB_DW3000_EMUL_SCENARIO,
+                emul.sc.tag_count, dw3000_emul_rate());
+    }
+    return 0;
+}
+
+/* The driver talks to the bus directly; the node only needs a device for the emulator */
+DEVICE_DT_INST_DEFINE(0, NULL, NULL, NULL, NULL, POST_KERNEL,
+                      CONFIG_KERNEL_INIT_PRIORITY_DEVICE, NULL);
+
+EMUL_DT_INST_DEFINE(0, dw3000_emul_init, NULL, NULL, &dw3000_emul_api, NULL);
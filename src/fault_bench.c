@@ -0,0 +1,184 @@
+/**
+ * @file fault_bench.c
+ * @brief SPI fault recovery benchmark against the emulated DW3000
+ *
+ * Holds Poisson traffic at FAULT_BENCH_RATE and measures the fault-free
+ * capture rate first. Then, for every fault class, arms the fault on all
+ * transfers for CONFIG_UWB_FAULT_BENCH_TRANSIENT_MS and again for
+ * CONFIG_UWB_FAULT_BENCH_SUSTAINED_MS, and reports per run:
+ *
+ * - recovery_ms: fault disarmed to the next sighting (FAULT_BENCH_POLL_MS
+ *   resolution), which includes main() restarting a scanner that gave up
+ * - lost: sightings short of the fault-free capture rate, from the fault
+ *   being armed to that first sighting
+ * - recoveries, lost_chip, restarts: scanner re-inits, scanner threads
+ *   that gave up, and restarts by main()
+ *
+ * Sustained error and stuck faults must make the scanner give up and
+ * main() restart it, so the restart path is covered on every run.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_ARCH_POSIX
+#include "posix_board_if.h"
+#endif
+
+#include "fault_bench.h"
+#include "dw3000_emul.h"
+#include "spi_fault.h"
+#include "uwb_scanner.h"
+#include "metrics.h"
+
+LOG_MODULE_REGISTER(fault_bench, LOG_LEVEL_INF);
+
+#define FAULT_BENCH_STACK_SIZE  2048
+#define FAULT_BENCH_PRIORITY    6
+#define FAULT_BENCH_RATE        20      /* frames/s */
+#define FAULT_BENCH_SETTLE_MS   3000    /* Timebase needs two samples a second apart */
+#define FAULT_BENCH_BASELINE_MS 10000
+#define FAULT_BENCH_POLL_MS     10
+#define FAULT_BENCH_GIVE_UP_MS  30000   /* Stop waiting for a sighting */
+
+METRIC_DECLARE(scanner_sightings);
+METRIC_DECLARE(scanner_recoveries);
+METRIC_DECLARE(scanner_lost);
+METRIC_DECLARE(scanner_restarts);
+
+static K_THREAD_STACK_DEFINE(fault_bench_stack, FAULT_BENCH_STACK_SIZE);
+static struct k_thread fault_bench_thread;
+
+/* Fault-free sightings per frame sent */
+static uint32_t baseline_permille;
+
+/* Time until the next sighting, -1 if none came within limit_ms */
+static int32_t wait_sighting(uint32_t limit_ms)
+{
+    uint32_t sightings = metric_get(&scanner_sightings);
+    int64_t start = k_uptime_get();
+
+    while (k_uptime_get() - start < limit_ms) {
+        k_sleep(K_MSEC(FAULT_BENCH_POLL_MS));
+        if (metric_get(&scanner_sightings) != sightings) {
+            return (int32_t)(k_uptime_get() - start);
+        }
+    }
+
+    return -1;
+}
+
+static void measure_baseline(void)
+{
+    dw3000_emul_stats_t radio;
+
+    dw3000_emul_take_stats(&radio);
+    uint32_t sightings = metric_get(&scanner_sightings);
+    k_sleep(K_MSEC(FAULT_BENCH_BASELINE_MS));
+    dw3000_emul_take_stats(&radio);
+    sightings = metric_get(&scanner_sightings) - sightings;
+
+    baseline_permille = radio.generated > 0 ?
+                        (uint32_t)((uint64_t)sightings * 1000 / radio.generated) : 0;
+
+    printk("{\"type\":\"fault_baseline\",\"rate\":%u,\"ms\":%u,\"generated\":%u,"
+           "\"sightings\":%u,\"capture_permille\":%u}\n",
+           FAULT_BENCH_RATE, FAULT_BENCH_BASELINE_MS, radio.generated, sightings,
+           baseline_permille);
+}
+
+/* One fault run; returns the number of budgets missed */
+static int fault_run(spi_fault_class_t fault, uint32_t ms, bool sustained)
+{
+    dw3000_emul_stats_t radio;
+    int failures = 0;
+
+    /* A restart from the previous run may still be pending */
+    while (!uwb_scanner_is_active()) {
+        k_sleep(K_MSEC(FAULT_BENCH_POLL_MS));
+    }
+    k_sleep(K_MSEC(FAULT_BENCH_SETTLE_MS));
+
+    dw3000_emul_take_stats(&radio);
+    uint32_t sightings = metric_get(&scanner_sightings);
+    uint32_t recoveries = metric_get(&scanner_recoveries);
+    uint32_t lost_chip = metric_get(&scanner_lost);
+    uint32_t restarts = metric_get(&scanner_restarts);
+    uint32_t injected = spi_fault_injected(fault);
+
+    spi_fault_start(fault, 1000, 0);
+    k_sleep(K_MSEC(ms));
+    spi_fault_stop();
+
+    int32_t recovery_ms = wait_sighting(FAULT_BENCH_GIVE_UP_MS);
+
+    dw3000_emul_take_stats(&radio);
+    sightings = metric_get(&scanner_sightings) - sightings;
+    recoveries = metric_get(&scanner_recoveries) - recoveries;
+    lost_chip = metric_get(&scanner_lost) - lost_chip;
+    restarts = metric_get(&scanner_restarts) - restarts;
+    injected = spi_fault_injected(fault) - injected;
+
+    uint32_t expected = (uint32_t)((uint64_t)radio.generated * baseline_permille / 1000);
+    uint32_t lost = expected > sightings ? expected - sightings : 0;
+
+    if (recovery_ms < 0 || recovery_ms > CONFIG_UWB_FAULT_BENCH_RECOVERY_MS) {
+        LOG_ERR("%s for %u ms: next sighting after %d ms, budget %u ms",
+                spi_fault_name(fault), ms, recovery_ms, CONFIG_UWB_FAULT_BENCH_RECOVERY_MS);
+        failures++;
+    }
+    if (sustained && (fault == SPI_FAULT_ERROR || fault == SPI_FAULT_STUCK) &&
+        restarts == 0) {
+        LOG_ERR("%s for %u ms: scanner never handed over to main()",
+                spi_fault_name(fault), ms);
+        failures++;
+    }
+
+    printk("{\"type\":\"fault\",\"class\":\"%s\",\"mode\":\"%s\",\"ms\":%u,"
+           "\"injected\":%u,\"generated\":%u,\"sightings\":%u,\"lost\":%u,"
+           "\"recovery_ms\":%d,\"recoveries\":%u,\"lost_chip\":%u,\"restarts\":%u,"
+           "\"pass\":%s}\n",
+           spi_fault_name(fault), sustained ? "sustained" : "transient", ms,
+           injected, radio.generated, sightings, lost, recovery_ms,
+           recoveries, lost_chip, restarts, failures == 0 ? "true" : "false");
+
+    return failures;
+}
+
+static void fault_bench_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    uint32_t runs = 0;
+    int failures = 0;
+
+    dw3000_emul_set_rate(FAULT_BENCH_RATE);
+    k_sleep(K_MSEC(FAULT_BENCH_SETTLE_MS));
+    measure_baseline();
+
+    for (int fault = SPI_FAULT_NONE + 1; fault < SPI_FAULT_COUNT; fault++) {
+        failures += fault_run(fault, CONFIG_UWB_FAULT_BENCH_TRANSIENT_MS, false);
+        failures += fault_run(fault, CONFIG_UWB_FAULT_BENCH_SUSTAINED_MS, true);
+        runs += 2;
+    }
+
+    dw3000_emul_set_rate(0);
+
+    printk("{\"type\":\"fault_end\",\"runs\":%u,\"baseline_permille\":%u,\"failures\":%d}\n",
+           runs, baseline_permille, failures);
+
+#ifdef CONFIG_ARCH_POSIX
+    posix_exit(failures > 0 ? 1 : 0);
+#endif
+}
+
+void fault_bench_start(void)
+{
+    k_thread_create(&fault_bench_thread, fault_bench_stack, FAULT_BENCH_STACK_SIZE,
+                    fault_bench_thread_fn, NULL, NULL, NULL,
+                    FAULT_BENCH_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&fault_bench_thread, "fault_bench");
+}
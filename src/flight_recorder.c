@@ -0,0 +1,140 @@
+/**
+ * @file flight_recorder.c
+ * @brief Ring of recent frames and events kept in retained RAM
+ *
+ * Writers claim a slot with one atomic increment and fill it in place.
+ * A reader racing a writer that laps it can see a torn entry; the
+ * sequence check after the copy catches all but the slot being written.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fatal.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/reboot.h>
+#include <zephyr/linker/section_tags.h>
+
+#include "flight_recorder.h"
+#include "uart_output.h"
+
+LOG_MODULE_REGISTER(flight_recorder, LOG_LEVEL_INF);
+
+#define ENTRIES     CONFIG_UWB_FLIGHT_RECORDER_ENTRIES
+/* A different ring size invalidates what the previous image left behind */
+#define RING_MAGIC  (0x46524543U ^ ENTRIES)
+
+BUILD_ASSERT((ENTRIES & (ENTRIES - 1)) == 0, "Flight recorder size must be a power of two");
+
+static struct {
+    uint32_t magic;
+    uint32_t boots;
+    atomic_t head;
+    fr_entry_t ring[ENTRIES];
+} rec __noinit;
+
+static bool prev_fatal;
+
+static const char *const type_names[FR_TYPE_COUNT] = {
+    [FR_BOOT] = "boot",
+    [FR_FRAME] = "frame",
+    [FR_STATUS] = "status",
+    [FR_SPI_ERROR] = "spi_error",
+    [FR_RX_ERROR] = "rx_error",
+    [FR_CONFIG] = "config",
+    [FR_SLEEP] = "sleep",
+    [FR_WAKE] = "wake",
+    [FR_SCANNER_STOP] = "scanner_stop",
+    [FR_RESTART] = "restart",
+    [FR_FATAL] = "fatal",
+    [FR_RECOVERY] = "recovery",
+};
+
+void flight_recorder_init(void)
+{
+    fr_entry_t last;
+
+    if (rec.magic == RING_MAGIC) {
+        rec.boots++;
+        prev_fatal = flight_recorder_get(flight_recorder_head() - 1, &last) &&
+                     last.type == FR_FATAL;
+        LOG_INF("Flight recorder kept %u entries from the previous boot%s",
+                flight_recorder_head() - flight_recorder_oldest(),
+                prev_fatal ? " (ended in a fatal error)" : "");
+    } else {
+        /* Cold start: RAM content is undefined */
+        rec.boots = 0;
+        atomic_set(&rec.head, 0);
+        rec.magic = RING_MAGIC;
+    }
+
+    flight_recorder_log(FR_BOOT, (uint16_t)rec.boots, 0, 0);
+}
+
+void flight_recorder_log(fr_type_t type, uint16_t a, uint32_t b, uint32_t c)
+{
+    uint32_t seq = (uint32_t)atomic_inc(&rec.head);
+    fr_entry_t *e = &rec.ring[seq & (ENTRIES - 1)];
+
+    e->time_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+    e->type = (uint8_t)type;
+    e->boot = (uint8_t)rec.boots;
+    e->a = a;
+    e->b = b;
+    e->c = c;
+}
+
+uint32_t flight_recorder_head(void)
+{
+    return (uint32_t)atomic_get(&rec.head);
+}
+
+uint32_t flight_recorder_oldest(void)
+{
+    uint32_t head = flight_recorder_head();
+
+    return head > ENTRIES ? head - ENTRIES : 0;
+}
+
+bool flight_recorder_get(uint32_t seq, fr_entry_t *entry)
+{
+    if (seq >= flight_recorder_head() || seq < flight_recorder_oldest()) {
+        return false;
+    }
+
+    *entry = rec.ring[seq & (ENTRIES - 1)];
+
+    /* Overwritten while copying */
+    return seq >= flight_recorder_oldest();
+}
+
+uint32_t flight_recorder_boots(void)
+{
+    return rec.boots;
+}
+
+bool flight_recorder_prev_fatal(void)
+{
+    return prev_fatal;
+}
+
+const char *flight_recorder_type_name(uint8_t type)
+{
+    if (type < FR_TYPE_COUNT && type_names[type] != NULL) {
+        return type_names[type];
+    }
+
+    return "unknown";
+}
+
+/* Record the fault, write the ring to the console and reboot warm so the
+ * host can fetch it again over the data link after the restart.
+ */
+void k_sys_fatal_error_handler(unsigned int reason, const struct arch_esf *esf)
+{
+    ARG_UNUSED(esf);
+
+    LOG_PANIC();
+    flight_recorder_log(FR_FATAL, (uint16_t)reason, (uint32_t)(uintptr_t)k_current_get(), 0);
+    uart_output_flight_panic();
+    sys_reboot(SYS_REBOOT_WARM);
+}
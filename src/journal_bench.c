@@ -0,0 +1,128 @@
+/**
+ * @file journal_bench.c
+ * @brief Sighting journal spill and flush check on native_sim
+ *
+ * The emulated radio stays silent (no scenario), so every sighting the
+ * journal sees comes from here. With the console host reported away,
+ * sightings go through the normal output path in bursts of a quarter of
+ * the RAM ring, two journal thread passes apart, so the journal thread
+ * spills the older half into the journal_partition on the flash
+ * simulator as it would with a real backlog. The host is then reported
+ * back and the journal thread flushes everything onto the console.
+ *
+ * The check passes when more records were pending than the RAM ring
+ * holds (so flash was used), none was dropped, and the flushed count
+ * equals the sightings fed.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+
+#ifdef CONFIG_ARCH_POSIX
+#include "posix_board_if.h"
+#endif
+
+#include "journal_bench.h"
+#include "sighting_journal.h"
+#include "uart_output.h"
+
+LOG_MODULE_REGISTER(journal_bench, LOG_LEVEL_INF);
+
+#define JOURNAL_BENCH_STACK_SIZE    2048
+#define JOURNAL_BENCH_PRIORITY      6
+#define JOURNAL_BENCH_BURST         (CONFIG_UWB_JOURNAL_RAM_RECORDS / 4)
+#define JOURNAL_BENCH_BURST_MS      200     /* Two journal thread passes */
+#define JOURNAL_BENCH_POLL_MS       10
+#define JOURNAL_BENCH_FLUSH_MS      30000   /* Stop waiting for the flush */
+#define JOURNAL_BENCH_ADDR          0xDECA000000000000ULL
+
+BUILD_ASSERT(CONFIG_UWB_JOURNAL_BENCH_RECORDS > CONFIG_UWB_JOURNAL_RAM_RECORDS,
+             "the journal bench must overflow the RAM ring");
+
+static K_THREAD_STACK_DEFINE(journal_bench_stack, JOURNAL_BENCH_STACK_SIZE);
+static struct k_thread journal_bench_thread;
+
+static void feed_sighting(uint32_t n)
+{
+    uwb_device_info_t info;
+
+    memset(&info, 0, sizeof(info));
+    info.device_addr = JOURNAL_BENCH_ADDR | (n % 64);
+    info.timestamp_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    info.timestamp_ms = (uint32_t)(info.timestamp_us / 1000);
+    info.rssi_dbm = -60.0f - (float)(n % 30);
+    info.channel = 5;
+    info.prf = 64;
+    info.seq_num = (uint8_t)n;
+
+    uart_output_device_info(&info);
+}
+
+static void journal_bench_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    journal_stats_t before, held, after;
+    int failures = 0;
+
+    journal_get_stats(&before, false);
+    uart_output_set_host_connected(false);
+
+    for (uint32_t n = 0; n < CONFIG_UWB_JOURNAL_BENCH_RECORDS; n++) {
+        feed_sighting(n);
+        if ((n + 1) % JOURNAL_BENCH_BURST == 0) {
+            k_sleep(K_MSEC(JOURNAL_BENCH_BURST_MS));
+        }
+    }
+    k_sleep(K_MSEC(JOURNAL_BENCH_BURST_MS));
+
+    journal_get_stats(&held, false);
+
+    int64_t start = k_uptime_get();
+    uart_output_set_host_connected(true);
+
+    do {
+        k_sleep(K_MSEC(JOURNAL_BENCH_POLL_MS));
+        journal_get_stats(&after, false);
+    } while (after.pending > 0 && k_uptime_get() - start < JOURNAL_BENCH_FLUSH_MS);
+
+    uint32_t flush_ms = (uint32_t)(k_uptime_get() - start);
+    uint32_t flushed = after.flushed_total - before.flushed_total;
+    uint32_t dropped = after.dropped_total - before.dropped_total;
+
+    if (held.pending <= CONFIG_UWB_JOURNAL_RAM_RECORDS) {
+        LOG_ERR("%u records pending, the RAM ring holds %u: nothing spilled",
+                held.pending, CONFIG_UWB_JOURNAL_RAM_RECORDS);
+        failures++;
+    }
+    if (dropped > 0) {
+        LOG_ERR("%u records dropped", dropped);
+        failures++;
+    }
+    if (flushed != CONFIG_UWB_JOURNAL_BENCH_RECORDS) {
+        LOG_ERR("%u records flushed, %u fed", flushed, CONFIG_UWB_JOURNAL_BENCH_RECORDS);
+        failures++;
+    }
+
+    printk("{\"type\":\"journal_bench\",\"fed\":%u,\"ram_records\":%u,\"capacity\":%u,"
+           "\"pending\":%u,\"flushed\":%u,\"dropped\":%u,\"flush_ms\":%u,\"pass\":%s}\n",
+           CONFIG_UWB_JOURNAL_BENCH_RECORDS, CONFIG_UWB_JOURNAL_RAM_RECORDS,
+           held.capacity, held.pending, flushed, dropped, flush_ms,
+           failures == 0 ? "true" : "false");
+
+#ifdef CONFIG_ARCH_POSIX
+    posix_exit(failures > 0 ? 1 : 0);
+#endif
+}
+
+void journal_bench_start(void)
+{
+    k_thread_create(&journal_bench_thread, journal_bench_stack, JOURNAL_BENCH_STACK_SIZE,
+                    journal_bench_thread_fn, NULL, NULL, NULL,
+                    JOURNAL_BENCH_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&journal_bench_thread, "journal_bench");
+}
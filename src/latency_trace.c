@@ -0,0 +1,184 @@
+/**
+ * @file latency_trace.c
+ * @brief Per-frame latency histograms
+ *
+ * Durations are kept in microseconds in registered log-linear
+ * histograms: four buckets per power of two, so a reported percentile is
+ * within 25% of the true value. Recording is a handful of atomic
+ * operations and safe from the CDC ACM interrupt.
+ */
+
+#include <zephyr/kernel.h>
+#include <stdio.h>
+
+#include "latency_trace.h"
+#include "metrics.h"
+
+/* Reported in latency_stage_t order */
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    "air", "read", "parse", "serialize", "sink", "pipeline", "total",
+};
+
+#define SUB_BITS        2
+
+METRIC_HISTOGRAM_SUB_DEFINE(latency_air_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_read_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_parse_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_serialize_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_sink_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_pipeline_us, SUB_BITS);
+METRIC_HISTOGRAM_SUB_DEFINE(latency_total_us, SUB_BITS);
+
+static struct metric *const hist[LATENCY_STAGE_COUNT] = {
+    [LATENCY_STAGE_AIR] = &latency_air_us,
+    [LATENCY_STAGE_READ] = &latency_read_us,
+    [LATENCY_STAGE_PARSE] = &latency_parse_us,
+    [LATENCY_STAGE_SERIALIZE] = &latency_serialize_us,
+    [LATENCY_STAGE_SINK] = &latency_sink_us,
+    [LATENCY_STAGE_PIPELINE] = &latency_pipeline_us,
+    [LATENCY_STAGE_TOTAL] = &latency_total_us,
+};
+
+static atomic_t frames;
+static atomic_t lost;
+
+/* Traces waiting for the CDC link to drain their record */
+#define PENDING_SLOTS   8
+
+static struct {
+    latency_trace_t trace;
+    uint32_t end;
+} pending[PENDING_SLOTS];
+static uint32_t pending_head;
+static uint32_t pending_count;
+static struct k_spinlock pending_lock;
+
+static void stage_observe(latency_stage_t stage, uint32_t us)
+{
+    metric_observe(hist[stage], us);
+}
+
+static uint32_t span_us(const latency_trace_t *trace, latency_mark_t from, latency_mark_t to)
+{
+    timing_t start = trace->t[from];
+    timing_t end = trace->t[to];
+
+    return (uint32_t)(timing_cycles_to_ns(timing_cycles_get(&start, &end)) / 1000U);
+}
+
+void latency_trace_init(void)
+{
+    timing_init();
+    timing_start();
+}
+
+void latency_trace_set_air(latency_trace_t *trace, bool valid, uint64_t rx_time_ns)
+{
+    trace->air_us = LATENCY_AIR_UNKNOWN;
+    if (!valid) {
+        return;
+    }
+
+    /* Uptime has tick resolution; the RX instant precedes it by the poll delay */
+    uint64_t now_ns = k_ticks_to_ns_floor64(k_uptime_ticks());
+    uint64_t ready_ns = span_us(trace, LATENCY_MARK_READY, LATENCY_MARK_PARSE) * 1000ULL;
+
+    if (now_ns > rx_time_ns + ready_ns) {
+        trace->air_us = (uint32_t)((now_ns - rx_time_ns - ready_ns) / 1000U);
+    } else {
+        trace->air_us = 0;
+    }
+}
+
+void latency_trace_record(const latency_trace_t *trace)
+{
+    uint32_t pipeline = span_us(trace, LATENCY_MARK_READY, LATENCY_MARK_SINK);
+
+    stage_observe(LATENCY_STAGE_READ, span_us(trace, LATENCY_MARK_READY, LATENCY_MARK_READ));
+    stage_observe(LATENCY_STAGE_PARSE, span_us(trace, LATENCY_MARK_READ, LATENCY_MARK_PARSE));
+    stage_observe(LATENCY_STAGE_SERIALIZE, span_us(trace, LATENCY_MARK_PARSE, LATENCY_MARK_SERIALIZE));
+    stage_observe(LATENCY_STAGE_SINK, span_us(trace, LATENCY_MARK_SERIALIZE, LATENCY_MARK_SINK));
+    stage_observe(LATENCY_STAGE_PIPELINE, pipeline);
+
+    if (trace->air_us != LATENCY_AIR_UNKNOWN) {
+        stage_observe(LATENCY_STAGE_AIR, trace->air_us);
+        stage_observe(LATENCY_STAGE_TOTAL, trace->air_us + pipeline);
+    }
+
+    atomic_inc(&frames);
+}
+
+void latency_trace_defer(const latency_trace_t *trace, uint32_t end)
+{
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+    if (pending_count == PENDING_SLOTS) {
+        /* Link stalled (host closed the port?): give up on the oldest */
+        pending_head = (pending_head + 1) % PENDING_SLOTS;
+        pending_count--;
+        atomic_inc(&lost);
+    }
+
+    uint32_t slot = (pending_head + pending_count) % PENDING_SLOTS;
+    pending[slot].trace = *trace;
+    pending[slot].end = end;
+    pending_count++;
+
+    k_spin_unlock(&pending_lock, key);
+}
+
+void latency_trace_drained(uint32_t drained)
+{
+    timing_t now = timing_counter_get();
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+    while (pending_count > 0 &&
+           (int32_t)(drained - pending[pending_head].end) >= 0) {
+        latency_trace_t *trace = &pending[pending_head].trace;
+
+        trace->t[LATENCY_MARK_SINK] = now;
+        latency_trace_record(trace);
+
+        pending_head = (pending_head + 1) % PENDING_SLOTS;
+        pending_count--;
+    }
+
+    k_spin_unlock(&pending_lock, key);
+}
+
+int latency_trace_format(char *buf, size_t size)
+{
+    int len = snprintf(buf, size,
+        "{\"type\":\"latency\",\"frames\":%u,\"lost\":%u,\"us\":{",
+        (uint32_t)atomic_get(&frames), (uint32_t)atomic_get(&lost));
+
+    for (int i = 0; i < LATENCY_STAGE_COUNT && len > 0 && (size_t)len < size; i++) {
+        const struct metric *h = hist[i];
+
+        len += snprintf(buf + len, size - len,
+            "%s\"%s\":{\"n\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u}",
+            i > 0 ? "," : "", stage_names[i], metric_get(h),
+            metric_percentile(h, 500), metric_percentile(h, 990), metric_max(h));
+    }
+
+    if (len > 0 && (size_t)len < size) {
+        len += snprintf(buf + len, size - len, "}}\r\n");
+    }
+
+    return len > 0 && (size_t)len < size ? len : -ENOMEM;
+}
+
+uint32_t latency_trace_percentile(latency_stage_t stage, uint32_t permille)
+{
+    return metric_percentile(hist[stage], permille);
+}
+
+void latency_trace_reset(void)
+{
+    for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        metric_reset(hist[i]);
+    }
+
+    atomic_clear(&frames);
+    atomic_clear(&lost);
+}
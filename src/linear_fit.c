@@ -0,0 +1,73 @@
+/**
+ * @file linear_fit.c
+ * @brief Incremental exponentially weighted least-squares line fit
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "linear_fit.h"
+
+void linear_fit_init(linear_fit_t *fit, double forget)
+{
+    memset(fit, 0, sizeof(*fit));
+    fit->forget = forget;
+}
+
+/* Move the fit origin by (dt, dd) without touching the fitted line */
+static void linear_fit_shift(linear_fit_t *fit, double dt, double dd)
+{
+    double st = fit->st;
+    double sd = fit->sd;
+
+    fit->st = st - dt * fit->sw;
+    fit->sd = sd - dd * fit->sw;
+    fit->stt = fit->stt - 2.0 * dt * st + dt * dt * fit->sw;
+    fit->std = fit->std - dt * sd - dd * st + dt * dd * fit->sw;
+}
+
+void linear_fit_add(linear_fit_t *fit, int64_t x, int64_t y)
+{
+    if (fit->count > 0) {
+        linear_fit_shift(fit, (double)(x - fit->x0), (double)(y - fit->y0));
+    }
+    fit->x0 = x;
+    fit->y0 = y;
+
+    /* Decay old samples and add the new one, which sits at the origin */
+    fit->sw = fit->sw * fit->forget + 1.0;
+    fit->st *= fit->forget;
+    fit->sd *= fit->forget;
+    fit->stt *= fit->forget;
+    fit->std *= fit->forget;
+    fit->count++;
+
+    double den = fit->sw * fit->stt - fit->st * fit->st;
+    if (fit->count >= 2 && den > 0.0) {
+        fit->b = (fit->sw * fit->std - fit->st * fit->sd) / den;
+        fit->a = (fit->sd - fit->b * fit->st) / fit->sw;
+    } else {
+        fit->a = 0.0;
+        fit->b = 0.0;
+    }
+}
+
+int64_t linear_fit_eval(const linear_fit_t *fit, int64_t x)
+{
+    return fit->y0 + llround(fit->a + fit->b * (double)(x - fit->x0));
+}
+
+double linear_fit_residual(const linear_fit_t *fit, int64_t x, int64_t y)
+{
+    double dt = (double)(x - fit->x0);
+    double dd = (double)(y - fit->y0);
+
+    return dd - (fit->a + fit->b * dt);
+}
+
+void linear_fit_rebase(linear_fit_t *fit, int64_t x, int64_t y)
+{
+    /* Sums are relative to the origin, so moving it translates the history */
+    fit->x0 = x;
+    fit->y0 = y - llround(fit->a);
+}
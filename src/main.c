@@ -12,32 +12,43 @@
 
 #include "uwb_scanner.h"
 #include "uart_output.h"
+#include "uart_input.h"
+#include "command.h"
+#include "scanner_config.h"
+#include "scanner_settings.h"
 #include "version.h"
+#include "metrics.h"
+#include "latency_trace.h"
+#include "spi_profile.h"
+#include "flight_recorder.h"
+#include "bench.h"
+#include "fault_bench.h"
+#include "boot_bench.h"
+#include "journal_bench.h"
 
 LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
 
 /* Statistics */
-static uint32_t devices_detected = 0;
+METRIC_DECLARE(scanner_sightings);
+METRIC_COUNTER_DEFINE(scanner_restarts);
 static uint32_t scan_start_time = 0;
 
 /* Device discovery callback */
 static void on_device_found(const uwb_device_info_t *info)
 {
-    devices_detected++;
-
     /* Output device information via UART */
     uart_output_device_info(info);
 
     /* Log summary */
-    LOG_INF("Device #%u: addr=0x%016llX, dist=%.2f cm, RSSI=%.2f dBm",
-           devices_detected,
+    LOG_INF("Sighting #%u: addr=0x%016llX, dist=%.2f cm, RSSI=%.2f dBm",
+           (uint32_t)metric_get(&scanner_sightings) + 1,
            info->device_addr,
            (double)info->distance_cm,
            (double)info->rssi_dbm);
 }
 
-/* Statistics thread */
-#define STATS_THREAD_STACK_SIZE 1024
+/* Statistics thread; formats metrics, threads, latency and SPI records with float cbprintf */
+#define STATS_THREAD_STACK_SIZE 2048
 #define STATS_THREAD_PRIORITY 7
 
 static K_THREAD_STACK_DEFINE(stats_stack, STATS_THREAD_STACK_SIZE);
@@ -51,42 +62,81 @@ static void stats_thread_fn(void *arg1, void *arg2, void *arg3)
     ARG_UNUSED(arg3);
 
     while (stats_active) {
-        /* Wait 10 seconds */
-        k_sleep(K_SECONDS(10));
+        k_sleep(K_MSEC(CONFIG_UWB_METRICS_INTERVAL_MS));
 
-        /* Calculate and output statistics */
-        uint32_t uptime = k_uptime_get_32();
-        uint32_t scan_duration = (uptime - scan_start_time) / 1000;
+        /* Periodic metrics snapshot for the host */
+        uart_output_metrics(UART_CHANNEL_DATA);
+#ifdef CONFIG_UWB_THREAD_STATS
+        uart_output_threads(UART_CHANNEL_DATA);
+#endif
+#ifdef CONFIG_UWB_LATENCY_TRACE
+        uart_output_latency(UART_CHANNEL_DATA, false);
+#endif
+#ifdef CONFIG_UWB_SPI_PROFILE
+        uart_output_spi_summary(UART_CHANNEL_DATA);
+#endif
 
-        char status_msg[128];
-        snprintf(status_msg, sizeof(status_msg),
-                "Uptime: %u s, Devices detected: %u, Scan duration: %u s",
-                uptime / 1000, devices_detected, scan_duration);
+        uint32_t uptime = k_uptime_get_32();
+        LOG_INF("Statistics: uptime %u s, sightings %u, scan duration %u s",
+                uptime / 1000, (uint32_t)metric_get(&scanner_sightings),
+                (uptime - scan_start_time) / 1000);
+    }
+}
 
-        uart_output_status(status_msg);
+#ifdef CONFIG_USB_DEVICE_STACK
+/* Enumeration completes on the host's schedule, in parallel with bring-up */
+static void usb_status_cb(enum usb_dc_status_code status, const uint8_t *param)
+{
+    ARG_UNUSED(param);
 
-        LOG_INF("Statistics: %s", status_msg);
+    if (status == USB_DC_CONFIGURED) {
+        LOG_INF("USB configured after %u ms", k_uptime_get_32());
     }
 }
+#endif
+
+/* Microseconds since boot, for boot phase timestamps */
+static uint32_t boot_us(void)
+{
+    return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+/* Radio bring-up, run next to output init and joined before scanning */
+#define RADIO_INIT_STACK_SIZE 4096
+#define RADIO_INIT_PRIORITY -1     /* Ahead of main, which runs while it waits on the chip */
+
+static K_THREAD_STACK_DEFINE(radio_init_stack, RADIO_INIT_STACK_SIZE);
+static struct k_thread radio_init_thread;
+static int radio_init_result;
+static uint32_t radio_init_us;
+
+static void radio_init_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    radio_init_result = uwb_scanner_init(on_device_found);
+    radio_init_us = boot_us();
+}
 
 int main(void)
 {
     int ret;
+    uart_output_boot_t boot = {0};
 
 #ifdef CONFIG_USB_DEVICE_STACK
-    /* Initialize USB device */
-    ret = usb_enable(NULL);
+    /*
+     * Enable USB without waiting for enumeration; output and input work on
+     * unopened interfaces and sightings are journaled until the host
+     * connects.
+     */
+    ret = usb_enable(usb_status_cb);
     if (ret != 0) {
         LOG_ERR("Failed to enable USB: %d", ret);
     } else {
         LOG_INF("USB device enabled");
     }
-
-    /* Wait for USB to be ready and enumerated */
-    k_sleep(K_MSEC(1000));
-#else
-    /* Wait for console to be ready */
-    k_sleep(K_MSEC(100));
 #endif
 
     LOG_INF("==============================================");
@@ -99,6 +149,35 @@ int main(void)
     LOG_INF("Board:        %s", CONFIG_BOARD);
     LOG_INF("==============================================");
 
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+    flight_recorder_init();
+#endif
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    latency_trace_init();
+#endif
+#ifdef CONFIG_UWB_SPI_PROFILE
+    spi_profile_init();
+#endif
+
+    /*
+     * Stored settings before anything concurrent: output, input and the
+     * radio all read the configuration, and their updates must not be
+     * overwritten by a late init.
+     */
+    scanner_config_t stored;
+    bool have_stored = false;
+
+#ifdef CONFIG_UWB_SETTINGS
+    have_stored = scanner_settings_init() == 0 && scanner_settings_get_config(&stored);
+#endif
+    scanner_config_init(have_stored ? &stored : NULL);
+
+    /* DW3000 reset and probe take milliseconds, overlap them with output init */
+    k_thread_create(&radio_init_thread, radio_init_stack, RADIO_INIT_STACK_SIZE,
+                    radio_init_thread_fn, NULL, NULL, NULL,
+                    RADIO_INIT_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&radio_init_thread, "radio_init");
+
     /* Initialize UART output */
     ret = uart_output_init();
     if (ret < 0) {
@@ -107,15 +186,25 @@ int main(void)
         return ret;
     }
 
+    /* Host commands are optional, scanning works without them */
+    ret = uart_input_init(command_handle_line);
+    if (ret < 0) {
+        LOG_WRN("Host input unavailable: %d", ret);
+    }
+    boot.output_us = boot_us();
+
     uart_output_status("Initializing UWB scanner...");
 
-    /* Initialize UWB scanner */
-    ret = uwb_scanner_init(on_device_found);
+    /* Wait for the radio bring-up started above */
+    k_thread_join(&radio_init_thread, K_FOREVER);
+    ret = radio_init_result;
     if (ret < 0) {
         LOG_ERR("Failed to initialize UWB scanner: %d", ret);
         uart_output_error("UWB scanner initialization failed");
         return ret;
     }
+    boot.radio_us = radio_init_us;
+    boot.warm = uwb_scanner_is_warm_boot();
 
     uart_output_status("UWB scanner initialized");
 
@@ -127,15 +216,42 @@ int main(void)
         uart_output_error("Failed to start scanner");
         return ret;
     }
+    boot.scan_us = boot_us();
+
+    uart_output_boot(&boot);
+    LOG_INF("Scanner started %u us after boot (output %u us, radio %u us, %s)",
+            boot.scan_us, boot.output_us, boot.radio_us, boot.warm ? "warm" : "cold");
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+    /* What led up to the fault, sent once the host is there */
+    if (flight_recorder_prev_fatal()) {
+        uart_output_flight(UART_CHANNEL_DATA);
+    }
+#endif
+
+#ifdef CONFIG_UWB_BENCH
+    bench_start();
+#endif
+
+#ifdef CONFIG_UWB_FAULT_BENCH
+    fault_bench_start();
+#endif
+
+#ifdef CONFIG_UWB_BOOT_BENCH
+    boot_bench_start(&boot);
+#endif
 
-    uart_output_status("Scanning started");
-    LOG_INF("Scanner started successfully");
+#ifdef CONFIG_UWB_JOURNAL_BENCH
+    journal_bench_start();
+#endif
 
-    /* Start statistics thread */
-    k_thread_create(&stats_thread, stats_stack, STATS_THREAD_STACK_SIZE,
-                   stats_thread_fn, NULL, NULL, NULL,
-                   STATS_THREAD_PRIORITY, 0, K_NO_WAIT);
-    k_thread_name_set(&stats_thread, "statistics");
+    /* Start statistics thread; with no interval metrics are on demand */
+    if (CONFIG_UWB_METRICS_INTERVAL_MS > 0) {
+        k_thread_create(&stats_thread, stats_stack, STATS_THREAD_STACK_SIZE,
+                       stats_thread_fn, NULL, NULL, NULL,
+                       STATS_THREAD_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&stats_thread, "statistics");
+    }
 
     /* Main loop - just keep running */
     while (1) {
@@ -145,13 +261,19 @@ int main(void)
         if (!uwb_scanner_is_active()) {
             LOG_WRN("Scanner stopped unexpectedly");
             uart_output_error("Scanner stopped");
+            FLIGHT_RECORD(FR_SCANNER_STOP, 0, 0, 0);
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+            uart_output_flight(UART_CHANNEL_DATA);
+#endif
 
             /* Try to restart */
             k_sleep(K_SECONDS(1));
             ret = uwb_scanner_start();
+            FLIGHT_RECORD(FR_RESTART, 0, ret, 0);
             if (ret < 0) {
                 LOG_ERR("Failed to restart scanner: %d", ret);
             } else {
+                metric_inc(&scanner_restarts);
                 uart_output_status("Scanner restarted");
             }
         }
@@ -0,0 +1,137 @@
+/**
+ * @file metrics.c
+ * @brief Metrics snapshot serialization
+ *
+ * Values are read one atomic at a time, so a snapshot taken while other
+ * threads update is consistent per metric but not across metrics.
+ */
+
+#include <zephyr/kernel.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "metrics.h"
+
+/* Append to buf, tracking the total length; false once it overflows */
+static bool append(char *buf, size_t size, int *len, const char *fmt, ...)
+{
+    va_list args;
+
+    if (*len < 0 || (size_t)*len >= size) {
+        return false;
+    }
+
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *len, size - *len, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)(*len + n) >= size) {
+        *len = -1;
+        return false;
+    }
+
+    *len += n;
+    return true;
+}
+
+/* Log2 bucket a histogram bucket falls into */
+static unsigned int log2_bucket(const struct metric *m, unsigned int bucket)
+{
+    if (bucket < (1U << m->sub_bits)) {
+        return bucket == 0 ? 0 : 32 - __builtin_clz(bucket);
+    }
+
+    return (bucket >> m->sub_bits) + m->sub_bits;
+}
+
+/* Largest value that falls into a histogram bucket */
+static uint32_t bucket_upper(const struct metric *m, unsigned int bucket)
+{
+    unsigned int sub_bits = m->sub_bits;
+
+    if (bucket == METRIC_HIST_SIZE(sub_bits) - 1) {
+        return UINT32_MAX;
+    }
+    if (bucket < (1U << sub_bits)) {
+        return bucket;
+    }
+
+    unsigned int shift = (bucket >> sub_bits) - 1;
+    uint32_t lower = ((1U << sub_bits) + (bucket & ((1U << sub_bits) - 1))) << shift;
+
+    return lower + (1U << shift) - 1;
+}
+
+uint32_t metric_percentile(const struct metric *m, uint32_t permille)
+{
+    uint32_t count = metric_get(m);
+    uint32_t rank = (uint32_t)(((uint64_t)count * permille + 999) / 1000);
+    uint32_t seen = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < METRIC_HIST_SIZE(m->sub_bits); i++) {
+        seen += (uint32_t)atomic_get(&m->buckets[i]);
+        if (seen >= rank) {
+            return MIN(bucket_upper(m, i), metric_max(m));
+        }
+    }
+
+    return metric_max(m);
+}
+
+void metric_reset(struct metric *m)
+{
+    atomic_clear(&m->value);
+    atomic_clear(&m->sum);
+    atomic_clear(&m->max);
+
+    if (m->type == METRIC_HISTOGRAM) {
+        for (unsigned int i = 0; i < METRIC_HIST_SIZE(m->sub_bits); i++) {
+            atomic_clear(&m->buckets[i]);
+        }
+    }
+}
+
+int metrics_format(char *buf, size_t size)
+{
+    int len = 0;
+    bool first = true;
+
+    append(buf, size, &len, "{\"type\":\"metrics\",\"uptime_ms\":%u", k_uptime_get_32());
+
+    STRUCT_SECTION_FOREACH(metric, m) {
+        append(buf, size, &len, "%s\"%s\":", first ? ",\"m\":{" : ",", m->name);
+        first = false;
+
+        if (m->type != METRIC_HISTOGRAM) {
+            append(buf, size, &len, "%d", (int)atomic_get(&m->value));
+            continue;
+        }
+
+        uint32_t buckets[METRIC_HIST_BUCKETS] = {0};
+
+        for (unsigned int i = 0; i < METRIC_HIST_SIZE(m->sub_bits); i++) {
+            buckets[log2_bucket(m, i)] += (uint32_t)atomic_get(&m->buckets[i]);
+        }
+
+        int last = METRIC_HIST_BUCKETS - 1;
+        while (last >= 0 && buckets[last] == 0) {
+            last--;
+        }
+
+        append(buf, size, &len, "[%u,%u", (uint32_t)atomic_get(&m->value),
+               (uint32_t)atomic_get(&m->sum));
+        for (int i = 0; i <= last; i++) {
+            append(buf, size, &len, ",%u", buckets[i]);
+        }
+        append(buf, size, &len, "]");
+    }
+
+    append(buf, size, &len, "%s}\r\n", first ? "" : "}");
+
+    return len < 0 ? -ENOMEM : len;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file replay.c
+ * @brief Capture replay into the emulated DW3000 (native_sim)
+ *
+ * Reads a trace written by scripts/capture_replay.py from the host file
+ * given with --replay and feeds its frames to the emulator, with arrival
+ * times divided by --replay-speed (0 sends each frame as soon as the
+ * receiver can take it). Once the trace is exhausted and the output has
+ * settled, sends a "replay_end" record and exits.
+ *
+ * Trace lines: t_us device_addr(hex) seq rssi_dbm fpp_index fpp_level frame_quality
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "posix_board_if.h"
+#include "posix_native_task.h"
+#include "cmdline.h"
+#include "nsi_host_trampolines.h"
+
+#include "dw3000_emul.h"
+#include "frame_parse.h"
+
+LOG_MODULE_REGISTER(replay, LOG_LEVEL_INF);
+
+#define REPLAY_STACK_SIZE   1024
+#define REPLAY_PRIORITY     9
+#define REPLAY_LEAD_MS      2000    /* Scanner up before the first frame */
+#define REPLAY_SETTLE_MS    2000    /* Output drained after the last frame */
+#define REPLAY_POLL_MS      100
+#define REPLAY_PAYLOAD      12      /* Not recorded, only sets the airtime */
+#define REPLAY_PAN_ID       0xDECA
+
+static char *replay_path;
+static double replay_speed = 1.0;
+
+static int replay_fd = -1;
+static char buf[4096];
+static size_t buf_len;
+static size_t buf_pos;
+static bool have_origin;
+static uint64_t origin_us;
+static uint32_t bad_lines;
+static atomic_t finished;
+
+static K_THREAD_STACK_DEFINE(replay_stack, REPLAY_STACK_SIZE);
+static struct k_thread replay_thread;
+
+static bool read_line(char *line, size_t size)
+{
+    size_t n = 0;
+
+    while (true) {
+        if (buf_pos == buf_len) {
+            long ret = nsi_host_read(replay_fd, buf, sizeof(buf));
+            if (ret <= 0) {
+                line[n] = '\0';
+                return n > 0;
+            }
+            buf_len = (size_t)ret;
+            buf_pos = 0;
+        }
+
+        char c = buf[buf_pos++];
+        if (c == '\n') {
+            line[n] = '\0';
+            return true;
+        }
+        if (n < size - 1) {
+            line[n++] = c;
+        }
+    }
+}
+
+/* Data frame, broadcast destination, the recorded source address */
+static void build_frame(scenario_frame_t *frame, uint64_t addr, uint8_t seq)
+{
+    bool extended = addr > 0xFFFF;
+    uint16_t fcf = IEEE154_FRAME_TYPE_DATA | 0x40 | (IEEE154_ADDR_SHORT << 10) |
+                   ((extended ? IEEE154_ADDR_EXTENDED : IEEE154_ADDR_SHORT) << 14);
+    uint8_t *p = frame->data;
+
+    *p++ = fcf & 0xFF;
+    *p++ = fcf >> 8;
+    *p++ = seq;
+    *p++ = REPLAY_PAN_ID & 0xFF;
+    *p++ = REPLAY_PAN_ID >> 8;
+    *p++ = 0xFF;
+    *p++ = 0xFF;
+    for (int i = 0; i < (extended ? 8 : 2); i++) {
+        *p++ = (uint8_t)(addr >> (i * 8));
+    }
+    memset(p, 0, REPLAY_PAYLOAD + 2);
+    p += REPLAY_PAYLOAD + 2;
+
+    frame->length = (uint16_t)(p - frame->data);
+}
+
+static bool parse_line(const char *line, scenario_frame_t *frame)
+{
+    char *p;
+    uint64_t t_us = strtoull(line, &p, 10);
+    uint64_t addr = strtoull(p, &p, 16);
+    unsigned long seq = strtoul(p, &p, 10);
+
+    frame->rssi_dbm = strtof(p, &p);
+    frame->fp_index = (uint16_t)strtoul(p, &p, 10);
+    frame->fp_level_db = strtof(p, &p);
+
+    char *end;
+    frame->quality = (uint8_t)strtoul(p, &end, 10);
+    if (end == p || addr == 0) {
+        return false;
+    }
+
+    if (!have_origin) {
+        origin_us = t_us;
+        have_origin = true;
+    }
+
+    build_frame(frame, addr, (uint8_t)seq);
+    frame->at_ns = (uint64_t)REPLAY_LEAD_MS * NSEC_PER_MSEC;
+    if (replay_speed > 0.0 && t_us > origin_us) {
+        frame->at_ns += (uint64_t)((double)(t_us - origin_us) * NSEC_PER_USEC / replay_speed);
+    }
+    scenario_frame_timing(frame);
+    frame->tag = 0;
+    frame->corrupt = false;
+
+    return true;
+}
+
+static bool replay_next(scenario_frame_t *frame)
+{
+    char line[128];
+
+    while (read_line(line, sizeof(line))) {
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        if (parse_line(line, frame)) {
+            return true;
+        }
+        bad_lines++;
+    }
+
+    atomic_set(&finished, 1);
+    return false;
+}
+
+static void replay_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    dw3000_emul_stats_t radio;
+
+    while (!atomic_get(&finished)) {
+        k_sleep(K_MSEC(REPLAY_POLL_MS));
+    }
+    k_sleep(K_MSEC(REPLAY_SETTLE_MS));
+
+    dw3000_emul_take_stats(&radio);
+    nsi_host_close(replay_fd);
+
+    printk("{\"type\":\"replay_end\",\"speed_permille\":%u,\"frames\":%u,\"received\":%u,"
+           "\"missed\":%u,\"bad_lines\":%u}\n",
+           (uint32_t)(replay_speed * 1000), radio.generated, radio.received,
+           radio.missed, bad_lines);
+
+    posix_exit(0);
+}
+
+static int replay_init(void)
+{
+    if (replay_path == NULL) {
+        return 0;
+    }
+
+    replay_fd = nsi_host_open(replay_path, 0);     /* O_RDONLY */
+    if (replay_fd < 0) {
+        LOG_ERR("Cannot open %s", replay_path);
+        posix_exit(1);
+    }
+
+    LOG_INF("Replaying %s, speed %u/1000 (0: as fast as possible)", replay_path,
+            (uint32_t)(replay_speed * 1000));
+
+    dw3000_emul_set_source(replay_next, replay_speed <= 0.0);
+
+    k_thread_create(&replay_thread, replay_stack, REPLAY_STACK_SIZE,
+                    replay_thread_fn, NULL, NULL, NULL,
+                    REPLAY_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&replay_thread, "replay");
+
+    return 0;
+}
+
+SYS_INIT(replay_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+static void replay_options(void)
+{
+    static struct args_struct_t options[] = {
+        {
+            .option = "replay",
+            .name = "file",
+            .type = 's',
+            .dest = (void *)&replay_path,
+            .descript = "Feed a trace from scripts/capture_replay.py to the emulated DW3000",
+        },
+        {
+            .option = "replay-speed",
+            .name = "factor",
+            .type = 'd',
+            .dest = (void *)&replay_speed,
+            .descript = "Replay speed multiplier, 0 for as fast as the scanner takes "
+                        "frames (default 1)",
+        },
+        ARG_TABLE_ENDMARKER,
+    };
+
+    native_add_command_line_opts(options);
+}
+
+NATIVE_TASK(replay_options, PRE_BOOT_1, 10);
@@ -0,0 +1,265 @@
+/**
+ * @file scanner_config.c
+ * @brief Versioned runtime configuration of the scanner
+ *
+ * Two snapshot slots, RCU style. Readers pin the active slot with a
+ * per-slot reader count; a writer fills the inactive slot once its last
+ * reader has left and then flips the active index atomically. Readers
+ * never block and always see a complete snapshot.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+
+#include "scanner_config.h"
+#include "uart_output.h"
+
+LOG_MODULE_REGISTER(scanner_config, LOG_LEVEL_INF);
+
+/* A reader holds a snapshot for one scan cycle at most */
+#define GRACE_TIMEOUT_MS 1000
+
+static const scanner_config_t config_defaults = {
+    .version = 0,
+    .radio = {
+        .channel = DW3000_CHANNEL_5,
+        .prf = DW3000_PRF_64M,
+        .preamble_length = DW3000_PLEN_128,
+        .pac_size = 8,
+        .tx_preamble_code = 9,
+        .rx_preamble_code = 9,
+    },
+    .rx_window_ms = 50,
+    .sleep_ms = 0,
+    .power_profile = SCANNER_POWER_FULL,
+    .min_rssi_dbm = -200.0f,
+    .min_frame_quality = 0,
+    .output_mode = SCANNER_CONFIG_OUTPUT_AUTO,
+    .allow_count = 0,
+};
+
+/* Supported preamble lengths */
+static const struct {
+    uint8_t code;
+    uint16_t symbols;
+} plen_table[] = {
+    {DW3000_PLEN_64, 64},
+    {DW3000_PLEN_128, 128},
+    {DW3000_PLEN_256, 256},
+};
+
+static const char *const power_names[SCANNER_POWER_COUNT] = {
+    [SCANNER_POWER_FULL] = "full",
+    [SCANNER_POWER_SNIFF] = "sniff",
+};
+
+static scanner_config_t slots[2];
+static atomic_t active;
+static atomic_t readers[2];
+
+static K_MUTEX_DEFINE(writer_lock);
+
+/* Fill in radio settings that follow from the power profile */
+static void config_derive(scanner_config_t *config)
+{
+    config->radio.sniff_on_pac = 0;
+    config->radio.sniff_off = 0;
+
+    if (config->power_profile == SCANNER_POWER_SNIFF &&
+        dw3000_sniff_timing(&config->radio,
+                            scanner_config_plen_symbols(config->radio.preamble_length)) < 0) {
+        LOG_WRN("Preamble too short to sniff, receiver stays fully on");
+    }
+}
+
+int scanner_config_init(const scanner_config_t *initial)
+{
+    const scanner_config_t *config = initial != NULL ? initial : &config_defaults;
+
+    if (scanner_config_validate(config) < 0) {
+        LOG_WRN("Invalid initial configuration, using defaults");
+        config = &config_defaults;
+    }
+
+    k_mutex_lock(&writer_lock, K_FOREVER);
+    slots[0] = *config;
+    slots[0].version = 1;
+    config_derive(&slots[0]);
+    atomic_set(&active, 0);
+    k_mutex_unlock(&writer_lock);
+
+    return 0;
+}
+
+const scanner_config_t *scanner_config_acquire(void)
+{
+    atomic_val_t idx;
+
+    /* Retry if the writer flipped slots between reading and pinning */
+    do {
+        idx = atomic_get(&active);
+        atomic_inc(&readers[idx]);
+        if (atomic_get(&active) == idx) {
+            break;
+        }
+        atomic_dec(&readers[idx]);
+    } while (true);
+
+    return &slots[idx];
+}
+
+void scanner_config_release(const scanner_config_t *config)
+{
+    atomic_dec(&readers[config - slots]);
+}
+
+void scanner_config_get(scanner_config_t *config)
+{
+    const scanner_config_t *current = scanner_config_acquire();
+
+    *config = *current;
+    scanner_config_release(current);
+}
+
+int scanner_config_validate(const scanner_config_t *config)
+{
+    const dw3000_config_t *radio = &config->radio;
+
+    if (radio->channel != DW3000_CHANNEL_5 && radio->channel != DW3000_CHANNEL_9) {
+        return -EINVAL;
+    }
+
+    if (radio->prf != DW3000_PRF_64M && radio->prf != DW3000_PRF_16M) {
+        return -EINVAL;
+    }
+
+    /* Preamble codes 9-12 are the 64 MHz PRF codes, 1-8 the 16 MHz ones */
+    uint16_t code_min = radio->prf == DW3000_PRF_64M ? 9 : 1;
+    uint16_t code_max = radio->prf == DW3000_PRF_64M ? 12 : 8;
+    if (radio->rx_preamble_code < code_min || radio->rx_preamble_code > code_max ||
+        radio->tx_preamble_code < code_min || radio->tx_preamble_code > code_max) {
+        return -EINVAL;
+    }
+
+    if (scanner_config_plen_symbols(radio->preamble_length) == 0) {
+        return -EINVAL;
+    }
+
+    if (radio->pac_size != 4 && radio->pac_size != 8 &&
+        radio->pac_size != 16 && radio->pac_size != 32) {
+        return -EINVAL;
+    }
+
+    if (config->rx_window_ms < 1 || config->rx_window_ms > 1000) {
+        return -EINVAL;
+    }
+
+    if (config->sleep_ms > 60000) {
+        return -EINVAL;
+    }
+
+    if (config->power_profile >= SCANNER_POWER_COUNT) {
+        return -EINVAL;
+    }
+
+    if (config->output_mode != SCANNER_CONFIG_OUTPUT_AUTO &&
+        (config->output_mode < 0 || config->output_mode >= UART_OUTPUT_MODE_COUNT)) {
+        return -EINVAL;
+    }
+
+    if (config->allow_count > CONFIG_UWB_ALLOW_LIST_SIZE) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+bool scanner_config_allows(const scanner_config_t *config, uint64_t device_addr)
+{
+    if (config->allow_count == 0) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < config->allow_count; i++) {
+        if (config->allow_list[i] == device_addr) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int scanner_config_update(const scanner_config_t *config)
+{
+    int ret = scanner_config_validate(config);
+    if (ret < 0) {
+        return ret;
+    }
+
+    k_mutex_lock(&writer_lock, K_FOREVER);
+
+    atomic_val_t current = atomic_get(&active);
+    atomic_val_t next = !current;
+
+    /* Grace period: wait for readers still on the previous snapshot */
+    int64_t deadline = k_uptime_get() + GRACE_TIMEOUT_MS;
+    while (atomic_get(&readers[next]) != 0) {
+        if (k_uptime_get() >= deadline) {
+            k_mutex_unlock(&writer_lock);
+            return -ETIMEDOUT;
+        }
+        k_sleep(K_MSEC(1));
+    }
+
+    slots[next] = *config;
+    slots[next].version = slots[current].version + 1;
+    config_derive(&slots[next]);
+    atomic_set(&active, next);
+
+    ret = (int)slots[next].version;
+
+    k_mutex_unlock(&writer_lock);
+
+    LOG_INF("Configuration version %d published", ret);
+    return ret;
+}
+
+uint16_t scanner_config_plen_symbols(uint8_t code)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(plen_table); i++) {
+        if (plen_table[i].code == code) {
+            return plen_table[i].symbols;
+        }
+    }
+
+    return 0;
+}
+
+int scanner_config_plen_code(uint32_t symbols)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(plen_table); i++) {
+        if (plen_table[i].symbols == symbols) {
+            return plen_table[i].code;
+        }
+    }
+
+    return -EINVAL;
+}
+
+const char *scanner_config_power_name(uint8_t profile)
+{
+    return profile < SCANNER_POWER_COUNT ? power_names[profile] : "unknown";
+}
+
+int scanner_config_power_parse(const char *name)
+{
+    for (int i = 0; i < SCANNER_POWER_COUNT; i++) {
+        if (strcmp(name, power_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -EINVAL;
+}
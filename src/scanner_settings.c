@@ -0,0 +1,132 @@
+/**
+ * @file scanner_settings.c
+ * @brief Persisted scanner settings for warm boot
+ *
+ * Stores the last good DW3000 SPI clock and the scanner configuration
+ * (radio profile, report thresholds, allow-list) under the "uwb" settings
+ * subtree, so a reboot can bring the radio up without the discovery
+ * probe and resume on the channel it was left on.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <string.h>
+
+#include "scanner_settings.h"
+
+LOG_MODULE_REGISTER(scanner_settings, LOG_LEVEL_INF);
+
+/* Bump when scanner_config_t changes so stale blobs are ignored */
+#define SETTINGS_LAYOUT     3
+
+typedef struct {
+    uint8_t layout;
+    scanner_config_t config;
+} stored_config_t;
+
+static stored_config_t stored;
+static bool config_loaded;
+static uint32_t spi_hz;
+
+static int uwb_settings_set(const char *name, size_t len,
+                            settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    int ret;
+
+    if (settings_name_steq(name, "spi_hz", &next) && next == NULL) {
+        if (len != sizeof(spi_hz)) {
+            return -EINVAL;
+        }
+
+        ret = read_cb(cb_arg, &spi_hz, sizeof(spi_hz));
+        return ret < 0 ? ret : 0;
+    }
+
+    if (settings_name_steq(name, "config", &next) && next == NULL) {
+        /* A blob from another firmware layout is ignored, not an error */
+        if (len != sizeof(stored)) {
+            LOG_WRN("Stored configuration has unexpected size %u", (unsigned int)len);
+            return 0;
+        }
+
+        ret = read_cb(cb_arg, &stored, sizeof(stored));
+        if (ret < 0) {
+            return ret;
+        }
+
+        config_loaded = stored.layout == SETTINGS_LAYOUT &&
+                        scanner_config_validate(&stored.config) == 0;
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(uwb, "uwb", NULL, uwb_settings_set, NULL, NULL);
+
+int scanner_settings_init(void)
+{
+    int ret = settings_subsys_init();
+    if (ret < 0) {
+        LOG_ERR("Failed to initialize settings: %d", ret);
+        return ret;
+    }
+
+    ret = settings_load_subtree("uwb");
+    if (ret < 0) {
+        LOG_ERR("Failed to load settings: %d", ret);
+        return ret;
+    }
+
+    LOG_INF("Stored settings: spi=%u Hz, config %s", spi_hz,
+            config_loaded ? "valid" : "none");
+    return 0;
+}
+
+bool scanner_settings_get_config(scanner_config_t *config)
+{
+    if (!config_loaded) {
+        return false;
+    }
+
+    *config = stored.config;
+    return true;
+}
+
+uint32_t scanner_settings_get_spi_hz(void)
+{
+    return spi_hz;
+}
+
+int scanner_settings_save_config(const scanner_config_t *config)
+{
+    stored.layout = SETTINGS_LAYOUT;
+    stored.config = *config;
+
+    int ret = settings_save_one("uwb/config", &stored, sizeof(stored));
+    if (ret < 0) {
+        LOG_ERR("Failed to store configuration: %d", ret);
+        return ret;
+    }
+
+    config_loaded = true;
+    return 0;
+}
+
+int scanner_settings_save_spi_hz(uint32_t hz)
+{
+    if (hz == spi_hz) {
+        return 0;
+    }
+
+    int ret = settings_save_one("uwb/spi_hz", &hz, sizeof(hz));
+    if (ret < 0) {
+        LOG_ERR("Failed to store SPI clock: %d", ret);
+        return ret;
+    }
+
+    spi_hz = hz;
+    return 0;
+}
@@ -0,0 +1,447 @@
+/**
+ * @file scenario.c
+ * @brief Deterministic synthetic RF scenarios
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scenario.h"
+#include "frame_parse.h"
+
+/* Channel 5/9, 64 MHz PRF, 128-symbol preamble, 6.8 Mb/s */
+#define SHR_NS          135130  /* Preamble and SFD, up to the RMARKER */
+#define PHR_NS          21000
+#define BYTE_NS         1350    /* Including Reed-Solomon parity */
+
+/* Path loss matching frame_parse_distance_cm() */
+#define PL_D0_DB        40.0f
+#define PL_EXPONENT     2.5f
+
+/* First path below the total received power, and its CIR index */
+#define FP_BELOW_DB     3.0f
+#define FP_INDEX        740
+
+#define LINE_LEN        160
+
+static uint64_t rng_next(scenario_t *sc)
+{
+    /* xorshift64* */
+    sc->rng ^= sc->rng >> 12;
+    sc->rng ^= sc->rng << 25;
+    sc->rng ^= sc->rng >> 27;
+    return sc->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in (0, 1] */
+static double rng_unit(scenario_t *sc)
+{
+    return ((rng_next(sc) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t next_interval_ns(scenario_t *sc, const scenario_group_t *g)
+{
+    if (g->poisson) {
+        return (uint64_t)(-log(rng_unit(sc)) * (double)g->interval_ns);
+    }
+
+    double jitter = (2.0 * rng_unit(sc) - 1.0) * g->jitter_pct / 100.0;
+    return (uint64_t)((double)g->interval_ns * (1.0 + jitter));
+}
+
+void scenario_init(scenario_t *sc, scenario_tag_t *tags, uint16_t max_tags, uint64_t seed)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->tags = tags;
+    sc->max_tags = max_tags;
+    sc->seed = seed;
+    sc->capture_db = SCENARIO_CAPTURE_DB;
+}
+
+void scenario_group_defaults(scenario_group_t *group)
+{
+    memset(group, 0, sizeof(*group));
+    group->count = 1;
+    group->interval_ns = 1000000000ULL;
+    group->addr_mode = IEEE154_ADDR_EXTENDED;
+    group->type = SCENARIO_TYPE_DATA;
+    group->distance_min_m = 10.0f;
+    group->distance_max_m = 10.0f;
+    group->payload = 12;
+    group->pan_id = 0xDECA;
+}
+
+int scenario_add_group(scenario_t *sc, const scenario_group_t *group)
+{
+    if (group->count == 0 || group->interval_ns == 0 || group->jitter_pct > 90 ||
+        (group->addr_mode != IEEE154_ADDR_SHORT && group->addr_mode != IEEE154_ADDR_EXTENDED) ||
+        group->type > SCENARIO_TYPE_ACK || group->distance_min_m <= 0.0f ||
+        group->distance_max_m < group->distance_min_m || group->payload > 100) {
+        return -EINVAL;
+    }
+
+    if (sc->group_count >= SCENARIO_MAX_GROUPS ||
+        (uint32_t)sc->tag_count + group->count > sc->max_tags) {
+        return -ENOMEM;
+    }
+
+    for (uint16_t i = 0; i < group->count; i++) {
+        sc->tags[sc->tag_count + i].group = sc->group_count;
+    }
+    sc->groups[sc->group_count++] = *group;
+    sc->tag_count += group->count;
+
+    return 0;
+}
+
+/* Split off the next whitespace-separated token, NULL at the end */
+static char *next_token(char **p)
+{
+    char *s = *p;
+
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    if (*s == '\0') {
+        return NULL;
+    }
+
+    char *tok = s;
+    while (*s != '\0' && *s != ' ' && *s != '\t') {
+        s++;
+    }
+    if (*s != '\0') {
+        *s++ = '\0';
+    }
+    *p = s;
+
+    return tok;
+}
+
+static int parse_uint(const char *s, unsigned long max, unsigned long *value)
+{
+    char *end;
+
+    *value = strtoul(s, &end, 0);
+    return end == s || *end != '\0' || *value > max ? -EINVAL : 0;
+}
+
+static int parse_float(const char *s, float *value, char stop)
+{
+    char *end;
+
+    *value = strtof(s, &end);
+    return end == s || *end != stop ? -EINVAL : 0;
+}
+
+static int parse_group_key(scenario_group_t *g, const char *key, const char *val)
+{
+    unsigned long n;
+    int ret = 0;
+
+    if (strcmp(key, "count") == 0) {
+        ret = parse_uint(val, UINT16_MAX, &n);
+        g->count = (uint16_t)n;
+    } else if (strcmp(key, "interval") == 0) {
+        ret = parse_uint(val, 3600000, &n);
+        g->interval_ns = (uint64_t)n * 1000000ULL;
+    } else if (strcmp(key, "jitter") == 0) {
+        ret = parse_uint(val, 90, &n);
+        g->jitter_pct = (uint8_t)n;
+    } else if (strcmp(key, "arrivals") == 0) {
+        g->poisson = strcmp(val, "poisson") == 0;
+        ret = g->poisson || strcmp(val, "periodic") == 0 ? 0 : -EINVAL;
+    } else if (strcmp(key, "addr") == 0) {
+        g->addr_mode = strcmp(val, "short") == 0 ? IEEE154_ADDR_SHORT :
+                       strcmp(val, "extended") == 0 ? IEEE154_ADDR_EXTENDED : 0;
+        ret = g->addr_mode != 0 ? 0 : -EINVAL;
+    } else if (strcmp(key, "type") == 0) {
+        static const char *const names[] = {"data", "blink", "beacon", "ack"};
+        ret = -EINVAL;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strcmp(val, names[i]) == 0) {
+                g->type = (scenario_type_t)i;
+                ret = 0;
+            }
+        }
+    } else if (strcmp(key, "distance") == 0) {
+        const char *dash = strchr(val, '-');
+        ret = parse_float(val, &g->distance_min_m, dash != NULL ? '-' : '\0');
+        g->distance_max_m = g->distance_min_m;
+        if (ret == 0 && dash != NULL) {
+            ret = parse_float(dash + 1, &g->distance_max_m, '\0');
+        }
+    } else if (strcmp(key, "tx") == 0) {
+        ret = parse_float(val, &g->tx_dbm, '\0');
+    } else if (strcmp(key, "fade") == 0) {
+        ret = parse_float(val, &g->fade_db, '\0');
+    } else if (strcmp(key, "payload") == 0) {
+        ret = parse_uint(val, UINT8_MAX, &n);
+        g->payload = (uint8_t)n;
+    } else if (strcmp(key, "pan") == 0) {
+        ret = parse_uint(val, UINT16_MAX, &n);
+        g->pan_id = (uint16_t)n;
+    } else {
+        ret = -EINVAL;
+    }
+
+    return ret;
+}
+
+static int parse_line(scenario_t *sc, char *line)
+{
+    char *p = line;
+    char *directive = next_token(&p);
+    char *arg;
+    int ret;
+
+    if (directive == NULL) {
+        return 0;
+    }
+
+    if (strcmp(directive, "seed") == 0) {
+        arg = next_token(&p);
+        if (arg == NULL) {
+            return -EINVAL;
+        }
+        sc->seed = strtoull(arg, NULL, 0);
+        return 0;
+    }
+
+    if (strcmp(directive, "capture") == 0) {
+        arg = next_token(&p);
+        return arg != NULL ? parse_float(arg, &sc->capture_db, '\0') : -EINVAL;
+    }
+
+    if (strcmp(directive, "group") == 0) {
+        scenario_group_t group;
+        scenario_group_defaults(&group);
+
+        while ((arg = next_token(&p)) != NULL) {
+            char *eq = strchr(arg, '=');
+            if (eq == NULL) {
+                return -EINVAL;
+            }
+            *eq = '\0';
+            ret = parse_group_key(&group, arg, eq + 1);
+            if (ret < 0) {
+                return ret;
+            }
+        }
+
+        return scenario_add_group(sc, &group);
+    }
+
+    return -EINVAL;
+}
+
+int scenario_parse(scenario_t *sc, const char *text, size_t len, unsigned int *err_line)
+{
+    unsigned int line_no = 0;
+    size_t pos = 0;
+
+    while (pos < len) {
+        char line[LINE_LEN];
+        size_t n = 0;
+
+        line_no++;
+        while (pos < len && text[pos] != '\n') {
+            char c = text[pos++];
+            if (c == '#') {
+                /* Skip the comment, keep what came before it */
+                while (pos < len && text[pos] != '\n') {
+                    pos++;
+                }
+                break;
+            }
+            if (c == '\r') {
+                continue;
+            }
+            if (n >= sizeof(line) - 1) {
+                if (err_line != NULL) {
+                    *err_line = line_no;
+                }
+                return -E2BIG;
+            }
+            line[n++] = c;
+        }
+        pos++;      /* Newline */
+        line[n] = '\0';
+
+        int ret = parse_line(sc, line);
+        if (ret < 0) {
+            if (err_line != NULL) {
+                *err_line = line_no;
+            }
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+void scenario_start(scenario_t *sc, uint64_t start_ns)
+{
+    sc->rng = sc->seed != 0 ? sc->seed : 0x9E3779B97F4A7C15ULL;
+    sc->have_ahead = false;
+    memset(&sc->stats, 0, sizeof(sc->stats));
+
+    for (uint16_t i = 0; i < sc->tag_count; i++) {
+        scenario_tag_t *tag = &sc->tags[i];
+        const scenario_group_t *g = &sc->groups[tag->group];
+
+        if (g->addr_mode == IEEE154_ADDR_SHORT) {
+            tag->addr = i + 1u;     /* Unique, never 0 or broadcast */
+        } else {
+            tag->addr = 0x00DECA0000000000ULL | ((uint64_t)i << 24) |
+                        (rng_next(sc) & 0xFFFFFF);
+        }
+        tag->distance_m = g->distance_min_m +
+                          (float)rng_unit(sc) * (g->distance_max_m - g->distance_min_m);
+        tag->seq = (uint8_t)rng_next(sc);
+        /* Random phase so periodic tags do not start in lockstep */
+        tag->next_ns = start_ns + (uint64_t)(rng_unit(sc) * (double)g->interval_ns);
+    }
+}
+
+static uint8_t *put_le(uint8_t *p, uint64_t value, int len)
+{
+    for (int i = 0; i < len; i++) {
+        *p++ = (uint8_t)(value >> (i * 8));
+    }
+    return p;
+}
+
+void scenario_frame_timing(scenario_frame_t *frame)
+{
+    frame->rmarker_ns = frame->at_ns + SHR_NS;
+    frame->airtime_ns = SHR_NS + PHR_NS + frame->length * BYTE_NS;
+}
+
+static void build_frame(scenario_t *sc, uint16_t index, scenario_frame_t *f)
+{
+    scenario_tag_t *tag = &sc->tags[index];
+    const scenario_group_t *g = &sc->groups[tag->group];
+    int addr_len = g->addr_mode == IEEE154_ADDR_EXTENDED ? 8 : 2;
+    uint8_t type = IEEE154_FRAME_TYPE_DATA;
+    uint8_t dst = IEEE154_ADDR_NONE;
+    uint8_t src = g->addr_mode;
+    bool compress = false;
+    uint8_t *p = f->data;
+
+    switch (g->type) {
+    case SCENARIO_TYPE_DATA:
+        dst = IEEE154_ADDR_SHORT;
+        compress = true;
+        break;
+    case SCENARIO_TYPE_BEACON:
+        type = IEEE154_FRAME_TYPE_BEACON;
+        break;
+    case SCENARIO_TYPE_ACK:
+        type = IEEE154_FRAME_TYPE_ACK;
+        src = IEEE154_ADDR_NONE;
+        break;
+    default:
+        break;
+    }
+
+    p = put_le(p, type | (compress ? 0x40 : 0) | (dst << 10) | (src << 14), 2);
+    *p++ = tag->seq++;
+    if (dst != IEEE154_ADDR_NONE) {
+        p = put_le(p, g->pan_id, 2);
+        p = put_le(p, 0xFFFF, 2);          /* Broadcast */
+    }
+    if (src != IEEE154_ADDR_NONE) {
+        if (!compress) {
+            p = put_le(p, g->pan_id, 2);
+        }
+        p = put_le(p, tag->addr, addr_len);
+        memset(p, (uint8_t)index, g->payload);
+        p += g->payload;
+    }
+    p = put_le(p, 0, 2);                   /* FCS, not checked */
+
+    f->length = (uint16_t)(p - f->data);
+    f->at_ns = tag->next_ns;
+    scenario_frame_timing(f);
+    f->tag = index;
+    f->corrupt = false;
+
+    float distance = tag->distance_m > 0.1f ? tag->distance_m : 0.1f;
+    float fade = g->fade_db * (float)(2.0 * rng_unit(sc) - 1.0);
+    f->rssi_dbm = g->tx_dbm - (PL_D0_DB + 10.0f * PL_EXPONENT * log10f(distance)) + fade;
+
+    /* First path a few dB under the total, as on a line-of-sight channel */
+    f->fp_level_db = f->rssi_dbm + 115.0f - FP_BELOW_DB;
+    f->fp_index = FP_INDEX + (uint16_t)(rng_next(sc) % 8);
+    f->quality = 100;
+}
+
+/* Put the next blink on air, earliest tag first */
+static void generate(scenario_t *sc, scenario_frame_t *f)
+{
+    uint16_t first = 0;
+
+    for (uint16_t i = 1; i < sc->tag_count; i++) {
+        if (sc->tags[i].next_ns < sc->tags[first].next_ns) {
+            first = i;
+        }
+    }
+
+    build_frame(sc, first, f);
+    sc->tags[first].next_ns += next_interval_ns(sc, &sc->groups[sc->tags[first].group]);
+    sc->stats.generated++;
+}
+
+bool scenario_next(scenario_t *sc, scenario_frame_t *frame)
+{
+    if (sc->tag_count == 0) {
+        return false;
+    }
+
+    if (!sc->have_ahead) {
+        generate(sc, &sc->ahead);
+        sc->have_ahead = true;
+    }
+
+    *frame = sc->ahead;
+    generate(sc, &sc->ahead);
+
+    /* Resolve everything that starts while this frame is on air */
+    while (sc->ahead.at_ns < frame->at_ns + frame->airtime_ns) {
+        if (frame->rssi_dbm >= sc->ahead.rssi_dbm + sc->capture_db) {
+            /* Receiver stays locked on this frame */
+        } else if (sc->ahead.rssi_dbm >= frame->rssi_dbm + sc->capture_db) {
+            /* Receiver resynchronises on the stronger preamble */
+            *frame = sc->ahead;
+        } else {
+            /* Both lost; the receiver fails at the end of the one it locked on */
+            frame->corrupt = true;
+        }
+        generate(sc, &sc->ahead);
+    }
+
+    if (frame->corrupt) {
+        sc->stats.corrupted++;
+    } else {
+        sc->stats.delivered++;
+    }
+    /* Everything else put on air before the lookahead was lost */
+    sc->stats.collided = sc->stats.generated - 1 - sc->stats.delivered;
+
+    return true;
+}
+
+float scenario_rate(const scenario_t *sc)
+{
+    float rate = 0.0f;
+
+    for (uint8_t i = 0; i < sc->group_count; i++) {
+        const scenario_group_t *g = &sc->groups[i];
+        rate += g->count * 1e9f / (float)g->interval_ns;
+    }
+
+    return rate;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file sighting_journal.c
+ * @brief Buffer for sightings recorded while no host is connected
+ *
+ * Sightings are packed into fixed 48-byte records and kept in a RAM ring.
+ * With CONFIG_UWB_JOURNAL_FLASH the oldest records are spilled into a
+ * flash partition treated as a ring of record slots, erased one page
+ * ahead of the write position. Records always leave in arrival order:
+ * flash first, then RAM. Whenever space runs out the oldest records are
+ * overwritten and counted.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+#include <zephyr/storage/flash_map.h>
+#endif
+
+#include "sighting_journal.h"
+
+LOG_MODULE_REGISTER(sighting_journal, LOG_LEVEL_INF);
+
+/* Packed sighting, layout is fixed so flash contents stay readable */
+typedef struct __packed {
+    uint64_t device_addr;
+    uint64_t timestamp_us;
+    uint64_t rx_time_ns;
+    uint64_t sync_timestamp;
+    uint8_t rx_timestamp[5];
+    uint8_t seq_num;
+    uint8_t chan_flags;        /* Channel in bits 0-4, see JOURNAL_FLAG_* */
+    uint8_t frame_quality;
+    int16_t rssi_cdbm;         /* RSSI in 0.01 dBm */
+    int16_t fpp_level_c;       /* First path level in 0.01 units */
+    uint16_t fpp_index;
+    uint16_t distance_cm;
+} journal_record_t;
+
+BUILD_ASSERT(sizeof(journal_record_t) == 48, "journal record layout changed");
+
+#define JOURNAL_FLAG_PRF64      0x80
+#define JOURNAL_FLAG_SYNC       0x40
+#define JOURNAL_FLAG_RX_TIME    0x20
+#define JOURNAL_CHANNEL_MASK    0x1F
+
+#define JOURNAL_RAM_RECORDS     CONFIG_UWB_JOURNAL_RAM_RECORDS
+
+static K_MUTEX_DEFINE(journal_lock);
+
+static journal_record_t ram_ring[JOURNAL_RAM_RECORDS];
+static uint32_t ram_head;      /* Next slot to write */
+static uint32_t ram_count;
+
+static uint32_t dropped;
+static uint32_t dropped_total;
+static uint32_t flushed_total;
+
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+
+#if FIXED_PARTITION_EXISTS(journal_partition)
+#define JOURNAL_PARTITION_ID    FIXED_PARTITION_ID(journal_partition)
+#elif !defined(CONFIG_UWB_SETTINGS)
+#define JOURNAL_PARTITION_ID    FIXED_PARTITION_ID(storage_partition)
+#else
+#error "CONFIG_UWB_JOURNAL_FLASH with CONFIG_UWB_SETTINGS needs a journal_partition"
+#endif
+
+#define JOURNAL_MAX_PAGES       64
+
+static const struct flash_area *journal_fa;
+static uint32_t page_size;
+static uint32_t page_records;  /* Record slots per erase page */
+static uint32_t flash_slots;   /* Total record slots */
+static uint32_t flash_head;    /* Next slot to write */
+static uint32_t flash_count;
+static int32_t erased_page = -1;
+
+static off_t slot_offset(uint32_t slot)
+{
+    return (off_t)(slot / page_records) * page_size +
+           (off_t)(slot % page_records) * sizeof(journal_record_t);
+}
+
+static int journal_flash_init(void)
+{
+    struct flash_sector sectors[JOURNAL_MAX_PAGES];
+    uint32_t sector_count = ARRAY_SIZE(sectors);
+
+    int ret = flash_area_get_sectors(JOURNAL_PARTITION_ID, &sector_count, sectors);
+    if (ret < 0 && ret != -ENOMEM) {
+        return ret;
+    }
+
+    ret = flash_area_open(JOURNAL_PARTITION_ID, &journal_fa);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* Only uniform pages are supported, which covers nRF and the simulator */
+    page_size = sectors[0].fs_size;
+    page_records = page_size / sizeof(journal_record_t);
+    if (sector_count < 2 || page_records == 0 ||
+        JOURNAL_RAM_RECORDS < 2 * page_records) {
+        flash_area_close(journal_fa);
+        journal_fa = NULL;
+        return -EINVAL;
+    }
+
+    flash_slots = sector_count * page_records;
+
+    LOG_INF("Journal flash: %u pages of %u bytes, %u records",
+            sector_count, page_size, flash_slots);
+
+    return 0;
+}
+
+/* Write the oldest RAM record to flash; called with journal_lock held */
+static int journal_spill_one(void)
+{
+    if (flash_head % page_records == 0 &&
+        (int32_t)(flash_head / page_records) != erased_page) {
+        uint32_t page = flash_head / page_records;
+
+        /* The page about to be erased holds the oldest flash records */
+        if (flash_count > flash_slots - page_records) {
+            uint32_t lost = flash_count - (flash_slots - page_records);
+            flash_count -= lost;
+            dropped += lost;
+            dropped_total += lost;
+        }
+
+        /* Nothing readable lives in this page now, erase it unlocked */
+        k_mutex_unlock(&journal_lock);
+        int ret = flash_area_erase(journal_fa, (off_t)page * page_size, page_size);
+        k_mutex_lock(&journal_lock, K_FOREVER);
+        if (ret < 0) {
+            return ret;
+        }
+        erased_page = page;
+
+        /* RAM may have drained while unlocked */
+        if (ram_count == 0) {
+            return 0;
+        }
+    }
+
+    uint32_t tail = (ram_head + JOURNAL_RAM_RECORDS - ram_count) % JOURNAL_RAM_RECORDS;
+    int ret = flash_area_write(journal_fa, slot_offset(flash_head),
+                               &ram_ring[tail], sizeof(journal_record_t));
+    if (ret < 0) {
+        return ret;
+    }
+
+    ram_count--;
+    flash_head = (flash_head + 1) % flash_slots;
+    flash_count++;
+
+    return 0;
+}
+
+#endif /* CONFIG_UWB_JOURNAL_FLASH */
+
+static void pack_record(journal_record_t *rec, const uwb_device_info_t *info)
+{
+    rec->device_addr = info->device_addr;
+    rec->timestamp_us = info->timestamp_us;
+    rec->rx_time_ns = info->rx_time_valid ? info->rx_time_ns : 0;
+    rec->sync_timestamp = info->sync_valid ? info->sync_timestamp : 0;
+    for (int i = 0; i < 5; i++) {
+        rec->rx_timestamp[i] = (info->rx_timestamp >> (i * 8)) & 0xFF;
+    }
+    rec->seq_num = info->seq_num;
+    rec->chan_flags = (info->channel & JOURNAL_CHANNEL_MASK) |
+                      (info->prf == 64 ? JOURNAL_FLAG_PRF64 : 0) |
+                      (info->sync_valid ? JOURNAL_FLAG_SYNC : 0) |
+                      (info->rx_time_valid ? JOURNAL_FLAG_RX_TIME : 0);
+    rec->frame_quality = info->frame_quality;
+    rec->rssi_cdbm = (int16_t)CLAMP(info->rssi_dbm * 100.0f, INT16_MIN, INT16_MAX);
+    rec->fpp_level_c = (int16_t)CLAMP(info->fpp_level * 100.0f, INT16_MIN, INT16_MAX);
+    rec->fpp_index = info->fpp_index;
+    rec->distance_cm = (uint16_t)CLAMP(info->distance_cm, 0.0f, (float)UINT16_MAX);
+}
+
+static void unpack_record(uwb_device_info_t *info, const journal_record_t *rec)
+{
+    memset(info, 0, sizeof(*info));
+    info->device_addr = rec->device_addr;
+    info->timestamp_us = rec->timestamp_us;
+    info->timestamp_ms = (uint32_t)(rec->timestamp_us / 1000);
+    info->rx_time_valid = (rec->chan_flags & JOURNAL_FLAG_RX_TIME) != 0;
+    info->rx_time_ns = rec->rx_time_ns;
+    info->sync_valid = (rec->chan_flags & JOURNAL_FLAG_SYNC) != 0;
+    info->sync_timestamp = rec->sync_timestamp;
+    for (int i = 0; i < 5; i++) {
+        info->rx_timestamp |= (uint64_t)rec->rx_timestamp[i] << (i * 8);
+    }
+    info->seq_num = rec->seq_num;
+    info->channel = rec->chan_flags & JOURNAL_CHANNEL_MASK;
+    info->prf = (rec->chan_flags & JOURNAL_FLAG_PRF64) ? 64 : 16;
+    info->frame_quality = rec->frame_quality;
+    info->rssi_dbm = rec->rssi_cdbm / 100.0f;
+    info->fpp_level = rec->fpp_level_c / 100.0f;
+    info->fpp_index = rec->fpp_index;
+    info->distance_cm = rec->distance_cm;
+}
+
+int journal_init(void)
+{
+    k_mutex_lock(&journal_lock, K_FOREVER);
+    ram_head = 0;
+    ram_count = 0;
+    dropped = 0;
+    dropped_total = 0;
+    flushed_total = 0;
+    k_mutex_unlock(&journal_lock);
+
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+    int ret = journal_flash_init();
+    if (ret < 0) {
+        LOG_WRN("Journal flash unavailable (%d), using RAM only", ret);
+    }
+#endif
+
+    LOG_INF("Sighting journal initialized: %u RAM records", JOURNAL_RAM_RECORDS);
+    return 0;
+}
+
+void journal_append(const uwb_device_info_t *info)
+{
+    k_mutex_lock(&journal_lock, K_FOREVER);
+
+    /* journal_maintain() keeps room here when flash is in use */
+    if (ram_count == JOURNAL_RAM_RECORDS) {
+        ram_count--;
+        dropped++;
+        dropped_total++;
+    }
+
+    pack_record(&ram_ring[ram_head], info);
+    ram_head = (ram_head + 1) % JOURNAL_RAM_RECORDS;
+    ram_count++;
+
+    k_mutex_unlock(&journal_lock);
+}
+
+bool journal_pop(uwb_device_info_t *info)
+{
+    journal_record_t rec;
+    bool found = false;
+
+    k_mutex_lock(&journal_lock, K_FOREVER);
+
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+    /* Flash holds the oldest records; one that cannot be read is lost */
+    while (!found && journal_fa != NULL && flash_count > 0) {
+        uint32_t tail = (flash_head + flash_slots - flash_count) % flash_slots;
+        if (flash_area_read(journal_fa, slot_offset(tail), &rec, sizeof(rec)) == 0) {
+            found = true;
+        } else {
+            dropped++;
+            dropped_total++;
+        }
+        flash_count--;
+    }
+#endif
+
+    if (!found && ram_count > 0) {
+        uint32_t tail = (ram_head + JOURNAL_RAM_RECORDS - ram_count) % JOURNAL_RAM_RECORDS;
+        rec = ram_ring[tail];
+        ram_count--;
+        found = true;
+    }
+
+    if (found) {
+        flushed_total++;
+    }
+
+    k_mutex_unlock(&journal_lock);
+
+    if (found) {
+        unpack_record(info, &rec);
+    }
+
+    return found;
+}
+
+void journal_maintain(void)
+{
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+    if (journal_fa == NULL) {
+        return;
+    }
+
+    /* Keep half the RAM ring free so appends never wait for an erase */
+    k_mutex_lock(&journal_lock, K_FOREVER);
+    while (ram_count > JOURNAL_RAM_RECORDS / 2) {
+        int ret = journal_spill_one();
+        if (ret < 0) {
+            LOG_ERR("Journal flash write failed: %d", ret);
+            break;
+        }
+    }
+    k_mutex_unlock(&journal_lock);
+#endif
+}
+
+void journal_get_stats(journal_stats_t *stats, bool reset_dropped)
+{
+    k_mutex_lock(&journal_lock, K_FOREVER);
+
+    stats->pending = ram_count;
+    stats->capacity = JOURNAL_RAM_RECORDS;
+#ifdef CONFIG_UWB_JOURNAL_FLASH
+    if (journal_fa != NULL) {
+        stats->pending += flash_count;
+        stats->capacity += flash_slots - page_records;
+    }
+#endif
+    stats->dropped = dropped;
+    stats->dropped_total = dropped_total;
+    stats->flushed_total = flushed_total;
+
+    if (reset_dropped) {
+        dropped = 0;
+    }
+
+    k_mutex_unlock(&journal_lock);
+}
@@ -0,0 +1,212 @@
+/**
+ * @file spi_fault.c
+ * @brief Fault injection on the DW3000 SPI path
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <errno.h>
+
+#include "spi_fault.h"
+#include "metrics.h"
+
+LOG_MODULE_REGISTER(spi_fault, LOG_LEVEL_INF);
+
+#define SPI_FAULT_SEED      0x5EED5EEDDECA0302ULL
+
+METRIC_COUNTER_DEFINE(spi_faults);
+
+static const char *const fault_names[SPI_FAULT_COUNT] = {
+    [SPI_FAULT_NONE] = "none",
+    [SPI_FAULT_ERROR] = "error",
+    [SPI_FAULT_BITFLIP] = "bitflip",
+    [SPI_FAULT_STUCK] = "stuck",
+    [SPI_FAULT_DELAY] = "delay",
+};
+
+static struct k_spinlock lock;
+static spi_fault_class_t active;
+static uint16_t active_permille;
+static int64_t until_ms;           /* 0: armed until stopped */
+static uint64_t rng = SPI_FAULT_SEED;
+static uint32_t injected[SPI_FAULT_COUNT];
+
+/* xorshift64, only ever called under the lock */
+static uint32_t fault_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng >> 32);
+}
+
+/* Decide whether this transfer is hit; returns the class to apply */
+static spi_fault_class_t fault_draw(uint32_t *bit)
+{
+    spi_fault_class_t fault = SPI_FAULT_NONE;
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (active != SPI_FAULT_NONE && until_ms != 0 && k_uptime_get() >= until_ms) {
+        active = SPI_FAULT_NONE;
+    }
+
+    if (active != SPI_FAULT_NONE && fault_random() % 1000U < active_permille) {
+        fault = active;
+        *bit = fault_random();
+        injected[fault]++;
+    }
+
+    k_spin_unlock(&lock, key);
+
+    if (fault != SPI_FAULT_NONE) {
+        metric_inc(&spi_faults);
+    }
+
+    return fault;
+}
+
+/* Bytes of the buffer at bus position pos that lie past the first skip bytes */
+static size_t past(const struct spi_buf *buf, size_t pos, size_t skip)
+{
+    if (buf->buf == NULL || pos + buf->len <= skip) {
+        return 0;
+    }
+
+    return pos >= skip ? buf->len : pos + buf->len - skip;
+}
+
+/* Invert bit 'bit' of the received data, counted across the buffers.
+ * The first skip bytes on the bus echo the header and are left alone.
+ */
+static void rx_flip(const struct spi_buf_set *rx, size_t skip, uint32_t bit)
+{
+    size_t len = 0;
+    size_t pos = 0;
+
+    for (size_t i = 0; i < rx->count; i++) {
+        len += past(&rx->buffers[i], pos, skip);
+        pos += rx->buffers[i].len;
+    }
+    if (len == 0) {
+        return;
+    }
+
+    size_t offset = (bit >> 3) % len;
+    pos = 0;
+    for (size_t i = 0; i < rx->count; i++) {
+        const struct spi_buf *buf = &rx->buffers[i];
+        size_t n = past(buf, pos, skip);
+
+        if (offset < n) {
+            ((uint8_t *)buf->buf)[buf->len - n + offset] ^= BIT(bit & 0x07);
+            return;
+        }
+        offset -= n;
+        pos += buf->len;
+    }
+}
+
+static void rx_fill_ff(const struct spi_buf_set *rx)
+{
+    for (size_t i = 0; i < rx->count; i++) {
+        if (rx->buffers[i].buf != NULL) {
+            memset(rx->buffers[i].buf, 0xFF, rx->buffers[i].len);
+        }
+    }
+}
+
+int spi_fault_transceive(const struct device *dev, const struct spi_config *config,
+                         const struct spi_buf_set *tx, const struct spi_buf_set *rx)
+{
+    uint32_t bit = 0;
+    spi_fault_class_t fault = fault_draw(&bit);
+
+    if (fault == SPI_FAULT_ERROR) {
+        return -EIO;
+    }
+
+    int ret = spi_transceive(dev, config, tx, rx);
+    if (ret < 0 || rx == NULL) {
+        return ret;
+    }
+
+    switch (fault) {
+    case SPI_FAULT_BITFLIP:
+        /* The first TX buffer is the header, its echo carries no data */
+        rx_flip(rx, tx != NULL && tx->count > 0 ? tx->buffers[0].len : 0, bit);
+        break;
+    case SPI_FAULT_STUCK:
+        /* MOSI still reaches the chip, only the replies are lost */
+        rx_fill_ff(rx);
+        break;
+    case SPI_FAULT_DELAY:
+        k_busy_wait(CONFIG_UWB_SPI_FAULT_DELAY_US);
+        break;
+    default:
+        break;
+    }
+
+    return ret;
+}
+
+int spi_fault_start(spi_fault_class_t fault, uint16_t permille, uint32_t duration_ms)
+{
+    if (fault >= SPI_FAULT_COUNT || permille == 0 || permille > 1000) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    active = fault;
+    active_permille = permille;
+    until_ms = duration_ms > 0 ? k_uptime_get() + duration_ms : 0;
+    rng = SPI_FAULT_SEED;
+    k_spin_unlock(&lock, key);
+
+    LOG_WRN("SPI fault %s armed: %u/1000 of transfers, %u ms (0: until stopped)",
+            fault_names[fault], permille, duration_ms);
+    return 0;
+}
+
+void spi_fault_stop(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    active = SPI_FAULT_NONE;
+    k_spin_unlock(&lock, key);
+
+    LOG_INF("SPI fault disarmed");
+}
+
+spi_fault_class_t spi_fault_active(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    if (active != SPI_FAULT_NONE && until_ms != 0 && k_uptime_get() >= until_ms) {
+        active = SPI_FAULT_NONE;
+    }
+    spi_fault_class_t fault = active;
+
+    k_spin_unlock(&lock, key);
+    return fault;
+}
+
+uint32_t spi_fault_injected(spi_fault_class_t fault)
+{
+    return fault < SPI_FAULT_COUNT ? injected[fault] : 0;
+}
+
+const char *spi_fault_name(spi_fault_class_t fault)
+{
+    return fault < SPI_FAULT_COUNT ? fault_names[fault] : "?";
+}
+
+spi_fault_class_t spi_fault_parse(const char *name, size_t len)
+{
+    for (int i = SPI_FAULT_NONE + 1; i < SPI_FAULT_COUNT; i++) {
+        if (strlen(fault_names[i]) == len && strncmp(fault_names[i], name, len) == 0) {
+            return (spi_fault_class_t)i;
+        }
+    }
+
+    return SPI_FAULT_NONE;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file spi_profile.c
+ * @brief DW3000 SPI transaction profiler
+ *
+ * A small open-addressed table keyed by register and direction. The
+ * driver touches a dozen or so registers, so the table never fills in
+ * practice; anything that does not fit is only counted.
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#include "spi_profile.h"
+#include "dw3000_driver.h"
+
+#define SLOTS       CONFIG_UWB_SPI_PROFILE_SLOTS
+
+/* Slots with a zero count are free */
+static spi_profile_entry_t table[SLOTS];
+static uint32_t untracked_count;
+static int64_t since_ms;
+static struct k_spinlock lock;
+
+static const struct {
+    uint16_t reg;
+    const char *name;
+} reg_names[] = {
+    {DW3000_REG_DEV_ID, "DEV_ID"},
+    {DW3000_REG_SYS_CFG, "SYS_CFG"},
+    {DW3000_REG_TX_FCTRL, "TX_FCTRL"},
+    {DW3000_REG_RX_FINFO, "RX_FINFO"},
+    {DW3000_REG_RX_BUFFER, "RX_BUFFER"},
+    {DW3000_REG_RX_FQUAL, "RX_FQUAL"},
+    {DW3000_REG_RX_TTCKI, "RX_TTCKI"},
+    {DW3000_REG_TX_BUFFER, "TX_BUFFER"},
+    {DW3000_REG_RX_TIME, "RX_TIME"},
+    {DW3000_REG_TX_TIME, "TX_TIME"},
+    {DW3000_REG_SYS_TIME, "SYS_TIME"},
+    {DW3000_REG_DX_TIME, "DX_TIME"},
+    {DW3000_REG_SYS_STATUS, "SYS_STATUS"},
+    {DW3000_REG_CIA_CONF, "CIA_CONF"},
+    {DW3000_REG_IP_CONF, "IP_CONF"},
+    {DW3000_REG_RX_SNIFF, "RX_SNIFF"},
+    {DW3000_REG_AON_DIG_CFG, "AON_DIG_CFG"},
+    {DW3000_REG_AON_CTRL, "AON_CTRL"},
+    {DW3000_REG_AON_CFG, "AON_CFG"},
+};
+
+static const char *const cmd_names[] = {
+    [DW3000_CMD_TXRXOFF] = "TXRXOFF",
+    [DW3000_CMD_TX] = "TX",
+    [DW3000_CMD_RX] = "RX",
+    [DW3000_CMD_DTX] = "DTX",
+};
+
+void spi_profile_init(void)
+{
+    timing_init();
+    timing_start();
+}
+
+void spi_profile_record(uint16_t key, uint32_t bytes, timing_t start, int ret)
+{
+    timing_t end = timing_counter_get();
+    uint64_t ns = timing_cycles_to_ns(timing_cycles_get(&start, &end));
+    k_spinlock_key_t lock_key = k_spin_lock(&lock);
+
+    /* Linear probing from the key's home slot */
+    for (int i = 0; i < SLOTS; i++) {
+        spi_profile_entry_t *e = &table[(key + i) % SLOTS];
+
+        if (e->count == 0) {
+            e->key = key;
+        } else if (e->key != key) {
+            continue;
+        }
+
+        e->count++;
+        e->bytes += bytes;
+        e->bus_ns += ns;
+        if (ret < 0) {
+            e->errors++;
+        }
+
+        k_spin_unlock(&lock, lock_key);
+        return;
+    }
+
+    untracked_count++;
+    k_spin_unlock(&lock, lock_key);
+}
+
+bool spi_profile_get(unsigned int index, spi_profile_entry_t *entry)
+{
+    if (index >= SLOTS) {
+        return false;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *entry = table[index];
+    k_spin_unlock(&lock, key);
+
+    return entry->count != 0;
+}
+
+uint32_t spi_profile_totals(spi_profile_entry_t *total, uint32_t *untracked)
+{
+    memset(total, 0, sizeof(*total));
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    for (int i = 0; i < SLOTS; i++) {
+        total->count += table[i].count;
+        total->bytes += table[i].bytes;
+        total->bus_ns += table[i].bus_ns;
+        total->errors += table[i].errors;
+    }
+    *untracked = untracked_count;
+    int64_t window = k_uptime_get() - since_ms;
+    k_spin_unlock(&lock, key);
+
+    return (uint32_t)window;
+}
+
+const char *spi_profile_name(uint16_t key)
+{
+    if (key & SPI_PROFILE_FAST_CMD) {
+        uint16_t cmd = key & ~SPI_PROFILE_FAST_CMD;
+        return cmd < ARRAY_SIZE(cmd_names) ? cmd_names[cmd] : NULL;
+    }
+
+    uint16_t reg = key & ~SPI_PROFILE_WRITE;
+    for (size_t i = 0; i < ARRAY_SIZE(reg_names); i++) {
+        if (reg_names[i].reg == reg) {
+            return reg_names[i].name;
+        }
+    }
+
+    return NULL;
+}
+
+void spi_profile_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memset(table, 0, sizeof(table));
+    untracked_count = 0;
+    since_ms = k_uptime_get();
+    k_spin_unlock(&lock, key);
+}
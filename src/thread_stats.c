@@ -0,0 +1,114 @@
+/**
+ * @file thread_stats.c
+ * @brief Per-thread CPU usage and stack high-water marks
+ *
+ * Walks the threads with the thread analyzer and turns its cumulative
+ * runtime counters into a CPU share per reporting interval. Threads are
+ * matched between reports by name, so every thread worth watching needs
+ * k_thread_name_set().
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/debug/thread_analyzer.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "thread_stats.h"
+
+LOG_MODULE_REGISTER(thread_stats, LOG_LEVEL_INF);
+
+#define THREAD_SLOTS        16
+#define STACK_WARN_PCT      90      /* Warn when the high-water mark crosses this */
+
+/* Counters at the previous report */
+static struct {
+    char name[CONFIG_THREAD_MAX_NAME_LEN];
+    uint64_t cycles;
+    size_t stack_used;
+} prev[THREAD_SLOTS];
+static uint64_t prev_total;
+
+/* Walk state for the analyzer callback */
+static struct {
+    char *buf;
+    size_t size;
+    int len;
+    uint64_t total;
+    bool first;
+} walk;
+
+static int prev_slot(const char *name)
+{
+    for (int i = 0; i < THREAD_SLOTS; i++) {
+        if (strncmp(prev[i].name, name, sizeof(prev[i].name)) == 0) {
+            return i;
+        }
+    }
+
+    for (int i = 0; i < THREAD_SLOTS; i++) {
+        if (prev[i].name[0] == '\0') {
+            strncpy(prev[i].name, name, sizeof(prev[i].name) - 1);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void thread_cb(struct thread_analyzer_info *info)
+{
+    uint64_t cycles = info->usage.execution_cycles;
+    uint64_t delta = cycles;
+    int slot = prev_slot(info->name);
+
+    if (slot >= 0) {
+        delta = cycles - prev[slot].cycles;
+        prev[slot].cycles = cycles;
+
+        uint32_t pct = info->stack_size > 0 ?
+                       info->stack_used * 100 / info->stack_size : 0;
+        if (info->stack_used > prev[slot].stack_used && pct >= STACK_WARN_PCT) {
+            LOG_WRN("Thread %s uses %u of %u stack bytes", info->name,
+                    info->stack_used, info->stack_size);
+        }
+        prev[slot].stack_used = info->stack_used;
+    }
+
+    uint32_t permille = walk.total > 0 ? (uint32_t)(delta * 1000 / walk.total) : 0;
+
+    if (walk.len < 0 || (size_t)walk.len >= walk.size) {
+        walk.len = -1;
+        return;
+    }
+
+    int n = snprintf(walk.buf + walk.len, walk.size - walk.len,
+                     "%s\"%s\":[%u,%u,%u]", walk.first ? "" : ",", info->name,
+                     permille, info->stack_used, info->stack_size);
+    walk.first = false;
+    walk.len = (n < 0 || (size_t)(walk.len + n) >= walk.size) ? -1 : walk.len + n;
+}
+
+int thread_stats_format(char *buf, size_t size)
+{
+    k_thread_runtime_stats_t all;
+
+    k_thread_runtime_stats_all_get(&all);
+
+    walk.buf = buf;
+    walk.size = size;
+    walk.total = all.execution_cycles - prev_total;
+    walk.first = true;
+    prev_total = all.execution_cycles;
+
+    walk.len = snprintf(buf, size, "{\"type\":\"threads\",\"uptime_ms\":%u,\"t\":{",
+                        k_uptime_get_32());
+
+    thread_analyzer_run(thread_cb, 0);
+
+    if (walk.len > 0 && (size_t)walk.len < size) {
+        walk.len += snprintf(buf + walk.len, size - walk.len, "}}\r\n");
+    }
+
+    return walk.len > 0 && (size_t)walk.len < size ? walk.len : -ENOMEM;
+}
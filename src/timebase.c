@@ -0,0 +1,166 @@
+/**
+ * @file timebase.c
+ * @brief Unified 64-bit timebase relating DW3000 device time to uptime
+ *
+ * SYS_TIME is read bracketed by two k_cycle_get_64() reads and paired with
+ * their midpoint. The difference between uptime and the nominal duration
+ * of the unwrapped device time is tracked with an exponentially weighted
+ * line fit, which absorbs both the offset and the relative drift of the
+ * two crystals. Any RX timestamp within half a counter wrap of the last
+ * sample then converts to 64-bit uptime nanoseconds in O(1).
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <math.h>
+
+#include "timebase.h"
+#include "dw3000_driver.h"
+#include "linear_fit.h"
+
+LOG_MODULE_REGISTER(timebase, LOG_LEVEL_INF);
+
+#define TIMEBASE_SAMPLE_INTERVAL_MS 1000
+#define TIMEBASE_FORGET             0.95
+#define TIMEBASE_MIN_SAMPLES        2
+#define TIMEBASE_MAX_BRACKET_NS     100000      /* Read preempted, discard */
+#define TIMEBASE_RESET_NS           1000000.0   /* Device time restarted */
+#define TIMEBASE_STALE_TICKS        (8 * (int64_t)DW3000_TIME_TICKS_PER_SEC)
+#define TIMEBASE_RESYNC_ATTEMPTS    3
+
+/* 1e9 / 63897600000 ns per tick, as an exact fraction */
+#define TICKS_NS_NUM                625
+#define TICKS_NS_DEN                39936
+
+static linear_fit_t fit;
+static bool have_sample;
+static uint64_t last_raw;
+static int64_t last_unwrapped;
+static uint32_t last_sample_ms;
+static uint32_t samples_discarded;
+
+/* Nominal nanoseconds for a device tick count, without 64-bit overflow */
+static int64_t dw_ticks_to_ns(int64_t ticks)
+{
+    return (ticks / TICKS_NS_DEN) * TICKS_NS_NUM +
+           ((ticks % TICKS_NS_DEN) * TICKS_NS_NUM) / TICKS_NS_DEN;
+}
+
+/* Take one sample; with @p rebase the device clock restarted since the last */
+static int timebase_sample(bool rebase)
+{
+    uint64_t dw_time;
+
+    uint64_t c0 = k_cycle_get_64();
+    int ret = dw3000_read_sys_time(&dw_time);
+    uint64_t c1 = k_cycle_get_64();
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    last_sample_ms = k_uptime_get_32();
+
+    if (have_sample && k_cyc_to_ns_floor64(c1 - c0) > TIMEBASE_MAX_BRACKET_NS) {
+        samples_discarded++;
+        return -EAGAIN;
+    }
+
+    int64_t uptime_ns = (int64_t)k_cyc_to_ns_floor64(c0 + (c1 - c0) / 2);
+
+    if (!have_sample || rebase) {
+        have_sample = true;
+        last_unwrapped = (int64_t)dw_time;
+    } else {
+        last_unwrapped += dw3000_time_delta(dw_time, last_raw);
+    }
+    last_raw = dw_time;
+
+    int64_t x = dw_ticks_to_ns(last_unwrapped);
+
+    if (rebase && fit.count > 0) {
+        linear_fit_rebase(&fit, x, uptime_ns - x);
+        return 0;
+    }
+
+    if (fit.count >= TIMEBASE_MIN_SAMPLES &&
+        fabs(linear_fit_residual(&fit, x, uptime_ns - x)) > TIMEBASE_RESET_NS) {
+        /* DW3000 was reset or slept: start over from this sample */
+        LOG_WRN("Device time discontinuity, resetting timebase");
+        linear_fit_init(&fit, TIMEBASE_FORGET);
+        last_unwrapped = (int64_t)dw_time;
+        x = dw_ticks_to_ns(last_unwrapped);
+    }
+
+    linear_fit_add(&fit, x, uptime_ns - x);
+
+    LOG_DBG("Timebase sample: dw=%llu uptime=%lld ns drift=%.3f ppm",
+            dw_time, uptime_ns, -fit.b * 1e6);
+
+    return 0;
+}
+
+int timebase_init(void)
+{
+    linear_fit_init(&fit, TIMEBASE_FORGET);
+    have_sample = false;
+    samples_discarded = 0;
+
+    return timebase_sample(false);
+}
+
+int timebase_poll(void)
+{
+    if (have_sample &&
+        (uint32_t)(k_uptime_get_32() - last_sample_ms) < TIMEBASE_SAMPLE_INTERVAL_MS) {
+        return 0;
+    }
+
+    int ret = timebase_sample(false);
+    return ret == -EAGAIN ? 0 : ret;
+}
+
+int timebase_resync(void)
+{
+    int ret = -EAGAIN;
+
+    /* A preempted read is retried, the offset has to come from this wake */
+    for (int i = 0; i < TIMEBASE_RESYNC_ATTEMPTS && ret == -EAGAIN; i++) {
+        ret = timebase_sample(true);
+    }
+
+    if (ret < 0) {
+        /* Old samples describe a clock that no longer runs, start over */
+        linear_fit_init(&fit, TIMEBASE_FORGET);
+        have_sample = false;
+    }
+
+    return ret;
+}
+
+bool timebase_dw_to_ns(uint64_t dw_time, uint64_t *uptime_ns)
+{
+    if (fit.count < TIMEBASE_MIN_SAMPLES) {
+        return false;
+    }
+
+    int64_t delta = dw3000_time_delta(dw_time, last_raw);
+    if (delta > TIMEBASE_STALE_TICKS || delta < -TIMEBASE_STALE_TICKS) {
+        return false;
+    }
+
+    int64_t x = dw_ticks_to_ns(last_unwrapped + delta);
+    int64_t ns = x + linear_fit_eval(&fit, x);
+    if (ns < 0) {
+        return false;
+    }
+
+    *uptime_ns = (uint64_t)ns;
+    return true;
+}
+
+float timebase_get_drift_ppm(void)
+{
+    return fit.count >= TIMEBASE_MIN_SAMPLES ? (float)(-fit.b * 1e6) : 0.0f;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file uart_input.c
+ * @brief Line-based host input over the USB CDC ACM link
+ *
+ * Bytes are assembled into lines in the UART interrupt so the arrival time
+ * of each line can be captured as close to the wire as possible. Complete
+ * lines are queued and handed to the registered handler from the system
+ * work queue. Commands are accepted on the data interface and, when the
+ * devicetree provides one, on the dedicated command interface. The
+ * callback also drives the transmit side, which is owned by uart_output.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include "uart_input.h"
+#include "uart_output.h"
+
+LOG_MODULE_REGISTER(uart_input, LOG_LEVEL_INF);
+
+#define INPUT_QUEUE_DEPTH 4
+
+typedef struct {
+    uint64_t rx_time_us;
+    uart_channel_t channel;
+    char text[UART_INPUT_LINE_MAX + 1];
+} input_line_t;
+
+/* Per-interface receive state, the line is assembled in the ISR */
+typedef struct {
+    const struct device *dev;
+    input_line_t line;
+    size_t len;
+    bool overflow;
+} input_ctx_t;
+
+static input_ctx_t inputs[] = {
+    {.line.channel = UART_CHANNEL_DATA},
+#if DT_HAS_CHOSEN(uwb_command_uart)
+    {.line.channel = UART_CHANNEL_COMMAND},
+#endif
+};
+
+static uart_input_line_handler_t line_handler;
+
+K_MSGQ_DEFINE(input_msgq, sizeof(input_line_t), INPUT_QUEUE_DEPTH, 4);
+
+static void input_work_handler(struct k_work *work)
+{
+    input_line_t line;
+
+    ARG_UNUSED(work);
+
+    while (k_msgq_get(&input_msgq, &line, K_NO_WAIT) == 0) {
+        if (line_handler != NULL) {
+            line_handler(line.text, line.rx_time_us, line.channel);
+        }
+    }
+}
+
+static K_WORK_DEFINE(input_work, input_work_handler);
+
+static void uart_input_isr(const struct device *dev, void *user_data)
+{
+    input_ctx_t *ctx = user_data;
+    uint8_t c;
+
+    if (!uart_irq_update(dev)) {
+        return;
+    }
+
+    /* The same callback serves the output side of the link */
+    if (uart_irq_tx_ready(dev)) {
+        uart_output_tx_isr(dev);
+    }
+
+    if (!uart_irq_rx_ready(dev)) {
+        return;
+    }
+
+    while (uart_fifo_read(dev, &c, 1) == 1) {
+        if (c == '\r' || c == '\n') {
+            if (ctx->len > 0 && !ctx->overflow) {
+                ctx->line.text[ctx->len] = '\0';
+                ctx->line.rx_time_us = k_ticks_to_us_floor64(k_uptime_ticks());
+                if (k_msgq_put(&input_msgq, &ctx->line, K_NO_WAIT) == 0) {
+                    k_work_submit(&input_work);
+                }
+            }
+            ctx->len = 0;
+            ctx->overflow = false;
+        } else if (ctx->len < UART_INPUT_LINE_MAX) {
+            ctx->line.text[ctx->len++] = (char)c;
+        } else {
+            /* Discard the whole line rather than act on a truncated one */
+            ctx->overflow = true;
+        }
+    }
+}
+
+static int input_attach(input_ctx_t *ctx, const struct device *dev)
+{
+    if (!device_is_ready(dev)) {
+        return -ENODEV;
+    }
+
+    int ret = uart_irq_callback_user_data_set(dev, uart_input_isr, ctx);
+    if (ret < 0) {
+        LOG_ERR("Failed to set UART callback: %d", ret);
+        return ret;
+    }
+
+    ctx->dev = dev;
+    uart_irq_rx_enable(dev);
+
+    return 0;
+}
+
+int uart_input_init(uart_input_line_handler_t handler)
+{
+    LOG_INF("Initializing host input");
+
+    line_handler = handler;
+
+    int ret = input_attach(&inputs[0], DEVICE_DT_GET(DT_CHOSEN(zephyr_cdc_acm_uart0)));
+    if (ret < 0) {
+        LOG_WRN("USB CDC ACM device not ready, host input disabled");
+        return ret;
+    }
+
+#if DT_HAS_CHOSEN(uwb_command_uart)
+    ret = input_attach(&inputs[1], DEVICE_DT_GET(DT_CHOSEN(uwb_command_uart)));
+    if (ret < 0) {
+        LOG_WRN("Command interface unavailable: %d", ret);
+    }
+#endif
+
+    LOG_INF("Host input initialized successfully");
+    return 0;
+}
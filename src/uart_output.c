@@ -7,18 +7,26 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "uart_output.h"
+#include "sighting_journal.h"
+#include "device_table.h"
+#include "scanner_config.h"
+#include "metrics.h"
+#include "latency_trace.h"
+#include "spi_profile.h"
+#include "uwb_trace.h"
+#include "thread_stats.h"
+#include "flight_recorder.h"
 
 LOG_MODULE_REGISTER(uart_output, LOG_LEVEL_INF);
 
 /* UART devices */
 static const struct device *uart_dev;
-#ifdef CONFIG_USB_CDC_ACM
-static const struct device *usb_uart_dev;
-#endif
 
 /* Output buffer */
 #define OUTPUT_BUFFER_SIZE 512
@@ -27,63 +35,247 @@ static char output_buffer[OUTPUT_BUFFER_SIZE];
 /* Mutex for thread-safe output */
 static K_MUTEX_DEFINE(output_mutex);
 
-/* Helper function to send string via UART */
-static void uart_send_string(const char *str)
+/* Per-sighting streaming, the device table is updated either way */
+static bool streaming = true;
+
+METRIC_COUNTER_DEFINE(output_sightings);
+METRIC_COUNTER_DEFINE(output_tx_dropped);
+METRIC_COUNTER_DEFINE(output_bytes);          /* Written to the console or queued on a link */
+METRIC_GAUGE_DEFINE(output_queue_bytes);
+METRIC_GAUGE_DEFINE(output_drain_bps);
+
+/* Metrics records outgrow output_buffer, they get their own */
+static char metrics_buffer[CONFIG_UWB_METRICS_RECORD_SIZE];
+
+/* Startup record, held for the host if it connects after boot */
+static uart_output_boot_t boot_info;
+
+static const char *const mode_names[UART_OUTPUT_MODE_COUNT] = {
+    [UART_OUTPUT_MODE_FULL] = "full",
+    [UART_OUTPUT_MODE_THROTTLED] = "throttled",
+    [UART_OUTPUT_MODE_SUMMARY] = "summary",
+};
+
+/* Format the startup record into output_buffer; called with output_mutex held */
+static int format_boot(void)
 {
-    int len = strlen(str);
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"status\",\"message\":\"Scanning started\",\"boot\":{"
+        "\"output_us\":%u,\"radio_us\":%u,\"scan_us\":%u,\"warm\":%s}}\r\n",
+        boot_info.output_us, boot_info.radio_us, boot_info.scan_us,
+        boot_info.warm ? "true" : "false"
+    );
 
-    /* Send to physical UART */
-    if (uart_dev && device_is_ready(uart_dev)) {
-        for (int i = 0; i < len; i++) {
-            uart_poll_out(uart_dev, str[i]);
-        }
+    return len > 0 && len < OUTPUT_BUFFER_SIZE ? len : 0;
+}
+
+#ifdef CONFIG_USB_CDC_ACM
+/*
+ * CDC ACM transmit path. Producers never block: records go into a ring
+ * per interface drained from the UART interrupt, and a periodic monitor
+ * measures the data link's drain rate and queue depth to pick the output
+ * fidelity.
+ */
+#define TX_RING_SIZE        CONFIG_UWB_OUTPUT_TX_BUFFER_SIZE
+#define TX_RECORD_HEADROOM  256     /* Kept free for status and sync records */
+#define LINK_MONITOR_MS     250
+#define LINK_FILL_HIGH      75      /* % queued that forces a step down */
+#define LINK_FILL_LOW       10      /* % queued considered idle */
+#define LINK_CALM_PERIODS   8       /* Idle periods before stepping up */
+#define LINK_PROBE_MS       30000   /* Retry full fidelity after this long */
+
+/* One CDC ACM interface with its own transmit buffer */
+typedef struct {
+    const struct device *dev;
+    struct ring_buf *ring;
+    struct k_spinlock lock;
+    atomic_t drained;               /* Bytes accepted by the driver */
+    atomic_t offered;               /* Bytes offered, including dropped */
+    atomic_t dropped;               /* Records that did not fit */
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    uint32_t sent_total;            /* Bytes accepted by the driver since boot */
+#endif
+} tx_link_t;
+
+RING_BUF_DECLARE(data_ring, TX_RING_SIZE);
+static tx_link_t data_link = {.ring = &data_ring};
+
+#if DT_HAS_CHOSEN(uwb_command_uart)
+RING_BUF_DECLARE(command_ring, CONFIG_UWB_OUTPUT_COMMAND_BUFFER_SIZE);
+static tx_link_t command_link = {.ring = &command_ring};
+#endif
+
+static uart_output_mode_t output_mode = UART_OUTPUT_MODE_FULL;
+static uint32_t drain_bps;
+static uint32_t offered_bps;
+static uint32_t mode_offered_bps[UART_OUTPUT_MODE_COUNT];
+static uint32_t link_capacity_bps;
+static uint32_t link_capacity_ms;
+static uint32_t calm_periods;
+static uint32_t dropped_total;
+static uint32_t summary_ms;
+static bool boot_pending;
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+static bool flight_pending;
+#endif
+
+/* The host has the CDC port open when it asserts DTR */
+static bool link_connected(tx_link_t *link)
+{
+    uint32_t dtr = 0;
+
+    if (link->dev == NULL) {
+        return false;
+    }
+
+    if (uart_line_ctrl_get(link->dev, UART_LINE_CTRL_DTR, &dtr) < 0) {
+        /* Line state unknown, keep sending as before */
+        return true;
+    }
+
+    return dtr != 0;
+}
+
+static uint32_t link_queued(tx_link_t *link)
+{
+    k_spinlock_key_t key = k_spin_lock(&link->lock);
+    uint32_t queued = ring_buf_size_get(link->ring);
+    k_spin_unlock(&link->lock, key);
+
+    return queued;
+}
+
+/* Queue a complete record, leaving @p headroom bytes free; never blocks */
+static bool link_queue(tx_link_t *link, const char *str, int len, uint32_t headroom)
+{
+    if (!link_connected(link)) {
+        return false;
+    }
+
+    atomic_add(&link->offered, len);
+
+    k_spinlock_key_t key = k_spin_lock(&link->lock);
+    bool fits = ring_buf_space_get(link->ring) >= (uint32_t)len + headroom;
+    if (fits) {
+        ring_buf_put(link->ring, (const uint8_t *)str, len);
+    }
+    k_spin_unlock(&link->lock, key);
+
+    if (!fits) {
+        UWB_TRACE("out_drop", len, link == &data_link);
+        atomic_inc(&link->dropped);
+        metric_inc(&output_tx_dropped);
+        return false;
+    }
+
+    UWB_TRACE("out_enqueue", len, link == &data_link);
+    metric_add(&output_bytes, len);
+    uart_irq_tx_enable(link->dev);
+    return true;
+}
+
+static bool cdc_queue(const char *str, int len, uint32_t headroom)
+{
+    return link_queue(&data_link, str, len, headroom);
+}
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+/* Byte count the link will have drained once everything queued is sent */
+static uint32_t link_end(tx_link_t *link)
+{
+    k_spinlock_key_t key = k_spin_lock(&link->lock);
+    uint32_t end = link->sent_total + ring_buf_size_get(link->ring);
+    k_spin_unlock(&link->lock, key);
+
+    return end;
+}
+#endif
+
+/* Replies go to the interface the command came in on */
+static tx_link_t *reply_link(uart_channel_t channel)
+{
+#if DT_HAS_CHOSEN(uwb_command_uart)
+    if (channel == UART_CHANNEL_COMMAND && command_link.dev != NULL) {
+        return &command_link;
     }
+#else
+    ARG_UNUSED(channel);
+#endif
+
+    return data_link.dev != NULL ? &data_link : NULL;
+}
+#else
+/* No DTR without CDC ACM, the console's owner reports the host */
+static atomic_t console_host = ATOMIC_INIT(1);
+#endif
 
+/* Whether the host is reading the data link */
+static bool host_connected(void)
+{
 #ifdef CONFIG_USB_CDC_ACM
-    /* Send to USB CDC ACM */
-    if (usb_uart_dev && device_is_ready(usb_uart_dev)) {
+    return link_connected(&data_link);
+#else
+    return atomic_get(&console_host) != 0;
+#endif
+}
+
+static void console_send_string(const char *str, int len)
+{
+    if (!IS_ENABLED(CONFIG_UWB_OUTPUT_CONSOLE)) {
+        return;
+    }
+
+    if (uart_dev && device_is_ready(uart_dev)) {
         for (int i = 0; i < len; i++) {
-            uart_poll_out(usb_uart_dev, str[i]);
+            uart_poll_out(uart_dev, str[i]);
         }
+        metric_add(&output_bytes, len);
     }
-#endif
 }
 
-int uart_output_init(void)
+/* Helper function to send string via UART */
+static void uart_send_string(const char *str)
 {
-    LOG_INF("Initializing UART output");
+    int len = strlen(str);
 
-    /* Get UART device */
-    uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
-    if (!device_is_ready(uart_dev)) {
-        LOG_ERR("UART device not ready");
-        return -ENODEV;
-    }
+    /* Send to physical UART */
+    console_send_string(str, len);
 
 #ifdef CONFIG_USB_CDC_ACM
-    /* Get USB CDC ACM device */
-    usb_uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_cdc_acm_uart0));
-    if (!device_is_ready(usb_uart_dev)) {
-        LOG_WRN("USB CDC ACM device not ready");
-        usb_uart_dev = NULL;
-    } else {
-        LOG_INF("USB CDC ACM device ready");
+    /* Queue for USB CDC ACM, nobody reads it without DTR */
+    cdc_queue(str, len, 0);
+#endif
+}
+
+/* Command replies go back over the host link only */
+static bool reply_send(uart_channel_t channel, const char *str, int len,
+                       uint32_t headroom)
+{
+#ifdef CONFIG_USB_CDC_ACM
+    tx_link_t *link = reply_link(channel);
+
+    if (link != NULL) {
+        return link_queue(link, str, len, headroom);
     }
+#else
+    ARG_UNUSED(channel);
+    ARG_UNUSED(headroom);
 #endif
 
-    LOG_INF("UART output initialized successfully");
-    return 0;
+    console_send_string(str, len);
+    return true;
 }
 
-void uart_output_device_info(const uwb_device_info_t *info)
+/* Format a sighting into output_buffer; called with output_mutex held */
+static int format_device_info(const uwb_device_info_t *info, bool journaled,
+                              uint32_t suppressed)
 {
-    k_mutex_lock(&output_mutex, K_FOREVER);
-
     /* Format device information as JSON */
     int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
         "{"
         "\"type\":\"device_found\","
         "\"timestamp_ms\":%u,"
+        "\"timestamp_us\":%llu,"
         "\"device_addr\":\"%016llX\","
         "\"distance_cm\":%.2f,"
         "\"rssi_dbm\":%.2f,"
@@ -91,9 +283,11 @@ void uart_output_device_info(const uwb_device_info_t *info)
         "\"fpp_level\":%.2f,"
         "\"channel\":%u,"
         "\"prf\":%u,"
-        "\"frame_quality\":%u"
-        "}\r\n",
+        "\"frame_quality\":%u,"
+        "\"seq\":%u,"
+        "\"rx_ts\":%llu",
         info->timestamp_ms,
+        info->timestamp_us,
         info->device_addr,
         (double)info->distance_cm,
         (double)info->rssi_dbm,
@@ -101,41 +295,321 @@ void uart_output_device_info(const uwb_device_info_t *info)
         (double)info->fpp_level,
         info->channel,
         info->prf,
-        info->frame_quality
+        info->frame_quality,
+        info->seq_num,
+        info->rx_timestamp
     );
 
+    /* RX instant on the uptime clock once the timebase has locked */
+    if (info->rx_time_valid && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"rx_ns\":%llu", info->rx_time_ns);
+    }
+
+    /* Shared-timebase timestamp only when the clock sync is locked */
+    if (info->sync_valid && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"sync_ts\":%llu", info->sync_timestamp);
+    }
+
+    /* Sightings of this device left out while throttled */
+    if (suppressed > 0 && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"suppressed\":%u", suppressed);
+    }
+
+    /* Replayed from the journal after the host reconnected */
+    if (journaled && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"journaled\":true");
+    }
+
     if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
-        uart_send_string(output_buffer);
-    } else {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "}\r\n");
+    }
+
+    if (len <= 0 || len >= OUTPUT_BUFFER_SIZE) {
         LOG_ERR("Output buffer overflow");
+        return -ENOMEM;
     }
 
-    k_mutex_unlock(&output_mutex);
+    return len;
 }
 
-void uart_output_status(const char *message)
+#ifdef CONFIG_USB_CDC_ACM
+/* Fidelity fixed by the configuration, or SCANNER_CONFIG_OUTPUT_AUTO */
+static int8_t forced_mode(void)
 {
-    k_mutex_lock(&output_mutex, K_FOREVER);
+    const scanner_config_t *config = scanner_config_acquire();
+    int8_t mode = config->output_mode;
+
+    scanner_config_release(config);
+    return mode;
+}
+
+/* Fidelity in effect, a forced mode applies without waiting for the monitor */
+static uart_output_mode_t current_mode(void)
+{
+    int8_t forced = forced_mode();
+
+    return forced != SCANNER_CONFIG_OUTPUT_AUTO ? (uart_output_mode_t)forced : output_mode;
+}
 
+/* Announce a fidelity change; called with output_mutex held */
+static void output_link_status(uart_output_mode_t prev, uint32_t queued)
+{
     int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
-        "{\"type\":\"status\",\"message\":\"%s\"}\r\n",
-        message
+        "{\"type\":\"link\",\"mode\":\"%s\",\"prev\":\"%s\","
+        "\"drain_bps\":%u,\"offered_bps\":%u,\"queued\":%u,\"dropped\":%u}\r\n",
+        mode_names[output_mode], mode_names[prev],
+        drain_bps, offered_bps, queued, dropped_total
     );
 
     if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
-        uart_send_string(output_buffer);
+        cdc_queue(output_buffer, len, 0);
+    }
+}
+
+/* Report one device's sightings since its last record */
+static bool output_summary_cb(device_entry_t *entry, void *user_data)
+{
+    uint32_t now_ms = *(uint32_t *)user_data;
+
+    if (entry->pending == 0) {
+        return true;
+    }
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"summary\",\"timestamp_ms\":%u,\"device_addr\":\"%016llX\","
+        "\"count\":%u,\"rssi_max\":%.2f,\"rssi_last\":%.2f,\"last_ms\":%u}\r\n",
+        now_ms, entry->device_addr, entry->pending,
+        (double)entry->best_rssi_dbm, (double)entry->last_rssi_dbm,
+        entry->last_seen_ms
+    );
+
+    /* Devices that do not fit stay pending for the next round */
+    if (len <= 0 || len >= OUTPUT_BUFFER_SIZE ||
+        !cdc_queue(output_buffer, len, TX_RECORD_HEADROOM)) {
+        return false;
+    }
+
+    device_table_mark_output(entry, now_ms);
+    return true;
+}
+
+static void link_monitor_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(link_monitor_work, link_monitor_handler);
+
+static void link_monitor_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    uint32_t now_ms = k_uptime_get_32();
+    uint32_t drained = (uint32_t)atomic_clear(&data_link.drained);
+    uint32_t offered = (uint32_t)atomic_clear(&data_link.offered);
+    uint32_t dropped = (uint32_t)atomic_clear(&data_link.dropped);
+
+    /* Rates smoothed over roughly one second */
+    drain_bps = (3 * drain_bps + drained * (1000 / LINK_MONITOR_MS)) / 4;
+    offered_bps = (3 * offered_bps + offered * (1000 / LINK_MONITOR_MS)) / 4;
+    dropped_total += dropped;
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    if (!host_connected()) {
+        /* Nobody is reading; start over at full fidelity next time */
+        k_spinlock_key_t key = k_spin_lock(&data_link.lock);
+        ring_buf_reset(data_link.ring);
+        k_spin_unlock(&data_link.lock, key);
+        output_mode = UART_OUTPUT_MODE_FULL;
+        calm_periods = 0;
+        goto out;
+    }
+
+    /* Startup record the host missed by connecting late */
+    if (boot_pending) {
+        int len = format_boot();
+        boot_pending = len > 0 && !cdc_queue(output_buffer, len, 0);
+    }
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+    /* Flight recorder dump held for the host */
+    if (flight_pending) {
+        flight_pending = false;
+        uart_output_flight(UART_CHANNEL_DATA);
+    }
+#endif
+
+    uint32_t queued = link_queued(&data_link);
+    uint32_t fill = queued * 100 / TX_RING_SIZE;
+
+    metric_set(&output_queue_bytes, queued);
+    metric_set(&output_drain_bps, drain_bps);
+    uart_output_mode_t prev = output_mode;
+
+    mode_offered_bps[output_mode] = offered_bps;
+
+    int8_t forced = forced_mode();
+
+    if (forced != SCANNER_CONFIG_OUTPUT_AUTO) {
+        /* Fixed by configuration, keep measuring but do not adapt */
+        output_mode = (uart_output_mode_t)forced;
+        calm_periods = 0;
+    } else if ((fill >= LINK_FILL_HIGH || dropped > 0) &&
+        output_mode < UART_OUTPUT_MODE_SUMMARY) {
+        /* Congested: what drained this period is what the host can take */
+        link_capacity_bps = drain_bps;
+        link_capacity_ms = now_ms;
+        output_mode++;
+        calm_periods = 0;
+    } else if (fill <= LINK_FILL_LOW) {
+        /* Step up once the richer mode's last load fits the measured drain */
+        if (++calm_periods >= LINK_CALM_PERIODS && output_mode > UART_OUTPUT_MODE_FULL &&
+            (mode_offered_bps[output_mode - 1] < link_capacity_bps * 9 / 10 ||
+             now_ms - link_capacity_ms >= LINK_PROBE_MS)) {
+            output_mode--;
+            calm_periods = 0;
+        }
+    } else {
+        calm_periods = 0;
+    }
+
+    if (output_mode != prev) {
+        LOG_INF("Output %s -> %s (drain %u B/s, offered %u B/s, queued %u)",
+                mode_names[prev], mode_names[output_mode],
+                drain_bps, offered_bps, queued);
+        output_link_status(prev, queued);
+    }
+
+    if (output_mode == UART_OUTPUT_MODE_SUMMARY &&
+        now_ms - summary_ms >= CONFIG_UWB_OUTPUT_THROTTLE_MS) {
+        summary_ms = now_ms;
+        device_table_foreach(0, output_summary_cb, &now_ms);
     }
 
+out:
     k_mutex_unlock(&output_mutex);
+    k_work_schedule(&link_monitor_work, K_MSEC(LINK_MONITOR_MS));
 }
 
-void uart_output_error(const char *error_msg)
+/* Decide whether the host gets this sighting; called with output_mutex held */
+static bool cdc_want_sighting(device_entry_t *entry, const uwb_device_info_t *info,
+                              uint32_t *suppressed)
+{
+    *suppressed = 0;
+
+    switch (current_mode()) {
+    case UART_OUTPUT_MODE_FULL:
+        break;
+    case UART_OUTPUT_MODE_THROTTLED:
+        /* One record per device per interval, first sightings always */
+        if (entry->count > 1 &&
+            info->timestamp_ms - entry->last_output_ms < CONFIG_UWB_OUTPUT_THROTTLE_MS) {
+            return false;
+        }
+        *suppressed = entry->pending - 1;
+        break;
+    default:
+        /* Summaries only, sent from the link monitor */
+        return false;
+    }
+
+    device_table_mark_output(entry, info->timestamp_ms);
+    return true;
+}
+#endif /* CONFIG_USB_CDC_ACM */
+
+void uart_output_tx_isr(const struct device *dev)
+{
+#ifdef CONFIG_USB_CDC_ACM
+    tx_link_t *link = &data_link;
+    uint8_t *data;
+
+#if DT_HAS_CHOSEN(uwb_command_uart)
+    if (dev == command_link.dev) {
+        link = &command_link;
+    }
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&link->lock);
+
+    uint32_t len = ring_buf_get_claim(link->ring, &data, UINT32_MAX);
+    if (len == 0) {
+        uart_irq_tx_disable(dev);
+        k_spin_unlock(&link->lock, key);
+        return;
+    }
+
+    int sent = uart_fifo_fill(dev, data, len);
+    ring_buf_get_finish(link->ring, sent > 0 ? sent : 0);
+
+    if (sent > 0) {
+        atomic_add(&link->drained, sent);
+#ifdef CONFIG_UWB_LATENCY_TRACE
+        /* Under the lock, so sent + queued always matches link_end() */
+        link->sent_total += sent;
+#endif
+    }
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    uint32_t sent_total = link->sent_total;
+#endif
+
+    k_spin_unlock(&link->lock, key);
+
+    UWB_TRACE("out_drain", sent, ring_buf_size_get(link->ring));
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    if (sent > 0 && link == &data_link) {
+        latency_trace_drained(sent_total);
+    }
+#endif
+#else
+    ARG_UNUSED(dev);
+#endif
+}
+
+uart_output_mode_t uart_output_get_mode(void)
+{
+#ifdef CONFIG_USB_CDC_ACM
+    return current_mode();
+#else
+    return UART_OUTPUT_MODE_FULL;
+#endif
+}
+
+#ifdef CONFIG_UWB_JOURNAL
+/* Journal flush thread */
+#define JOURNAL_STACK_SIZE 2048
+#define JOURNAL_PRIORITY 8
+#define JOURNAL_IDLE_MS 100
+
+static K_THREAD_STACK_DEFINE(journal_stack, JOURNAL_STACK_SIZE);
+static struct k_thread journal_thread;
+static bool journal_enabled;
+
+/* Room on the host link to replay a record without crowding live ones */
+static bool journal_can_flush(void)
+{
+#ifdef CONFIG_USB_CDC_ACM
+    return current_mode() == UART_OUTPUT_MODE_FULL &&
+           link_queued(&data_link) < TX_RING_SIZE / 2;
+#else
+    return true;
+#endif
+}
+
+static void output_journal_status(void)
 {
+    journal_stats_t stats;
+
+    journal_get_stats(&stats, true);
+
     k_mutex_lock(&output_mutex, K_FOREVER);
 
     int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
-        "{\"type\":\"error\",\"message\":\"%s\"}\r\n",
-        error_msg
+        "{\"type\":\"journal\",\"pending\":%u,\"capacity\":%u,"
+        "\"dropped\":%u,\"dropped_total\":%u}\r\n",
+        stats.pending, stats.capacity, stats.dropped, stats.dropped_total
     );
 
     if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
@@ -144,3 +618,836 @@ void uart_output_error(const char *error_msg)
 
     k_mutex_unlock(&output_mutex);
 }
+
+/*
+ * Runs below the scanner and statistics threads and takes the output
+ * mutex per record, so live sightings always get the link first. Each
+ * batch ends with a 1 ms sleep, which still leaves the flush well above
+ * USB full-speed throughput.
+ */
+static void journal_thread_fn(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    bool was_connected = true;
+    uwb_device_info_t info;
+
+    while (1) {
+        if (!host_connected()) {
+            was_connected = false;
+            journal_maintain();
+            k_sleep(K_MSEC(JOURNAL_IDLE_MS));
+            continue;
+        }
+
+        if (!was_connected) {
+            was_connected = true;
+            LOG_INF("Host connected, flushing journal");
+            output_journal_status();
+        }
+
+        int flushed = 0;
+        while (flushed < CONFIG_UWB_JOURNAL_FLUSH_BATCH && host_connected() &&
+               journal_can_flush() && journal_pop(&info)) {
+            k_mutex_lock(&output_mutex, K_FOREVER);
+            int len = format_device_info(&info, true, 0);
+            if (len > 0) {
+#ifdef CONFIG_USB_CDC_ACM
+                cdc_queue(output_buffer, len, TX_RECORD_HEADROOM);
+#else
+                console_send_string(output_buffer, len);
+#endif
+            }
+            k_mutex_unlock(&output_mutex);
+            flushed++;
+        }
+
+        k_sleep(K_MSEC(flushed > 0 ? 1 : JOURNAL_IDLE_MS));
+    }
+}
+#endif /* CONFIG_UWB_JOURNAL */
+
+int uart_output_init(void)
+{
+    LOG_INF("Initializing UART output");
+
+    /* Get UART device */
+    uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+    if (!device_is_ready(uart_dev)) {
+        LOG_ERR("UART device not ready");
+        return -ENODEV;
+    }
+
+#ifdef CONFIG_USB_CDC_ACM
+    /* Get USB CDC ACM device */
+    data_link.dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_cdc_acm_uart0));
+    if (!device_is_ready(data_link.dev)) {
+        LOG_WRN("USB CDC ACM device not ready");
+        data_link.dev = NULL;
+    } else {
+        LOG_INF("USB CDC ACM device ready");
+        k_work_schedule(&link_monitor_work, K_MSEC(LINK_MONITOR_MS));
+    }
+
+#if DT_HAS_CHOSEN(uwb_command_uart)
+    /* Dedicated command interface, replies are kept off the data stream */
+    command_link.dev = DEVICE_DT_GET(DT_CHOSEN(uwb_command_uart));
+    if (!device_is_ready(command_link.dev)) {
+        LOG_WRN("Command CDC ACM device not ready");
+        command_link.dev = NULL;
+    }
+#endif
+#endif
+
+#ifdef CONFIG_UWB_JOURNAL
+    /* Buffer sightings whenever the host is away from the data link */
+#ifdef CONFIG_USB_CDC_ACM
+    journal_enabled = data_link.dev != NULL;
+#else
+    journal_enabled = true;
+#endif
+    if (journal_enabled) {
+        journal_init();
+
+        k_thread_create(&journal_thread, journal_stack, JOURNAL_STACK_SIZE,
+                       journal_thread_fn, NULL, NULL, NULL,
+                       JOURNAL_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&journal_thread, "journal");
+    }
+#endif
+
+    LOG_INF("UART output initialized successfully");
+    return 0;
+}
+
+void uart_output_device_info(const uwb_device_info_t *info)
+{
+    uint32_t suppressed = 0;
+#ifdef CONFIG_USB_CDC_ACM
+    bool to_host = false;
+#endif
+#ifdef CONFIG_UWB_LATENCY_TRACE
+    latency_trace_t trace = info->trace;
+    bool traced = false;
+#endif
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    device_entry_t *entry = device_table_update(info);
+    metric_inc(&output_sightings);
+
+    /* Pull-only integrations query the table instead */
+    if (!streaming) {
+        k_mutex_unlock(&output_mutex);
+        return;
+    }
+
+#ifdef CONFIG_UWB_JOURNAL
+    /* Keep the sighting for the host; the console still gets it live */
+    if (journal_enabled && !host_connected()) {
+        journal_append(info);
+    }
+#endif
+
+#ifdef CONFIG_USB_CDC_ACM
+    if (data_link.dev != NULL) {
+        to_host = cdc_want_sighting(entry, info, &suppressed);
+    }
+#else
+    ARG_UNUSED(entry);
+#endif
+
+    int len = format_device_info(info, false, suppressed);
+    LATENCY_TRACE_MARK(&trace, LATENCY_MARK_SERIALIZE);
+    if (len > 0) {
+        console_send_string(output_buffer, len);
+#ifdef CONFIG_USB_CDC_ACM
+        /* The host link completes the trace once the record has drained */
+        if (to_host && cdc_queue(output_buffer, len, TX_RECORD_HEADROOM)) {
+#ifdef CONFIG_UWB_LATENCY_TRACE
+            latency_trace_defer(&trace, link_end(&data_link));
+            traced = true;
+#endif
+        }
+#endif
+#ifdef CONFIG_UWB_LATENCY_TRACE
+        if (!traced && IS_ENABLED(CONFIG_UWB_OUTPUT_CONSOLE)) {
+            LATENCY_TRACE_MARK(&trace, LATENCY_MARK_SINK);
+            latency_trace_record(&trace);
+        }
+#endif
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_status(const char *message)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"status\",\"message\":\"%s\"}\r\n",
+        message
+    );
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        uart_send_string(output_buffer);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_boot(const uart_output_boot_t *boot)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    boot_info = *boot;
+
+    int len = format_boot();
+    if (len > 0) {
+        console_send_string(output_buffer, len);
+#ifdef CONFIG_USB_CDC_ACM
+        boot_pending = !cdc_queue(output_buffer, len, 0);
+#endif
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_sync_response(uart_channel_t channel, uint64_t t1_us, uint64_t t2_us)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    uint64_t t3_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"sync_resp\",\"t1\":%llu,\"t2\":%llu,\"t3\":%llu}\r\n",
+        t1_us, t2_us, t3_us
+    );
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_error(const char *error_msg)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"error\",\"message\":\"%s\"}\r\n",
+        error_msg
+    );
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        uart_send_string(output_buffer);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+static int format_table_entry(const device_entry_t *entry, uint32_t now_ms)
+{
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"device\",\"device_addr\":\"%016llX\",\"count\":%u,"
+        "\"first_ms\":%u,\"last_ms\":%u,\"age_ms\":%u,\"rssi_last\":%.2f}\r\n",
+        entry->device_addr, entry->count, entry->first_seen_ms,
+        entry->last_seen_ms, now_ms - entry->last_seen_ms,
+        (double)entry->last_rssi_dbm
+    );
+
+    return (len > 0 && len < OUTPUT_BUFFER_SIZE) ? len : -ENOMEM;
+}
+
+/* Paged device table dump, resumed as the link drains */
+#define DUMP_RETRY_MS 5
+#define DUMP_HEADROOM 256   /* Same room sightings leave for status records */
+
+static struct {
+    bool active;
+    uart_channel_t channel;
+    uint32_t cursor;
+    uint32_t max_age_ms;
+    uint32_t now_ms;
+    uint32_t sent;
+} dump;
+
+static bool dump_entry_cb(device_entry_t *entry, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    if (dump.max_age_ms != 0 && dump.now_ms - entry->last_seen_ms > dump.max_age_ms) {
+        return true;
+    }
+
+    int len = format_table_entry(entry, dump.now_ms);
+    if (len < 0) {
+        return true;
+    }
+
+    if (!reply_send(dump.channel, output_buffer, len, DUMP_HEADROOM)) {
+        return false;
+    }
+
+    dump.sent++;
+    return true;
+}
+
+static void dump_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(dump_work, dump_work_handler);
+
+static void dump_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+#ifdef CONFIG_USB_CDC_ACM
+    /* The requester went away, drop the rest */
+    tx_link_t *link = reply_link(dump.channel);
+    if (link != NULL && !link_connected(link)) {
+        dump.active = false;
+        k_mutex_unlock(&output_mutex);
+        return;
+    }
+#endif
+
+    uint32_t cursor = device_table_foreach(dump.cursor, dump_entry_cb, NULL);
+    if (cursor != DEVICE_TABLE_END) {
+        dump.cursor = cursor;
+        k_work_schedule(&dump_work, K_MSEC(DUMP_RETRY_MS));
+    } else {
+        int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+            "{\"type\":\"devices_end\",\"count\":%u,\"total\":%u}\r\n",
+            dump.sent, device_table_count()
+        );
+        if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+            reply_send(dump.channel, output_buffer, len, 0);
+        }
+        dump.active = false;
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+int uart_output_device_table(uart_channel_t channel, uint32_t max_age_ms)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    if (dump.active) {
+        k_mutex_unlock(&output_mutex);
+        return -EBUSY;
+    }
+
+    dump.active = true;
+    dump.channel = channel;
+    dump.cursor = 0;
+    dump.max_age_ms = max_age_ms;
+    dump.now_ms = k_uptime_get_32();
+    dump.sent = 0;
+
+    k_mutex_unlock(&output_mutex);
+
+    k_work_schedule(&dump_work, K_NO_WAIT);
+    return 0;
+}
+
+int uart_output_device(uart_channel_t channel, uint64_t device_addr)
+{
+    int ret = 0;
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    device_entry_t *entry = device_table_find(device_addr);
+    if (entry == NULL) {
+        ret = -ENOENT;
+    } else {
+        int len = format_table_entry(entry, k_uptime_get_32());
+        if (len > 0) {
+            reply_send(channel, output_buffer, len, 0);
+        }
+    }
+
+    k_mutex_unlock(&output_mutex);
+    return ret;
+}
+
+void uart_output_counters(uart_channel_t channel)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"counters\",\"uptime_ms\":%u,\"sightings\":%u,"
+        "\"devices\":%u,\"streaming\":%s",
+        k_uptime_get_32(), metric_get(&output_sightings), device_table_count(),
+        streaming ? "true" : "false"
+    );
+
+#ifdef CONFIG_USB_CDC_ACM
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"mode\":\"%s\",\"drain_bps\":%u,\"tx_dropped\":%u",
+                        mode_names[current_mode()], drain_bps, dropped_total);
+    }
+#endif
+
+    uwb_scanner_power_stats_t power;
+
+    uwb_scanner_get_power_stats(&power);
+    if (power.sleeps > 0 && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"sleeps\":%u,\"wake_us\":%u,\"wake_us_max\":%u,"
+                        "\"radio_duty_pct\":%.1f",
+                        power.sleeps, power.wake_us_last, power.wake_us_max,
+                        power.duty_permille / 10.0);
+    }
+
+    /* Capture rate per profile, to compare profiles on site */
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"power_profile\":\"%s\",\"rx_duty_pct\":%.1f,\"frames_per_min\":{",
+                        scanner_config_power_name(power.profile),
+                        power.rx_duty_permille / 10.0);
+    }
+
+    for (int i = 0, n = 0; i < SCANNER_POWER_COUNT && len > 0 && len < OUTPUT_BUFFER_SIZE; i++) {
+        if (power.profile_ms[i] == 0) {
+            continue;
+        }
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "%s\"%s\":%.1f",
+                        n++ > 0 ? "," : "", scanner_config_power_name(i),
+                        power.profile_frames[i] * 60000.0 / power.profile_ms[i]);
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "}");
+    }
+
+#ifdef CONFIG_UWB_JOURNAL
+    journal_stats_t stats;
+
+    journal_get_stats(&stats, false);
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"journal_pending\":%u,\"journal_dropped\":%u",
+                        stats.pending, stats.dropped_total);
+    }
+#endif
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "}\r\n");
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_config(uart_channel_t channel)
+{
+    scanner_config_t config;
+
+    scanner_config_get(&config);
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"config\",\"version\":%u,\"channel\":%u,\"prf\":%u,"
+        "\"preamble_code\":%u,\"plen\":%u,\"pac\":%u,\"rx_window_ms\":%u,\"sleep_ms\":%u,"
+        "\"power_profile\":\"%s\",\"sniff_on_pac\":%u,\"sniff_off\":%u,"
+        "\"min_rssi\":%.2f,\"min_quality\":%u,\"output_mode\":\"%s\",\"allow\":[",
+        config.version, config.radio.channel,
+        config.radio.prf == DW3000_PRF_64M ? 64 : 16,
+        config.radio.rx_preamble_code,
+        scanner_config_plen_symbols(config.radio.preamble_length),
+        config.radio.pac_size, config.rx_window_ms, config.sleep_ms,
+        scanner_config_power_name(config.power_profile),
+        config.radio.sniff_on_pac, config.radio.sniff_off,
+        (double)config.min_rssi_dbm, config.min_frame_quality,
+        config.output_mode == SCANNER_CONFIG_OUTPUT_AUTO ? "auto" :
+        mode_names[config.output_mode]
+    );
+
+    for (uint8_t i = 0; i < config.allow_count && len > 0 && len < OUTPUT_BUFFER_SIZE; i++) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "%s\"%016llX\"",
+                        i > 0 ? "," : "", config.allow_list[i]);
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "]}\r\n");
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_metrics(uart_channel_t channel)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = metrics_format(metrics_buffer, sizeof(metrics_buffer));
+    if (len > 0) {
+        reply_send(channel, metrics_buffer, len, 0);
+    } else {
+        LOG_WRN("Metrics record exceeds %zu bytes", sizeof(metrics_buffer));
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+#ifdef CONFIG_UWB_THREAD_STATS
+void uart_output_threads(uart_channel_t channel)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = thread_stats_format(metrics_buffer, sizeof(metrics_buffer));
+    if (len > 0) {
+        reply_send(channel, metrics_buffer, len, 0);
+    } else {
+        LOG_WRN("Thread record exceeds %zu bytes", sizeof(metrics_buffer));
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+#endif
+
+#ifdef CONFIG_UWB_LATENCY_TRACE
+void uart_output_latency(uart_channel_t channel, bool reset)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = latency_trace_format(output_buffer, OUTPUT_BUFFER_SIZE);
+    if (len > 0) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    if (reset) {
+        latency_trace_reset();
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+#endif
+
+#ifdef CONFIG_UWB_SPI_PROFILE
+#define SPI_SUMMARY_TOP 3
+
+/* "SYS_STATUS/r", "RX/cmd" or the raw address when the driver has no name */
+static void spi_label(uint16_t key, char *buf, size_t size)
+{
+    const char *name = spi_profile_name(key);
+    const char *dir = (key & SPI_PROFILE_FAST_CMD) ? "cmd" :
+                      (key & SPI_PROFILE_WRITE) ? "w" : "r";
+
+    if (name != NULL) {
+        snprintf(buf, size, "%s/%s", name, dir);
+    } else {
+        snprintf(buf, size, "0x%04X/%s",
+                 key & ~(SPI_PROFILE_FAST_CMD | SPI_PROFILE_WRITE), dir);
+    }
+}
+
+void uart_output_spi_profile(uart_channel_t channel, bool reset)
+{
+    spi_profile_entry_t entry;
+    spi_profile_entry_t total;
+    uint32_t untracked;
+    uint32_t entries = 0;
+    char label[24];
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    for (unsigned int i = 0; i < CONFIG_UWB_SPI_PROFILE_SLOTS; i++) {
+        if (!spi_profile_get(i, &entry)) {
+            continue;
+        }
+
+        spi_label(entry.key, label, sizeof(label));
+        int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+            "{\"type\":\"spi_reg\",\"reg\":\"%s\",\"count\":%u,\"bytes\":%u,"
+            "\"bus_us\":%llu,\"errors\":%u}\r\n",
+            label, entry.count, entry.bytes, entry.bus_ns / 1000U, entry.errors
+        );
+        if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+            reply_send(channel, output_buffer, len, 0);
+        }
+        entries++;
+    }
+
+    uint32_t window_ms = spi_profile_totals(&total, &untracked);
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"spi_end\",\"entries\":%u,\"count\":%u,\"bytes\":%u,"
+        "\"bus_us\":%llu,\"errors\":%u,\"untracked\":%u,\"window_ms\":%u}\r\n",
+        entries, total.count, total.bytes, total.bus_ns / 1000U, total.errors,
+        untracked, window_ms
+    );
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    if (reset) {
+        spi_profile_reset();
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+
+void uart_output_spi_summary(uart_channel_t channel)
+{
+    spi_profile_entry_t top[SPI_SUMMARY_TOP] = {0};
+    spi_profile_entry_t entry;
+    spi_profile_entry_t total;
+    uint32_t untracked;
+    char label[24];
+
+    /* Registers with the most bus time, largest first */
+    for (unsigned int i = 0; i < CONFIG_UWB_SPI_PROFILE_SLOTS; i++) {
+        if (!spi_profile_get(i, &entry)) {
+            continue;
+        }
+        for (int t = 0; t < SPI_SUMMARY_TOP; t++) {
+            if (entry.bus_ns > top[t].bus_ns) {
+                memmove(&top[t + 1], &top[t], (SPI_SUMMARY_TOP - t - 1) * sizeof(top[0]));
+                top[t] = entry;
+                break;
+            }
+        }
+    }
+
+    uint32_t window_ms = spi_profile_totals(&total, &untracked);
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"spi\",\"window_ms\":%u,\"count\":%u,\"bytes\":%u,"
+        "\"bus_us\":%llu,\"bus_permille\":%u,\"errors\":%u,\"top\":[",
+        window_ms, total.count, total.bytes, total.bus_ns / 1000U,
+        window_ms > 0 ? (uint32_t)(total.bus_ns / 1000U / window_ms) : 0,
+        total.errors
+    );
+
+    for (int t = 0; t < SPI_SUMMARY_TOP && top[t].count > 0 &&
+         len > 0 && len < OUTPUT_BUFFER_SIZE; t++) {
+        spi_label(top[t].key, label, sizeof(label));
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+            "%s[\"%s\",%u,%llu]", t > 0 ? "," : "", label, top[t].count,
+            top[t].bus_ns / 1000U);
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "]}\r\n");
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
+#endif
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+static int format_flight_entry(char *buf, size_t size, uint32_t seq, const fr_entry_t *e)
+{
+    int len = snprintf(buf, size,
+        "{\"type\":\"flight\",\"seq\":%u,\"boot\":%u,\"t_us\":%u,\"ev\":\"%s\","
+        "\"a\":%u,\"b\":%u,\"c\":%u}\r\n",
+        seq, e->boot, e->time_us, flight_recorder_type_name(e->type), e->a, e->b, e->c
+    );
+
+    return (len > 0 && (size_t)len < size) ? len : -ENOMEM;
+}
+
+static int format_flight_end(char *buf, size_t size, uint32_t count)
+{
+    int len = snprintf(buf, size,
+        "{\"type\":\"flight_end\",\"count\":%u,\"boots\":%u,\"capacity\":%u,"
+        "\"prev_fatal\":%s}\r\n",
+        count, flight_recorder_boots(), CONFIG_UWB_FLIGHT_RECORDER_ENTRIES,
+        flight_recorder_prev_fatal() ? "true" : "false"
+    );
+
+    return (len > 0 && (size_t)len < size) ? len : -ENOMEM;
+}
+
+/* Paged flight recorder dump, up to the head at the time it was asked for */
+static struct {
+    bool active;
+    uart_channel_t channel;
+    uint32_t seq;
+    uint32_t end;
+    uint32_t sent;
+} flight;
+
+static void flight_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(flight_work, flight_work_handler);
+
+static void flight_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    fr_entry_t entry;
+
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+#ifdef CONFIG_USB_CDC_ACM
+    /* The requester went away, drop the rest */
+    tx_link_t *link = reply_link(flight.channel);
+    if (link != NULL && !link_connected(link)) {
+        flight.active = false;
+        k_mutex_unlock(&output_mutex);
+        return;
+    }
+#endif
+
+    for (; flight.seq < flight.end; flight.seq++) {
+        /* Entries lapped by the writers since the dump started are gone */
+        uint32_t oldest = flight_recorder_oldest();
+        if (flight.seq < oldest) {
+            flight.seq = oldest;
+            if (flight.seq >= flight.end) {
+                break;
+            }
+        }
+        if (!flight_recorder_get(flight.seq, &entry)) {
+            continue;
+        }
+
+        int len = format_flight_entry(output_buffer, OUTPUT_BUFFER_SIZE, flight.seq, &entry);
+        if (len < 0) {
+            continue;
+        }
+        if (!reply_send(flight.channel, output_buffer, len, DUMP_HEADROOM)) {
+            k_work_schedule(&flight_work, K_MSEC(DUMP_RETRY_MS));
+            k_mutex_unlock(&output_mutex);
+            return;
+        }
+        flight.sent++;
+    }
+
+    int len = format_flight_end(output_buffer, OUTPUT_BUFFER_SIZE, flight.sent);
+    if (len > 0) {
+        reply_send(flight.channel, output_buffer, len, 0);
+    }
+    flight.active = false;
+
+    k_mutex_unlock(&output_mutex);
+}
+
+int uart_output_flight(uart_channel_t channel)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    if (flight.active) {
+        k_mutex_unlock(&output_mutex);
+        return -EBUSY;
+    }
+
+#ifdef CONFIG_USB_CDC_ACM
+    if (channel == UART_CHANNEL_DATA && !host_connected()) {
+        flight_pending = true;
+        k_mutex_unlock(&output_mutex);
+        return 0;
+    }
+#endif
+
+    flight.active = true;
+    flight.channel = channel;
+    flight.seq = flight_recorder_oldest();
+    flight.end = flight_recorder_head();
+    flight.sent = 0;
+
+    k_mutex_unlock(&output_mutex);
+
+    k_work_schedule(&flight_work, K_NO_WAIT);
+    return 0;
+}
+
+void uart_output_flight_panic(void)
+{
+    /* Other threads are stopped; output_buffer may be mid-update */
+    char line[128];
+    fr_entry_t entry;
+    uint32_t count = 0;
+
+    if (uart_dev == NULL || !device_is_ready(uart_dev)) {
+        return;
+    }
+
+    for (uint32_t seq = flight_recorder_oldest(); seq < flight_recorder_head(); seq++) {
+        if (!flight_recorder_get(seq, &entry)) {
+            continue;
+        }
+
+        int len = format_flight_entry(line, sizeof(line), seq, &entry);
+        for (int i = 0; i < len; i++) {
+            uart_poll_out(uart_dev, line[i]);
+        }
+        count++;
+    }
+
+    int len = format_flight_end(line, sizeof(line), count);
+    for (int i = 0; i < len; i++) {
+        uart_poll_out(uart_dev, line[i]);
+    }
+}
+#endif
+
+void uart_output_set_streaming(bool enable)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+    streaming = enable;
+    k_mutex_unlock(&output_mutex);
+
+    LOG_INF("Sighting stream %s", enable ? "enabled" : "disabled");
+}
+
+bool uart_output_get_streaming(void)
+{
+    return streaming;
+}
+
+void uart_output_set_host_connected(bool connected)
+{
+#ifdef CONFIG_USB_CDC_ACM
+    ARG_UNUSED(connected);
+#else
+    atomic_set(&console_host, connected ? 1 : 0);
+    LOG_INF("Console host %s", connected ? "connected" : "disconnected");
+#endif
+}
+
+void uart_output_response(uart_channel_t channel, const char *cmd, int status,
+                          const char *message)
+{
+    k_mutex_lock(&output_mutex, K_FOREVER);
+
+    int len = snprintf(output_buffer, OUTPUT_BUFFER_SIZE,
+        "{\"type\":\"resp\",\"cmd\":\"%s\",\"status\":%d",
+        cmd, status
+    );
+
+    if (message != NULL && len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len,
+                        ",\"message\":\"%s\"", message);
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        len += snprintf(output_buffer + len, OUTPUT_BUFFER_SIZE - len, "}\r\n");
+    }
+
+    if (len > 0 && len < OUTPUT_BUFFER_SIZE) {
+        reply_send(channel, output_buffer, len, 0);
+    }
+
+    k_mutex_unlock(&output_mutex);
+}
@@ -5,11 +5,19 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 #include <string.h>
-#include <math.h>
 
 #include "uwb_scanner.h"
 #include "dw3000_driver.h"
+#include "frame_parse.h"
+#include "clock_sync.h"
+#include "timebase.h"
+#include "scanner_config.h"
+#include "scanner_settings.h"
+#include "metrics.h"
+#include "uwb_trace.h"
+#include "flight_recorder.h"
 
 LOG_MODULE_REGISTER(uwb_scanner, LOG_LEVEL_INF);
 
@@ -24,92 +32,362 @@ static uwb_device_callback_t device_callback = NULL;
 static K_THREAD_STACK_DEFINE(scanner_stack, SCANNER_STACK_SIZE);
 static struct k_thread scanner_thread;
 
-/* IEEE 802.15.4 frame types */
-#define IEEE154_FRAME_TYPE_BEACON 0x00
-#define IEEE154_FRAME_TYPE_DATA   0x01
-#define IEEE154_FRAME_TYPE_ACK    0x02
-#define IEEE154_FRAME_TYPE_MAC    0x03
-
-/* Frame control field parsing */
-typedef struct {
-    uint8_t frame_type;
-    bool security_enabled;
-    bool frame_pending;
-    bool ack_request;
-    bool pan_id_compress;
-    uint8_t dest_addr_mode;
-    uint8_t src_addr_mode;
-} ieee154_fcf_t;
-
-/* Parse IEEE 802.15.4 frame control field */
-static void parse_frame_control(uint16_t fcf, ieee154_fcf_t *parsed)
+/* Radio configuration currently programmed into the DW3000 */
+static dw3000_config_t applied_radio;
+static uint32_t applied_version;
+
+/* Boot used the stored settings; first frame is logged to time the boot */
+static bool warm_boot;
+static uint32_t first_frame_us;    /* 0 until the first frame is read */
+
+/* Duty cycling: radio time split and wake-to-RX latency */
+static struct k_spinlock power_lock;   /* 64-bit split, read from other threads */
+static uint64_t awake_cyc;
+static uint64_t asleep_cyc;
+static uint64_t awake_since_cyc;       /* 0 while the radio sleeps or is stopped */
+static uint64_t wake_start_cyc;    /* Set until the first RX enable after a wake */
+
+METRIC_COUNTER_DEFINE(scanner_sleeps);
+METRIC_GAUGE_DEFINE(scanner_wake_us_last);
+METRIC_GAUGE_DEFINE(scanner_wake_us_max);
+
+/* Capture rate per power profile */
+static uint8_t current_profile;
+
+METRIC_COUNTER_DEFINE(scanner_frames_full);
+METRIC_COUNTER_DEFINE(scanner_frames_sniff);
+METRIC_COUNTER_DEFINE(scanner_ms_full);
+METRIC_COUNTER_DEFINE(scanner_ms_sniff);
+
+static struct metric *const profile_frames[SCANNER_POWER_COUNT] = {
+    [SCANNER_POWER_FULL] = &scanner_frames_full,
+    [SCANNER_POWER_SNIFF] = &scanner_frames_sniff,
+};
+static struct metric *const profile_ms[SCANNER_POWER_COUNT] = {
+    [SCANNER_POWER_FULL] = &scanner_ms_full,
+    [SCANNER_POWER_SNIFF] = &scanner_ms_sniff,
+};
+
+/* Frame pipeline: where each read frame ended up */
+METRIC_COUNTER_DEFINE(scanner_cycles);
+METRIC_COUNTER_DEFINE(scanner_frames);
+METRIC_COUNTER_DEFINE(scanner_beacons);
+METRIC_COUNTER_DEFINE(scanner_duplicates);
+METRIC_COUNTER_DEFINE(scanner_filtered);
+METRIC_COUNTER_DEFINE(scanner_sightings);
+METRIC_HISTOGRAM_DEFINE(scanner_wake_us);
+METRIC_HISTOGRAM_DEFINE(scanner_report_us);   /* Frame read to callback done */
+
+/* Recovery: consecutive failed cycles before the chip is re-initialized,
+ * and re-inits per thread start before main() is left to restart it
+ */
+#define SCANNER_ERROR_LIMIT         3
+#define SCANNER_RECOVERY_ATTEMPTS   3
+#define SCANNER_CHECK_CYCLES        100     /* Device ID check while all is well */
+
+static uint8_t failed_cycles;
+static uint8_t recovery_attempts;
+static uint32_t quiet_cycles;
+static bool chip_lost;
+
+METRIC_COUNTER_DEFINE(scanner_recoveries);
+METRIC_COUNTER_DEFINE(scanner_lost);
+
+/* Last reported frame, to drop duplicate reads */
+static uint64_t last_addr;
+static uint64_t last_rx_timestamp;
+
+/* Apply a new configuration snapshot at the start of a scan cycle */
+static void scan_apply_config(const scanner_config_t *config)
 {
-    parsed->frame_type = fcf & 0x07;
-    parsed->security_enabled = (fcf & 0x08) != 0;
-    parsed->frame_pending = (fcf & 0x10) != 0;
-    parsed->ack_request = (fcf & 0x20) != 0;
-    parsed->pan_id_compress = (fcf & 0x40) != 0;
-    parsed->dest_addr_mode = (fcf >> 10) & 0x03;
-    parsed->src_addr_mode = (fcf >> 14) & 0x03;
+    if (config->version == applied_version) {
+        return;
+    }
+
+    /* Only touch the radio if its settings changed */
+    if (memcmp(&config->radio, &applied_radio, sizeof(applied_radio)) != 0) {
+        int ret = dw3000_configure(&config->radio);
+        if (ret < 0) {
+            LOG_ERR("Failed to apply configuration %u: %d", config->version, ret);
+            return;
+        }
+        applied_radio = config->radio;
+    }
+
+    applied_version = config->version;
+    FLIGHT_RECORD(FR_CONFIG, config->version, 0, 0);
+    LOG_INF("Configuration %u applied", config->version);
 }
 
-/* Extract device address from frame */
-static uint64_t extract_device_address(const uint8_t *frame, uint16_t length,
-                                      const ieee154_fcf_t *fcf)
+/* Full bring-up with the configuration last applied */
+static int scanner_reinit(void)
 {
-    uint64_t addr = 0;
-    int offset = 3; /* Skip FCF and sequence number */
+    int ret = dw3000_init();
+    if (ret == 0) {
+        ret = dw3000_configure(&applied_radio);
+    }
+
+    return ret;
+}
 
-    /* Skip destination PAN ID if present */
-    if (fcf->dest_addr_mode != 0) {
-        offset += 2;
+/* Re-initialize a DW3000 that stopped answering; once that keeps failing,
+ * stop the thread and leave the restart to main()
+ */
+static void scanner_recover(void)
+{
+    int ret = scanner_reinit();
+    FLIGHT_RECORD(FR_RECOVERY, recovery_attempts, ret, 0);
+
+    if (ret == 0) {
+        LOG_WRN("DW3000 recovered");
+        metric_inc(&scanner_recoveries);
+        chip_lost = false;
+        recovery_attempts = 0;
+        timebase_resync();
+        return;
+    }
+
+    chip_lost = true;
+    LOG_ERR("DW3000 recovery failed: %d", ret);
+
+    if (++recovery_attempts >= SCANNER_RECOVERY_ATTEMPTS) {
+        LOG_ERR("DW3000 lost after %u attempts, stopping scanner", recovery_attempts);
+        metric_inc(&scanner_lost);
+        scanner_active = false;
+    }
+}
+
+/* Track failed cycles and check the chip now and then */
+static void scanner_check_health(int cycle_ret)
+{
+    /* A failed re-init leaves the chip reset but unconfigured */
+    if (chip_lost) {
+        cycle_ret = -ENODEV;
+    }
+
+    if (cycle_ret == 0 && ++quiet_cycles < SCANNER_CHECK_CYCLES) {
+        failed_cycles = 0;
+        return;
+    }
+    quiet_cycles = 0;
+
+    /* Errors, or a chip that silently went away */
+    if (cycle_ret == 0) {
+        cycle_ret = dw3000_check_id();
+    }
+    if (cycle_ret == 0) {
+        failed_cycles = 0;
+        return;
     }
 
-    /* Skip destination address */
-    if (fcf->dest_addr_mode == 2) {
-        offset += 2; /* Short address */
-    } else if (fcf->dest_addr_mode == 3) {
-        offset += 8; /* Extended address */
+    if (++failed_cycles >= SCANNER_ERROR_LIMIT) {
+        failed_cycles = 0;
+        scanner_recover();
     }
+}
+
+/* Put the radio into DEEPSLEEP between cycles and bring it back */
+static void scan_sleep(uint32_t sleep_ms)
+{
+    uint64_t sleep_start = k_cycle_get_64();
 
-    /* Skip source PAN ID if present and not compressed */
-    if (fcf->src_addr_mode != 0 && !fcf->pan_id_compress) {
-        offset += 2;
+    UWB_TRACE("sleep", sleep_ms, 0);
+    FLIGHT_RECORD(FR_SLEEP, 0, sleep_ms, 0);
+    int ret = dw3000_sleep();
+    if (ret < 0) {
+        LOG_WRN("Failed to put DW3000 to sleep: %d", ret);
+        k_sleep(K_MSEC(sleep_ms));
+        return;
     }
 
-    /* Extract source address */
-    if (fcf->src_addr_mode == 3 && offset + 8 <= length) {
-        /* Extended 64-bit address */
-        for (int i = 0; i < 8; i++) {
-            addr |= ((uint64_t)frame[offset + i]) << (i * 8);
+    k_spinlock_key_t key = k_spin_lock(&power_lock);
+    awake_cyc += sleep_start - awake_since_cyc;
+    awake_since_cyc = 0;
+    k_spin_unlock(&power_lock, key);
+
+    k_sleep(K_MSEC(sleep_ms));
+
+    wake_start_cyc = k_cycle_get_64();
+    key = k_spin_lock(&power_lock);
+    asleep_cyc += wake_start_cyc - sleep_start;
+    awake_since_cyc = wake_start_cyc;
+    k_spin_unlock(&power_lock, key);
+
+    /* The chip restores its configuration from AON on its own */
+    ret = dw3000_wake();
+    if (ret < 0) {
+        /* Lost it: full bring-up with the configuration last applied */
+        ret = scanner_reinit();
+        if (ret < 0) {
+            LOG_ERR("Failed to recover DW3000 after sleep: %d", ret);
+            chip_lost = true;
         }
-    } else if (fcf->src_addr_mode == 2 && offset + 2 <= length) {
-        /* Short 16-bit address */
-        addr = frame[offset] | ((uint64_t)frame[offset + 1] << 8);
     }
 
-    return addr;
+    UWB_TRACE("wake", ret, 0);
+    FLIGHT_RECORD(FR_WAKE, 0, ret, 0);
+
+    /* The device clock restarted from zero while asleep */
+    timebase_resync();
+    metric_inc(&scanner_sleeps);
 }
 
-/* Calculate distance from first path power metrics */
-static float calculate_distance(uint16_t fpp_index, float fpp_level, float rssi)
+/* One RX window: enable, wait, read and report at most one frame;
+ * returns an error if the radio could not be driven
+ */
+static int scan_cycle(const scanner_config_t *config)
 {
-    /* Simplified distance calculation based on two-way ranging time */
-    /* This is an approximation - actual ranging requires two-way exchange */
+    dw3000_rx_frame_t rx_frame;
+    uwb_device_info_t device_info;
 
-    /* Convert RSSI to distance using path loss model */
-    /* Path loss: PL(d) = PL(d0) + 10*n*log10(d/d0) */
-    /* Where n is path loss exponent (typically 2-4 for indoor) */
+    metric_inc(&scanner_cycles);
 
-    const float tx_power = 0.0f;  /* dBm */
-    const float pl_d0 = 40.0f;     /* Path loss at 1m reference */
-    const float path_loss_exp = 2.5f;  /* Indoor environment */
+    /* Enable receiver */
+    int ret = dw3000_rx_enable(config->rx_window_ms * 2);
+    if (ret < 0) {
+        FLIGHT_RECORD(FR_RX_ERROR, 0, ret, 0);
+        LOG_ERR("Failed to enable RX: %d", ret);
+        k_sleep(K_MSEC(100));
+        return ret;
+    }
+
+    /* Wake-to-RX latency of the first cycle after a sleep */
+    if (wake_start_cyc != 0) {
+        uint32_t wake_us = (uint32_t)k_cyc_to_us_floor64(k_cycle_get_64() - wake_start_cyc);
+
+        /* Only this thread writes the gauges */
+        metric_set(&scanner_wake_us_last, (int32_t)wake_us);
+        metric_set(&scanner_wake_us_max,
+                   (int32_t)MAX(metric_get(&scanner_wake_us_max), wake_us));
+        metric_observe(&scanner_wake_us, wake_us);
+        wake_start_cyc = 0;
+    }
+
+    /* Wait for frame or timeout */
+    k_sleep(K_MSEC(config->rx_window_ms));
+
+    /* Check if frame is ready */
+    ret = dw3000_poll_frame();
+    if (ret < 0) {
+        FLIGHT_RECORD(FR_RX_ERROR, 2, ret, 0);
+        return ret;
+    }
+    if (ret == 0) {
+        return 0;
+    }
+    LATENCY_TRACE_MARK(&device_info.trace, LATENCY_MARK_READY);
+    UWB_TRACE("rx_ready", 0, 0);
 
-    float path_loss = tx_power - rssi;
-    float distance_m = powf(10.0f, (path_loss - pl_d0) / (10.0f * path_loss_exp));
+    /* Read the frame */
+    ret = dw3000_read_frame(&rx_frame);
+    if (ret < 0) {
+        FLIGHT_RECORD(FR_RX_ERROR, 1, ret, 0);
+        LOG_ERR("Failed to read frame: %d", ret);
+        return ret;
+    }
+    uint32_t read_cyc = k_cycle_get_32();
+    LATENCY_TRACE_MARK(&device_info.trace, LATENCY_MARK_READ);
+    metric_inc(profile_frames[config->power_profile]);
+    metric_inc(&scanner_frames);
+
+#ifdef CONFIG_UWB_FLIGHT_RECORDER
+    /* Frame control, sequence number and PAN/address bytes */
+    uint8_t header[8] = {0};
+    memcpy(header, rx_frame.buffer, MIN(rx_frame.length, sizeof(header)));
+    FLIGHT_RECORD(FR_FRAME, rx_frame.length, sys_get_le32(header), sys_get_le32(header + 4));
+#endif
+
+    LOG_DBG("Frame received: length=%d, RSSI=%.2f dBm",
+           rx_frame.length, rx_frame.rssi);
+
+    if (first_frame_us == 0) {
+        first_frame_us = MAX((uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()), 1U);
+        LOG_INF("First frame %u us after boot (%s boot)",
+                first_frame_us, warm_boot ? "warm" : "cold");
+    }
 
-    /* Convert to centimeters */
-    return distance_m * 100.0f;
+    /* Sync beacons feed the clock fit and are not reported */
+    if (clock_sync_process_frame(rx_frame.buffer, rx_frame.length,
+                                 rx_frame.timestamp)) {
+        metric_inc(&scanner_beacons);
+        return 0;
+    }
+
+    /* Parse frame to extract device information */
+    if (rx_frame.length < 3) {
+        return 0;
+    }
+
+    uint16_t fcf = rx_frame.buffer[0] | (rx_frame.buffer[1] << 8);
+    ieee154_fcf_t fcf_parsed;
+    frame_parse_fcf(fcf, &fcf_parsed);
+
+    /* Extract device address */
+    device_info.device_addr = frame_parse_source_address(
+        rx_frame.buffer, rx_frame.length, &fcf_parsed);
+
+    /* Drop a frame read twice (same source, same RX instant) */
+    if (device_info.device_addr == last_addr &&
+        rx_frame.timestamp == last_rx_timestamp) {
+        metric_inc(&scanner_duplicates);
+        return 0;
+    }
+    last_addr = device_info.device_addr;
+    last_rx_timestamp = rx_frame.timestamp;
+
+    /* Only report valid addresses */
+    if (device_info.device_addr == 0) {
+        return 0;
+    }
+
+    /* Report thresholds and allow-list */
+    if (rx_frame.rssi < config->min_rssi_dbm ||
+        rx_frame.frame_quality < config->min_frame_quality ||
+        !scanner_config_allows(config, device_info.device_addr)) {
+        metric_inc(&scanner_filtered);
+        return 0;
+    }
+
+    /* Fill in device information */
+    int64_t uptime_ticks = k_uptime_ticks();
+    device_info.timestamp_ms = (uint32_t)k_ticks_to_ms_floor64(uptime_ticks);
+    device_info.timestamp_us = k_ticks_to_us_floor64(uptime_ticks);
+    device_info.rssi_dbm = rx_frame.rssi;
+    device_info.fpp_index = rx_frame.fpp_index;
+    device_info.fpp_level = rx_frame.fpp_level;
+    device_info.frame_quality = rx_frame.frame_quality;
+    device_info.channel = applied_radio.channel;
+    device_info.prf = applied_radio.prf == DW3000_PRF_64M ? 64 : 16;
+    device_info.seq_num = rx_frame.buffer[2];
+    device_info.rx_timestamp = rx_frame.timestamp;
+    device_info.rx_time_valid = timebase_dw_to_ns(
+        rx_frame.timestamp, &device_info.rx_time_ns);
+    device_info.sync_valid = clock_sync_map(
+        rx_frame.timestamp, &device_info.sync_timestamp);
+
+    /* Calculate distance */
+    device_info.distance_cm = frame_parse_distance_cm(rx_frame.rssi);
+
+    LATENCY_TRACE_MARK(&device_info.trace, LATENCY_MARK_PARSE);
+    UWB_TRACE("parse", (uint32_t)device_info.device_addr, device_info.seq_num);
+    LATENCY_TRACE_AIR(&device_info.trace, device_info.rx_time_valid,
+                      device_info.rx_time_ns);
+
+    LOG_INF("Device detected: addr=0x%016llX, RSSI=%.2f dBm, dist=%.2f cm",
+           device_info.device_addr, device_info.rssi_dbm,
+           device_info.distance_cm);
+
+    /* Call callback if registered */
+    if (device_callback != NULL) {
+        UWB_TRACE("cb_enter", (uint32_t)device_info.device_addr, device_info.seq_num);
+        device_callback(&device_info);
+        UWB_TRACE("cb_exit", (uint32_t)device_info.device_addr, device_info.seq_num);
+    }
+
+    metric_inc(&scanner_sightings);
+    metric_observe(&scanner_report_us,
+                   k_cyc_to_us_floor32(k_cycle_get_32() - read_cyc));
+    return 0;
 }
 
 /* Scanner thread function */
@@ -121,77 +399,90 @@ static void scanner_thread_fn(void *arg1, void *arg2, void *arg3)
 
     LOG_INF("Scanner thread started");
 
-    dw3000_rx_frame_t rx_frame;
-    uwb_device_info_t device_info;
+    /* The radio is awake from here until the first sleep */
+    k_spinlock_key_t key = k_spin_lock(&power_lock);
+    awake_since_cyc = k_cycle_get_64();
+    k_spin_unlock(&power_lock, key);
+
+    /* Restarted by main() after the chip was lost: bring it back first */
+    recovery_attempts = 0;
+    failed_cycles = 0;
+    if (chip_lost) {
+        scanner_recover();
+    }
 
     while (scanner_active) {
-        /* Enable receiver */
-        int ret = dw3000_rx_enable(100); /* 100ms timeout */
-        if (ret < 0) {
-            LOG_ERR("Failed to enable RX: %d", ret);
-            k_sleep(K_MSEC(100));
-            continue;
+        uint32_t cycle_start_ms = k_uptime_get_32();
+
+        /*
+         * Safe point: the snapshot is pinned for the whole cycle, so a
+         * configuration published meanwhile takes effect next cycle.
+         */
+        const scanner_config_t *config = scanner_config_acquire();
+        scan_apply_config(config);
+
+        /* Refresh the DW3000 to uptime correlation */
+        timebase_poll();
+
+        /* Transmit a sync beacon between RX windows when acting as reference */
+        clock_sync_poll_beacon();
+
+        int ret = scan_cycle(config);
+
+        /* Never hold the snapshot across a sleep, writers wait for it */
+        uint32_t sleep_ms = config->sleep_ms;
+        uint8_t profile = config->power_profile;
+        scanner_config_release(config);
+
+        scanner_check_health(ret);
+        if (!scanner_active) {
+            break;
         }
 
-        /* Wait for frame or timeout */
-        k_sleep(K_MSEC(50));
-
-        /* Check if frame is ready */
-        if (dw3000_is_frame_ready()) {
-            /* Read the frame */
-            ret = dw3000_read_frame(&rx_frame);
-            if (ret < 0) {
-                LOG_ERR("Failed to read frame: %d", ret);
-                continue;
-            }
-
-            LOG_DBG("Frame received: length=%d, RSSI=%.2f dBm",
-                   rx_frame.length, rx_frame.rssi);
-
-            /* Parse frame to extract device information */
-            if (rx_frame.length >= 3) {
-                uint16_t fcf = rx_frame.buffer[0] | (rx_frame.buffer[1] << 8);
-                ieee154_fcf_t fcf_parsed;
-                parse_frame_control(fcf, &fcf_parsed);
-
-                /* Extract device address */
-                device_info.device_addr = extract_device_address(
-                    rx_frame.buffer, rx_frame.length, &fcf_parsed);
-
-                /* Only report valid addresses */
-                if (device_info.device_addr != 0) {
-                    /* Fill in device information */
-                    device_info.timestamp_ms = k_uptime_get_32();
-                    device_info.rssi_dbm = rx_frame.rssi;
-                    device_info.fpp_index = rx_frame.fpp_index;
-                    device_info.fpp_level = rx_frame.fpp_level;
-                    device_info.frame_quality = rx_frame.frame_quality;
-                    device_info.channel = 5; /* From configuration */
-                    device_info.prf = 64;    /* From configuration */
-
-                    /* Calculate distance */
-                    device_info.distance_cm = calculate_distance(
-                        rx_frame.fpp_index, rx_frame.fpp_level, rx_frame.rssi);
-
-                    LOG_INF("Device detected: addr=0x%016llX, RSSI=%.2f dBm, dist=%.2f cm",
-                           device_info.device_addr, device_info.rssi_dbm,
-                           device_info.distance_cm);
-
-                    /* Call callback if registered */
-                    if (device_callback != NULL) {
-                        device_callback(&device_info);
-                    }
-                }
-            }
+        /* Sync needs a continuously running device clock, so no sleep then */
+        if (sleep_ms > 0 && clock_sync_get_role() == CLOCK_SYNC_ROLE_NONE) {
+            scan_sleep(sleep_ms);
+        } else {
+            /* Small delay between scans */
+            k_sleep(K_MSEC(10));
         }
 
-        /* Small delay between scans */
-        k_sleep(K_MSEC(10));
+        current_profile = profile;
+        metric_add(profile_ms[profile], k_uptime_get_32() - cycle_start_ms);
     }
 
+    key = k_spin_lock(&power_lock);
+    awake_cyc += k_cycle_get_64() - awake_since_cyc;
+    awake_since_cyc = 0;
+    k_spin_unlock(&power_lock, key);
+
     LOG_INF("Scanner thread stopped");
 }
 
+/* Bring the radio up, at the stored SPI clock when there is one */
+static int scanner_bring_up(void)
+{
+#ifdef CONFIG_UWB_SETTINGS
+    uint32_t spi_hz = scanner_settings_get_spi_hz();
+
+    if (spi_hz != 0 && dw3000_init_warm(spi_hz) == 0) {
+        warm_boot = true;
+        return 0;
+    }
+#endif
+
+    int ret = dw3000_init();
+    if (ret < 0) {
+        return ret;
+    }
+
+#ifdef CONFIG_UWB_SETTINGS
+    scanner_settings_save_spi_hz(dw3000_get_spi_frequency());
+#endif
+
+    return 0;
+}
+
 int uwb_scanner_init(uwb_device_callback_t callback)
 {
     LOG_INF("Initializing UWB scanner");
@@ -200,23 +491,36 @@ int uwb_scanner_init(uwb_device_callback_t callback)
     device_callback = callback;
 
     /* Initialize DW3000 */
-    int ret = dw3000_init();
+    int ret = scanner_bring_up();
     if (ret < 0) {
         LOG_ERR("Failed to initialize DW3000: %d", ret);
         return ret;
     }
 
-    /* Configure DW3000 for scanning */
-    dw3000_config_t config = {
-        .channel = DW3000_CHANNEL_5,
-        .prf = DW3000_PRF_64M,
-        .preamble_length = DW3000_PLEN_128,
-        .pac_size = 8,
-        .tx_preamble_code = 9,
-        .rx_preamble_code = 9,
-    };
+    /* Start correlating device time with uptime */
+    ret = timebase_init();
+    if (ret < 0) {
+        LOG_WRN("Failed to sample DW3000 time: %d", ret);
+    }
+
+    /* Set up inter-scanner clock synchronisation */
+#if defined(CONFIG_UWB_SYNC_ROLE_REFERENCE)
+    clock_sync_init(CLOCK_SYNC_ROLE_REFERENCE);
+#elif defined(CONFIG_UWB_SYNC_ROLE_LISTENER)
+    clock_sync_init(CLOCK_SYNC_ROLE_LISTENER);
+#else
+    clock_sync_init(CLOCK_SYNC_ROLE_NONE);
+#endif
+
+    /* Configure DW3000 for scanning with the configuration main() loaded */
+    const scanner_config_t *config = scanner_config_acquire();
+    ret = dw3000_configure(&config->radio);
+    if (ret == 0) {
+        applied_radio = config->radio;
+        applied_version = config->version;
+    }
+    scanner_config_release(config);
 
-    ret = dw3000_configure(&config);
     if (ret < 0) {
         LOG_ERR("Failed to configure DW3000: %d", ret);
         return ret;
@@ -256,7 +560,8 @@ int uwb_scanner_stop(void)
     LOG_INF("Stopping UWB scanner");
     scanner_active = false;
 
-    /* Wait for thread to finish */
+    /* Cut the current RX wait short, then wait for thread to finish */
+    k_wakeup(&scanner_thread);
     k_thread_join(&scanner_thread, K_SECONDS(5));
 
     return 0;
@@ -266,3 +571,40 @@ bool uwb_scanner_is_active(void)
 {
     return scanner_active;
 }
+
+bool uwb_scanner_is_warm_boot(void)
+{
+    return warm_boot;
+}
+
+uint32_t uwb_scanner_get_first_frame_us(void)
+{
+    return first_frame_us;
+}
+
+void uwb_scanner_get_power_stats(uwb_scanner_power_stats_t *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&power_lock);
+    uint64_t awake = awake_cyc;
+    uint64_t asleep = asleep_cyc;
+
+    /* Count the awake period still running, or sleep_ms 0 never shows up */
+    if (awake_since_cyc != 0) {
+        awake += k_cycle_get_64() - awake_since_cyc;
+    }
+    k_spin_unlock(&power_lock, key);
+
+    uint64_t total = awake + asleep;
+
+    stats->sleeps = metric_get(&scanner_sleeps);
+    stats->wake_us_last = metric_get(&scanner_wake_us_last);
+    stats->wake_us_max = metric_get(&scanner_wake_us_max);
+    stats->duty_permille = total > 0 ? (uint16_t)(awake * 1000 / total) : 1000;
+    stats->rx_duty_permille = (uint16_t)((uint32_t)stats->duty_permille *
+                                         dw3000_sniff_duty_permille(&applied_radio) / 1000);
+    stats->profile = current_profile;
+    for (int i = 0; i < SCANNER_POWER_COUNT; i++) {
+        stats->profile_frames[i] = metric_get(profile_frames[i]);
+        stats->profile_ms[i] = metric_get(profile_ms[i]);
+    }
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Aggregator replay test
+Replays the recorded streams in tools/testdata through ptys
+(scripts/pty_replay.py) into uwb_aggregator and checks the unified
+stream: every record arrives once, tagged with its port and a host time
+that never runs backwards per port, the device table covers all
+sightings, and each port gets port_stats records with its lag.
+
+Usage: aggregator_replay_test.py <uwb_aggregator> [capture ...]
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PTY_REPLAY = os.path.join(HERE, '..', 'scripts', 'pty_replay.py')
+CAPTURES = [os.path.join(HERE, 'testdata', name)
+            for name in ('scanner_a.jsonl', 'scanner_b.jsonl')]
+SPEED = 1
+TIMEOUT_S = 60
+
+
+def load_records(path):
+    """JSON records of a capture, in order"""
+    records = []
+    with open(path) as f:
+        for line in f:
+            start = line.find('{')
+            if start != -1:
+                records.append(json.loads(line[start:]))
+    return records
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip(), file=sys.stderr)
+        return 2
+
+    aggregator = sys.argv[1]
+    captures = sys.argv[2:] or CAPTURES
+    failures = []
+
+    def check(cond, what):
+        if not cond:
+            failures.append(what)
+
+    replay = subprocess.Popen([sys.executable, PTY_REPLAY, '-s', str(SPEED), '-w', '1.5']
+                              + captures,
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    ptys = [replay.stdout.readline().strip() for _ in captures]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out_path = os.path.join(tmp, 'unified.jsonl')
+        agg = subprocess.run([aggregator, '-s', '0', '-i', '1', '-j', '-o', out_path] + ptys,
+                             capture_output=True, text=True, timeout=TIMEOUT_S)
+        replay.wait(timeout=TIMEOUT_S)
+
+        check(agg.returncode == 0, f'aggregator exit status {agg.returncode}')
+        with open(out_path) as f:
+            unified = [json.loads(line) for line in f if line.strip()]
+
+    stats = [r for r in unified if r.get('type') == 'port_stats']
+    summary = [r for r in unified if r.get('type') == 'device_summary']
+    records = [r for r in unified if r.get('type') not in ('port_stats', 'device_summary')]
+
+    sightings = {}
+    for port, path in enumerate(captures):
+        expected = load_records(path)
+        got = [r for r in records if r.get('port') == port]
+
+        check(len(got) == len(expected),
+              f'port {port}: {len(got)} records, expected {len(expected)}')
+        check([r.get('type') for r in got] == [r.get('type') for r in expected] and
+              [r.get('timestamp_ms') for r in got] == [r.get('timestamp_ms') for r in expected],
+              f'port {port}: records out of order or altered')
+
+        host = [r['host_us'] for r in got if 'timestamp_ms' in r]
+        check(all(b >= a for a, b in zip(host, host[1:])),
+              f'port {port}: host_us runs backwards')
+
+        port_stats = [r for r in stats if r['port'] == port]
+        check(len(port_stats) > 0, f'port {port}: no port_stats records')
+        check(sum(r['records'] for r in port_stats) == len(expected),
+              f'port {port}: port_stats count {sum(r["records"] for r in port_stats)}')
+        check(all(r['lag_max_ms'] >= r['lag_avg_ms'] >= 0 for r in port_stats),
+              f'port {port}: inconsistent lag')
+
+        for r in expected:
+            if r.get('type') == 'device_found':
+                addr = int(r['device_addr'], 16)
+                sightings[addr] = sightings.get(addr, 0) + 1
+
+    table = {int(r['device_addr'], 16): r['count'] for r in summary}
+    check(table == sightings, f'device table {table}, expected {sightings}')
+
+    for what in failures:
+        print(f'FAIL: {what}', file=sys.stderr)
+    if failures:
+        print(agg.stderr, file=sys.stderr)
+        return 1
+
+    print(f'{len(records)} records from {len(captures)} ports merged, '
+          f'{len(table)} devices, {len(stats)} port_stats records')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,315 @@
+/**
+ * @file frame_bench.c
+ * @brief Host microbenchmark of the scanner's per-frame parsing cost
+ *
+ * Runs the frame path of the scanner cycle (frame control parse, source
+ * address extraction, distance estimate) over pools of synthetic
+ * IEEE 802.15.4 frames and reports the cost per frame for each frame mix.
+ * The parsing code is src/frame_parse.c, built unchanged for the host.
+ *
+ * Each mix is timed in several repetitions of a number of passes over the
+ * pool; the best and median repetition are reported.
+ *
+ * Usage:
+ *   frame_bench [-n passes] [-r reps] [-m mix] [-j]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "frame_parse.h"
+
+#define POOL_SIZE       1024
+#define MAX_FRAME       127
+#define DEFAULT_PASSES  2000
+#define DEFAULT_REPS    5
+#define MAX_REPS        101
+
+typedef struct {
+    uint8_t buf[MAX_FRAME];
+    uint16_t length;
+    float rssi;
+} frame_t;
+
+/* Frame shapes seen on air */
+typedef enum {
+    KIND_SHORT,     /* Data, short source and destination, PAN ID compressed */
+    KIND_EXTENDED,  /* Data, extended source, short destination, PAN ID compressed */
+    KIND_BEACON,    /* Beacon, short source, no destination */
+    KIND_BLINK,     /* Data, extended source with PAN ID, no destination */
+    KIND_TRUNCATED, /* Extended source cut off by the frame length */
+    KIND_COUNT,
+} frame_kind_t;
+
+/* Share of each kind in a mix (percent) */
+typedef struct {
+    const char *name;
+    uint8_t weight[KIND_COUNT];
+} frame_mix_t;
+
+static const frame_mix_t mixes[] = {
+    {"short",     {[KIND_SHORT] = 100}},
+    {"extended",  {[KIND_EXTENDED] = 100}},
+    {"beacon",    {[KIND_BEACON] = 100}},
+    {"blink",     {[KIND_BLINK] = 100}},
+    {"truncated", {[KIND_TRUNCATED] = 100}},
+    {"mixed",     {[KIND_SHORT] = 40, [KIND_EXTENDED] = 30, [KIND_BEACON] = 10,
+                   [KIND_BLINK] = 10, [KIND_TRUNCATED] = 10}},
+};
+
+#define MIX_COUNT (sizeof(mixes) / sizeof(mixes[0]))
+
+static frame_t pool[POOL_SIZE];
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+/* Keeps the results alive */
+static volatile double sink;
+
+static uint64_t rng_next(void)
+{
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int put_addr(uint8_t *p, uint8_t mode)
+{
+    int len = mode == IEEE154_ADDR_EXTENDED ? 8 : mode == IEEE154_ADDR_SHORT ? 2 : 0;
+    uint64_t addr = rng_next() | 1;     /* Never 0, which means "no address" */
+
+    for (int i = 0; i < len; i++) {
+        p[i] = (uint8_t)(addr >> (i * 8));
+    }
+
+    return len;
+}
+
+static void build_frame(frame_t *f, frame_kind_t kind)
+{
+    uint8_t type = IEEE154_FRAME_TYPE_DATA;
+    uint8_t dst = IEEE154_ADDR_SHORT;
+    uint8_t src = IEEE154_ADDR_SHORT;
+    bool compress = true;
+    int payload = 10;
+
+    switch (kind) {
+    case KIND_SHORT:
+        break;
+    case KIND_EXTENDED:
+    case KIND_TRUNCATED:
+        src = IEEE154_ADDR_EXTENDED;
+        break;
+    case KIND_BEACON:
+        type = IEEE154_FRAME_TYPE_BEACON;
+        dst = IEEE154_ADDR_NONE;
+        compress = false;
+        payload = 4;
+        break;
+    case KIND_BLINK:
+        dst = IEEE154_ADDR_NONE;
+        src = IEEE154_ADDR_EXTENDED;
+        compress = false;
+        payload = 2;
+        break;
+    default:
+        break;
+    }
+
+    uint16_t fcf = type | (compress ? 0x40 : 0) | (dst << 10) | (src << 14);
+    uint8_t *p = f->buf;
+
+    memset(f->buf, 0, sizeof(f->buf));
+    *p++ = (uint8_t)fcf;
+    *p++ = (uint8_t)(fcf >> 8);
+    *p++ = (uint8_t)rng_next();         /* Sequence number */
+    if (dst != IEEE154_ADDR_NONE) {
+        p += put_addr(p, IEEE154_ADDR_SHORT);    /* Destination PAN ID */
+        p += put_addr(p, dst);
+    }
+    if (src != IEEE154_ADDR_NONE && !compress) {
+        p += put_addr(p, IEEE154_ADDR_SHORT);    /* Source PAN ID */
+    }
+    p += put_addr(p, src);
+    p += payload;
+    p += 2;                             /* FCS */
+
+    f->length = (uint16_t)(p - f->buf);
+    if (kind == KIND_TRUNCATED) {
+        f->length = 9;
+    }
+    f->rssi = -60.0f - (float)(rng_next() % 40);
+}
+
+/* Fill the pool in proportion to the mix, then shuffle it */
+static void build_pool(const frame_mix_t *mix)
+{
+    int n = 0;
+
+    for (int k = 0; k < KIND_COUNT; k++) {
+        int count = POOL_SIZE * mix->weight[k] / 100;
+        for (int i = 0; i < count && n < POOL_SIZE; i++) {
+            build_frame(&pool[n++], (frame_kind_t)k);
+        }
+    }
+    while (n < POOL_SIZE) {
+        build_frame(&pool[n], (frame_kind_t)(n % KIND_COUNT));
+        n++;
+    }
+
+    for (int i = POOL_SIZE - 1; i > 0; i--) {
+        int j = (int)(rng_next() % (uint64_t)(i + 1));
+        frame_t tmp = pool[i];
+        pool[i] = pool[j];
+        pool[j] = tmp;
+    }
+}
+
+/* The parse steps of scan_cycle(); returns the number of sightings */
+static uint32_t run_pass(double *acc)
+{
+    uint32_t sightings = 0;
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        const frame_t *f = &pool[i];
+        ieee154_fcf_t fcf;
+
+        if (f->length < 3) {
+            continue;
+        }
+
+        frame_parse_fcf(f->buf[0] | (f->buf[1] << 8), &fcf);
+        uint64_t addr = frame_parse_source_address(f->buf, f->length, &fcf);
+        if (addr == 0) {
+            continue;
+        }
+
+        *acc += frame_parse_distance_cm(f->rssi) + (double)(addr & 0xFF);
+        sightings++;
+    }
+
+    return sightings;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n passes] [-r reps] [-m mix] [-j]\n"
+            "  -n passes   Passes over the %d-frame pool per repetition (default: %d)\n"
+            "  -r reps     Timed repetitions per mix (default: %d)\n"
+            "  -m mix      Run one mix only:",
+            prog, POOL_SIZE, DEFAULT_PASSES, DEFAULT_REPS);
+    for (size_t m = 0; m < MIX_COUNT; m++) {
+        fprintf(stderr, " %s", mixes[m].name);
+    }
+    fprintf(stderr,
+            "\n"
+            "  -j          Write results as JSON lines\n");
+}
+
+int main(int argc, char **argv)
+{
+    int passes = DEFAULT_PASSES;
+    int reps = DEFAULT_REPS;
+    const char *only = NULL;
+    bool json = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:m:jh")) != -1) {
+        switch (opt) {
+        case 'n':
+            passes = atoi(optarg);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        case 'm':
+            only = optarg;
+            break;
+        case 'j':
+            json = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (passes < 1 || reps < 1 || reps > MAX_REPS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!json) {
+        printf("%-10s %12s %10s %10s %10s\n",
+               "mix", "frames/rep", "best ns", "median ns", "sightings");
+    }
+
+    bool found = false;
+    for (size_t m = 0; m < MIX_COUNT; m++) {
+        const frame_mix_t *mix = &mixes[m];
+        uint64_t elapsed[MAX_REPS];
+        uint32_t sightings = 0;
+        double acc = 0.0;
+
+        if (only != NULL && strcmp(only, mix->name) != 0) {
+            continue;
+        }
+        found = true;
+
+        build_pool(mix);
+        run_pass(&acc);     /* Warm up caches and branch predictors */
+
+        for (int r = 0; r < reps; r++) {
+            uint64_t start = now_ns();
+            for (int p = 0; p < passes; p++) {
+                sightings = run_pass(&acc);
+            }
+            elapsed[r] = now_ns() - start;
+        }
+        sink = acc;
+
+        qsort(elapsed, reps, sizeof(elapsed[0]), cmp_u64);
+        uint64_t frames = (uint64_t)passes * POOL_SIZE;
+        double best = (double)elapsed[0] / frames;
+        double median = (double)elapsed[reps / 2] / frames;
+
+        if (json) {
+            printf("{\"type\":\"frame_bench\",\"mix\":\"%s\",\"frames\":%llu,"
+                   "\"ns_best\":%.2f,\"ns_median\":%.2f,\"sightings\":%u}\n",
+                   mix->name, (unsigned long long)frames, best, median, sightings);
+        } else {
+            printf("%-10s %12llu %10.2f %10.2f %10u\n",
+                   mix->name, (unsigned long long)frames, best, median, sightings);
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "Unknown mix: %s\n", only);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file jsonl.h
+ * @brief Minimal field lookup for the scanner's flat JSON-line records
+ */
+
+#ifndef JSONL_H
+#define JSONL_H
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Find "key": in a flat JSON line
+ *
+ * @param line JSON text (need not be NUL-terminated after the match)
+ * @param key Field name without quotes
+ * @return Pointer to the first character of the value, or NULL
+ */
+static inline const char *jsonl_find(const char *line, const char *key)
+{
+    char pattern[32];
+    int len = snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+    const char *p = strstr(line, pattern);
+    if (p == NULL) {
+        return NULL;
+    }
+    p += len;
+    while (*p == ' ') {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Check the record type of a JSON line
+ *
+ * @param line JSON text
+ * @param type Expected value of the "type" field
+ * @return Non-zero if the record has that type
+ */
+static inline int jsonl_is_type(const char *line, const char *type)
+{
+    const char *p = jsonl_find(line, "type");
+    size_t len = strlen(type);
+
+    return p != NULL && *p == '"' && strncmp(p + 1, type, len) == 0 && p[len + 1] == '"';
+}
+
+#endif /* JSONL_H */
@@ -0,0 +1,673 @@
+/**
+ * @file tdoa_solver.c
+ * @brief Host-side TDoA multilateration from synchronized scanner captures
+ *
+ * Reads one JSON-lines capture per scanner (as written by monitor.py
+ * --output), groups arrivals of the same transmission by (source address,
+ * sequence number) within a time window, and solves each group for the
+ * transmitter position. Solving uses a linearized closed-form estimate
+ * (Chan) as the starting point for Gauss-Newton refinement. Groups are
+ * solved in batches with the receiver geometry laid out as flat arrays.
+ *
+ * Usage:
+ *   tdoa_solver [-2] [-r ref_id] [-w window_ns] [-b batch] [-o out.jsonl]
+ *               id:x,y,z:capture.jsonl [id:x,y,z:capture.jsonl ...]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "jsonl.h"
+
+/* Physical constants */
+#define SPEED_OF_LIGHT      299792458.0
+#define DW3000_TICKS_PER_S  63897600000.0
+#define METERS_PER_TICK     (SPEED_OF_LIGHT / DW3000_TICKS_PER_S)
+
+/* Limits */
+#define MAX_SCANNERS        32
+#define MAX_LINE            1024
+#define GROUP_TABLE_SIZE    4096    /* Max concurrently open groups */
+#define DEFAULT_WINDOW_NS   2000
+#define DEFAULT_BATCH       256
+
+/* Gauss-Newton parameters */
+#define GN_MAX_ITER         10
+#define GN_STEP_EPS         1e-4    /* Converged when step below 0.1 mm */
+#define GN_DAMPING          1e-9
+
+typedef struct {
+    int id;
+    double pos[3];
+    double offset_ticks;    /* Propagation delay from sync reference */
+    const char *path;
+} scanner_t;
+
+typedef struct {
+    uint64_t addr;
+    uint64_t ts;            /* Shared timebase, DW3000 ticks */
+    uint8_t seq;
+    uint8_t scanner;        /* Index into scanners[] */
+} arrival_t;
+
+typedef struct {
+    uint64_t addr;
+    uint8_t seq;
+    uint64_t first_ts;
+    uint32_t mask;          /* Scanners that contributed */
+    uint64_t ts[MAX_SCANNERS];
+} group_t;
+
+/* One batch of groups ready to solve, receiver data stored per group */
+typedef struct {
+    int count;
+    int n[DEFAULT_BATCH];                       /* Receivers per group */
+    uint64_t addr[DEFAULT_BATCH];
+    uint8_t seq[DEFAULT_BATCH];
+    double t0[DEFAULT_BATCH];                   /* Seconds, first arrival */
+    double rx[DEFAULT_BATCH][MAX_SCANNERS][3];  /* Receiver positions */
+    double d[DEFAULT_BATCH][MAX_SCANNERS];      /* Range differences (m) */
+} batch_t;
+
+static scanner_t scanners[MAX_SCANNERS];
+static int scanner_count;
+static int dims = 3;
+static int batch_limit = DEFAULT_BATCH;
+static FILE *out_file;
+
+static group_t groups[GROUP_TABLE_SIZE];
+static batch_t batch;
+
+/* Statistics */
+static uint64_t stat_arrivals;
+static uint64_t stat_groups;
+static uint64_t stat_underdetermined;
+static uint64_t stat_fixes;
+static uint64_t stat_diverged;
+static double stat_solve_s;
+static double *residuals;
+static size_t residual_cap;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Parse one device_found record; returns false for anything else */
+static bool parse_arrival(const char *line, arrival_t *a)
+{
+    const char *p = strchr(line, '{');
+    if (p == NULL || !jsonl_is_type(p, "device_found")) {
+        return false;
+    }
+
+    const char *addr = jsonl_find(p, "device_addr");
+    const char *seq = jsonl_find(p, "seq");
+    const char *ts = jsonl_find(p, "sync_ts");
+    if (addr == NULL || seq == NULL || ts == NULL || *addr != '"') {
+        return false;
+    }
+
+    a->addr = strtoull(addr + 1, NULL, 16);
+    a->seq = (uint8_t)strtoul(seq, NULL, 10);
+    a->ts = strtoull(ts, NULL, 10);
+    return true;
+}
+
+static int compare_arrival(const void *lhs, const void *rhs)
+{
+    const arrival_t *a = lhs;
+    const arrival_t *b = rhs;
+
+    return (a->ts > b->ts) - (a->ts < b->ts);
+}
+
+static arrival_t *load_captures(size_t *count)
+{
+    size_t cap = 1 << 16;
+    size_t n = 0;
+    arrival_t *arr = malloc(cap * sizeof(*arr));
+    char line[MAX_LINE];
+
+    if (arr == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < scanner_count; i++) {
+        FILE *f = fopen(scanners[i].path, "r");
+        if (f == NULL) {
+            perror(scanners[i].path);
+            free(arr);
+            return NULL;
+        }
+
+        while (fgets(line, sizeof(line), f) != NULL) {
+            arrival_t a;
+            if (!parse_arrival(line, &a)) {
+                continue;
+            }
+            if (n == cap) {
+                cap *= 2;
+                arrival_t *grown = realloc(arr, cap * sizeof(*arr));
+                if (grown == NULL) {
+                    fclose(f);
+                    free(arr);
+                    return NULL;
+                }
+                arr = grown;
+            }
+            a.scanner = (uint8_t)i;
+            /* Undo the propagation delay baked in by the sync fit */
+            a.ts += (uint64_t)llround(scanners[i].offset_ticks);
+            arr[n++] = a;
+        }
+        fclose(f);
+    }
+
+    qsort(arr, n, sizeof(*arr), compare_arrival);
+    *count = n;
+    return arr;
+}
+
+/* Solve a small symmetric positive definite system in place */
+static bool solve_spd(int n, double a[3][3], double b[3], double x[3])
+{
+    double l[3][3] = {{0}};
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = a[i][j];
+            for (int k = 0; k < j; k++) {
+                sum -= l[i][k] * l[j][k];
+            }
+            if (i == j) {
+                if (sum <= 0.0) {
+                    return false;
+                }
+                l[i][i] = sqrt(sum);
+            } else {
+                l[i][j] = sum / l[j][j];
+            }
+        }
+    }
+
+    double y[3];
+    for (int i = 0; i < n; i++) {
+        double sum = b[i];
+        for (int k = 0; k < i; k++) {
+            sum -= l[i][k] * y[k];
+        }
+        y[i] = sum / l[i][i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = y[i];
+        for (int k = i + 1; k < n; k++) {
+            sum -= l[k][i] * x[k];
+        }
+        x[i] = sum / l[i][i];
+    }
+
+    return true;
+}
+
+/*
+ * Chan-style linearized estimate. With r_i = r_0 + d_i:
+ *   2 (s_i - s_0) . p + 2 d_i r_0 = |s_i|^2 - |s_0|^2 - d_i^2
+ * which is linear in (p, r_0). Needs dims + 2 receivers; otherwise the
+ * receiver centroid is used as the starting point.
+ */
+static void initial_estimate(int n, double rx[][3], const double *d, double p[3])
+{
+    p[0] = p[1] = p[2] = 0.0;
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            p[k] += rx[i][k] / n;
+        }
+    }
+
+    int unknowns = dims + 1;
+    if (n - 1 < unknowns || unknowns > 4) {
+        return;
+    }
+
+    double ata[4][4] = {{0}};
+    double atb[4] = {0};
+    double s0sq = rx[0][0] * rx[0][0] + rx[0][1] * rx[0][1] + rx[0][2] * rx[0][2];
+
+    for (int i = 1; i < n; i++) {
+        double row[4];
+        double sisq = rx[i][0] * rx[i][0] + rx[i][1] * rx[i][1] + rx[i][2] * rx[i][2];
+        for (int k = 0; k < dims; k++) {
+            row[k] = 2.0 * (rx[i][k] - rx[0][k]);
+        }
+        row[dims] = 2.0 * d[i];
+        double rhs = sisq - s0sq - d[i] * d[i];
+        if (dims == 2) {
+            /* Transmitter assumed at the receivers' mean height */
+            rhs -= 2.0 * (rx[i][2] - rx[0][2]) * p[2];
+        }
+        for (int r = 0; r < unknowns; r++) {
+            for (int c = 0; c < unknowns; c++) {
+                ata[r][c] += row[r] * row[c];
+            }
+            atb[r] += row[r] * rhs;
+        }
+    }
+
+    /* Gaussian elimination with partial pivoting on the normal equations */
+    for (int c = 0; c < unknowns; c++) {
+        int piv = c;
+        for (int r = c + 1; r < unknowns; r++) {
+            if (fabs(ata[r][c]) > fabs(ata[piv][c])) {
+                piv = r;
+            }
+        }
+        if (fabs(ata[piv][c]) < 1e-12) {
+            return;
+        }
+        for (int k = 0; k < unknowns; k++) {
+            double tmp = ata[c][k];
+            ata[c][k] = ata[piv][k];
+            ata[piv][k] = tmp;
+        }
+        double tmp = atb[c];
+        atb[c] = atb[piv];
+        atb[piv] = tmp;
+
+        for (int r = c + 1; r < unknowns; r++) {
+            double f = ata[r][c] / ata[c][c];
+            for (int k = c; k < unknowns; k++) {
+                ata[r][k] -= f * ata[c][k];
+            }
+            atb[r] -= f * atb[c];
+        }
+    }
+
+    double sol[4];
+    for (int r = unknowns - 1; r >= 0; r--) {
+        double sum = atb[r];
+        for (int k = r + 1; k < unknowns; k++) {
+            sum -= ata[r][k] * sol[k];
+        }
+        sol[r] = sum / ata[r][r];
+    }
+
+    for (int k = 0; k < dims; k++) {
+        p[k] = sol[k];
+    }
+}
+
+/* Gauss-Newton refinement; returns RMS range-difference residual in meters */
+static double refine(int n, double rx[][3], const double *d, double p[3], bool *ok)
+{
+    double rms = 0.0;
+    *ok = false;
+
+    for (int iter = 0; iter < GN_MAX_ITER; iter++) {
+        double jtj[3][3] = {{0}};
+        double jtf[3] = {0};
+        double u0[3];
+        double r0 = 0.0;
+        double sse = 0.0;
+
+        for (int k = 0; k < 3; k++) {
+            u0[k] = p[k] - rx[0][k];
+            r0 += u0[k] * u0[k];
+        }
+        r0 = sqrt(r0) + 1e-12;
+
+        for (int i = 1; i < n; i++) {
+            double ui[3];
+            double ri = 0.0;
+            for (int k = 0; k < 3; k++) {
+                ui[k] = p[k] - rx[i][k];
+                ri += ui[k] * ui[k];
+            }
+            ri = sqrt(ri) + 1e-12;
+
+            double f = ri - r0 - d[i];
+            double j[3];
+            for (int k = 0; k < dims; k++) {
+                j[k] = ui[k] / ri - u0[k] / r0;
+            }
+            for (int r = 0; r < dims; r++) {
+                for (int c = 0; c < dims; c++) {
+                    jtj[r][c] += j[r] * j[c];
+                }
+                jtf[r] -= j[r] * f;
+            }
+            sse += f * f;
+        }
+        rms = sqrt(sse / (n - 1));
+
+        for (int k = 0; k < dims; k++) {
+            jtj[k][k] += GN_DAMPING;
+        }
+
+        double step[3] = {0};
+        if (!solve_spd(dims, jtj, jtf, step)) {
+            return rms;
+        }
+
+        double norm = 0.0;
+        for (int k = 0; k < dims; k++) {
+            p[k] += step[k];
+            norm += step[k] * step[k];
+        }
+        if (sqrt(norm) < GN_STEP_EPS) {
+            *ok = true;
+            break;
+        }
+    }
+
+    return rms;
+}
+
+static void record_residual(double rms)
+{
+    if (stat_fixes == residual_cap) {
+        size_t cap = residual_cap ? residual_cap * 2 : 4096;
+        double *grown = realloc(residuals, cap * sizeof(*residuals));
+        if (grown == NULL) {
+            perror("residuals");
+            exit(1);
+        }
+        residuals = grown;
+        residual_cap = cap;
+    }
+    residuals[stat_fixes] = rms;
+}
+
+static void solve_batch(void)
+{
+    double start = now_s();
+    double pos[DEFAULT_BATCH][3];
+    double rms[DEFAULT_BATCH];
+    bool ok[DEFAULT_BATCH];
+
+    for (int g = 0; g < batch.count; g++) {
+        initial_estimate(batch.n[g], batch.rx[g], batch.d[g], pos[g]);
+        rms[g] = refine(batch.n[g], batch.rx[g], batch.d[g], pos[g], &ok[g]);
+    }
+
+    stat_solve_s += now_s() - start;
+
+    for (int g = 0; g < batch.count; g++) {
+        if (!ok[g]) {
+            stat_diverged++;
+            continue;
+        }
+        record_residual(rms[g]);
+        stat_fixes++;
+
+        if (out_file != NULL) {
+            fprintf(out_file,
+                    "{\"type\":\"fix\",\"device_addr\":\"%016llX\",\"seq\":%u,"
+                    "\"t_s\":%.9f,\"x\":%.3f,\"y\":%.3f,\"z\":%.3f,"
+                    "\"receivers\":%d,\"rms_m\":%.4f}\n",
+                    (unsigned long long)batch.addr[g], batch.seq[g], batch.t0[g],
+                    pos[g][0], pos[g][1], pos[g][2], batch.n[g], rms[g]);
+        }
+    }
+
+    batch.count = 0;
+}
+
+static void close_group(group_t *grp)
+{
+    int n = 0;
+    int order[MAX_SCANNERS];
+
+    stat_groups++;
+
+    for (int i = 0; i < scanner_count; i++) {
+        if (grp->mask & (1u << i)) {
+            order[n++] = i;
+        }
+    }
+
+    if (n < dims + 1) {
+        stat_underdetermined++;
+        return;
+    }
+
+    int g = batch.count++;
+    uint64_t ref_ts = grp->ts[order[0]];
+
+    batch.n[g] = n;
+    batch.addr[g] = grp->addr;
+    batch.seq[g] = grp->seq;
+    batch.t0[g] = ref_ts / DW3000_TICKS_PER_S;
+    for (int i = 0; i < n; i++) {
+        const scanner_t *s = &scanners[order[i]];
+        for (int k = 0; k < 3; k++) {
+            batch.rx[g][i][k] = s->pos[k];
+        }
+        batch.d[g][i] = (double)(int64_t)(grp->ts[order[i]] - ref_ts) * METERS_PER_TICK;
+    }
+
+    if (batch.count >= batch_limit) {
+        solve_batch();
+    }
+}
+
+static void open_group(group_t *grp, const arrival_t *a)
+{
+    grp->addr = a->addr;
+    grp->seq = a->seq;
+    grp->first_ts = a->ts;
+    grp->mask = 1u << a->scanner;
+    grp->ts[a->scanner] = a->ts;
+}
+
+/*
+ * Arrivals are time-sorted, so open groups form a FIFO ordered by their
+ * first arrival. Only transmissions inside one window are open at once,
+ * which keeps the matching scan short.
+ */
+static void process_arrivals(const arrival_t *arr, size_t count, uint64_t window)
+{
+    size_t head = 0;
+    size_t tail = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const arrival_t *a = &arr[i];
+
+        /* Close groups whose window has passed */
+        while (head != tail &&
+               a->ts - groups[head % GROUP_TABLE_SIZE].first_ts > window) {
+            close_group(&groups[head++ % GROUP_TABLE_SIZE]);
+        }
+
+        bool matched = false;
+        for (size_t g = head; g != tail; g++) {
+            group_t *grp = &groups[g % GROUP_TABLE_SIZE];
+            if (grp->addr == a->addr && grp->seq == a->seq) {
+                /* Keep the earliest arrival per scanner */
+                if (!(grp->mask & (1u << a->scanner))) {
+                    grp->mask |= 1u << a->scanner;
+                    grp->ts[a->scanner] = a->ts;
+                }
+                matched = true;
+                break;
+            }
+        }
+        if (matched) {
+            continue;
+        }
+
+        if (tail - head == GROUP_TABLE_SIZE) {
+            close_group(&groups[head++ % GROUP_TABLE_SIZE]);
+        }
+        open_group(&groups[tail++ % GROUP_TABLE_SIZE], a);
+    }
+
+    while (head != tail) {
+        close_group(&groups[head++ % GROUP_TABLE_SIZE]);
+    }
+    if (batch.count > 0) {
+        solve_batch();
+    }
+}
+
+static int compare_double(const void *lhs, const void *rhs)
+{
+    double a = *(const double *)lhs;
+    double b = *(const double *)rhs;
+
+    return (a > b) - (a < b);
+}
+
+static bool parse_scanner(const char *arg, scanner_t *s)
+{
+    char *end;
+
+    s->id = (int)strtol(arg, &end, 10);
+    if (*end != ':') {
+        return false;
+    }
+    for (int k = 0; k < 3; k++) {
+        s->pos[k] = strtod(end + 1, &end);
+        if (*end != (k < 2 ? ',' : ':')) {
+            return false;
+        }
+    }
+    s->path = end + 1;
+    return *s->path != '\0';
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-2] [-r ref_id] [-w window_ns] [-b batch] [-o out.jsonl]\n"
+            "          id:x,y,z:capture.jsonl [id:x,y,z:capture.jsonl ...]\n"
+            "  -2          Solve in 2D (transmitter at receivers' mean height)\n"
+            "  -r ref_id   Scanner id of the sync reference (default: first)\n"
+            "  -w ns       Grouping window (default: %d ns)\n"
+            "  -b n        Groups per solver batch (default/max: %d)\n"
+            "  -o file     Write fixes as JSON lines ('-' for stdout)\n",
+            prog, DEFAULT_WINDOW_NS, DEFAULT_BATCH);
+}
+
+int main(int argc, char **argv)
+{
+    int ref_id = -1;
+    double window_ns = DEFAULT_WINDOW_NS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "2r:w:b:o:h")) != -1) {
+        switch (opt) {
+        case '2':
+            dims = 2;
+            break;
+        case 'r':
+            ref_id = atoi(optarg);
+            break;
+        case 'w':
+            window_ns = atof(optarg);
+            break;
+        case 'b':
+            batch_limit = atoi(optarg);
+            if (batch_limit < 1 || batch_limit > DEFAULT_BATCH) {
+                batch_limit = DEFAULT_BATCH;
+            }
+            break;
+        case 'o':
+            out_file = strcmp(optarg, "-") == 0 ? stdout : fopen(optarg, "w");
+            if (out_file == NULL) {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    for (int i = optind; i < argc; i++) {
+        if (scanner_count == MAX_SCANNERS) {
+            fprintf(stderr, "Too many scanners (max %d)\n", MAX_SCANNERS);
+            return 1;
+        }
+        if (!parse_scanner(argv[i], &scanners[scanner_count])) {
+            fprintf(stderr, "Invalid scanner spec: %s\n", argv[i]);
+            return 1;
+        }
+        scanner_count++;
+    }
+
+    if (scanner_count < dims + 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Sync timestamps run early by the reference-to-scanner flight time */
+    const scanner_t *ref = &scanners[0];
+    for (int i = 0; i < scanner_count; i++) {
+        if (scanners[i].id == ref_id) {
+            ref = &scanners[i];
+        }
+    }
+    for (int i = 0; i < scanner_count; i++) {
+        double dist = 0.0;
+        for (int k = 0; k < 3; k++) {
+            double delta = scanners[i].pos[k] - ref->pos[k];
+            dist += delta * delta;
+        }
+        scanners[i].offset_ticks = sqrt(dist) / METERS_PER_TICK;
+    }
+
+    double load_start = now_s();
+    size_t count = 0;
+    arrival_t *arr = load_captures(&count);
+    if (arr == NULL) {
+        return 1;
+    }
+    stat_arrivals = count;
+    double load_s = now_s() - load_start;
+
+    double group_start = now_s();
+    process_arrivals(arr, count, (uint64_t)(window_ns * 1e-9 * DW3000_TICKS_PER_S));
+    double total_s = now_s() - group_start;
+    free(arr);
+
+    fprintf(stderr, "Arrivals:        %llu (loaded in %.3f s)\n",
+            (unsigned long long)stat_arrivals, load_s);
+    fprintf(stderr, "Groups:          %llu (%llu with too few receivers)\n",
+            (unsigned long long)stat_groups, (unsigned long long)stat_underdetermined);
+    fprintf(stderr, "Fixes:           %llu (%llu not converged)\n",
+            (unsigned long long)stat_fixes, (unsigned long long)stat_diverged);
+    if (stat_solve_s > 0.0) {
+        fprintf(stderr, "Solver:          %.0f solves/s (%.3f s)\n",
+                (stat_fixes + stat_diverged) / stat_solve_s, stat_solve_s);
+    }
+    if (total_s > 0.0) {
+        fprintf(stderr, "End to end:      %.0f fixes/s incl. grouping\n",
+                stat_fixes / total_s);
+    }
+    if (stat_fixes > 0 && residuals != NULL) {
+        qsort(residuals, stat_fixes, sizeof(*residuals), compare_double);
+        fprintf(stderr, "Residual RMS:    p50=%.3f m p95=%.3f m max=%.3f m\n",
+                residuals[stat_fixes / 2],
+                residuals[(size_t)(stat_fixes * 0.95)],
+                residuals[stat_fixes - 1]);
+    }
+
+    free(residuals);
+    if (out_file != NULL && out_file != stdout) {
+        fclose(out_file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,658 @@
+/**
+ * @file uwb_aggregator.c
+ * @brief Multi-scanner aggregation daemon
+ *
+ * Opens any number of scanner serial ports (or ptys), reads them with
+ * epoll, and merges their records into one JSON-lines stream. Each output
+ * record is tagged with the source port and a host timestamp derived from
+ * the scanner's uptime, so records from different scanners can be ordered
+ * on one clock. Sightings are also merged into a global device table.
+ *
+ * Each port is periodically sent an NTP-style "sync <t1>" request and the
+ * scanner answers with its receive and transmit uptimes (t2, t3). Samples
+ * whose round-trip delay is close to the minimum seen feed an exponentially
+ * weighted offset/drift fit, which maps the records' 64-bit timestamp_us
+ * onto host time to within the link's jitter floor.
+ *
+ * Until that fit has locked, or for scanners without sync support, the
+ * coarse timestamp_ms is mapped by the lower envelope of (host time -
+ * scanner uptime): USB and buffering only ever delay a record, so the
+ * smallest observed offset is the closest to the true one. The envelope
+ * relaxes at a bounded drift rate so it can follow the scanner's crystal.
+ *
+ * The unified stream is flushed after every epoll batch, so it trails the
+ * ports by no more than one batch.
+ *
+ * Usage:
+ *   uwb_aggregator [-o out.jsonl] [-i report_s] [-s sync_ms] [-j] [-f] port [port ...]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/epoll.h>
+
+#include "jsonl.h"
+#include "linear_fit.h"
+
+/* Limits */
+#define MAX_PORTS           64
+#define PORT_BUFFER_SIZE    65536
+#define READ_CHUNK          16384
+#define MAX_EVENTS          MAX_PORTS
+#define DEVICE_TABLE_SIZE   8192    /* Power of two */
+
+/* Uptime mapping: allow the envelope to relax by 200 ppm */
+#define DRIFT_ALLOWANCE_PPM 200
+
+/* Host-device time sync */
+#define DEFAULT_SYNC_MS     1000
+#define SYNC_FORGET         0.9     /* Per-sample weight decay */
+#define SYNC_MIN_SAMPLES    4       /* Samples needed before locking */
+#define SYNC_DELAY_SLACK_US 500     /* Accept samples this close to min delay */
+#define SYNC_DELAY_RELAX_US 10      /* Min delay relaxation per sample */
+
+#define DEFAULT_REPORT_S    5
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* Offset (device - host) against host time, fitted like the firmware's clock sync */
+typedef struct {
+    linear_fit_t fit;
+    int64_t min_delay_us;
+    int64_t last_delay_us;
+    uint64_t rejected;
+} time_sync_t;
+
+typedef struct {
+    const char *path;
+    int fd;
+    bool open;
+
+    /* Line assembly */
+    char buf[PORT_BUFFER_SIZE];
+    size_t len;
+
+    /* Uptime-to-host mapping */
+    bool mapped;
+    int64_t offset_us;          /* host_us - uptime_us lower envelope */
+    int64_t offset_updated_us;
+    uint32_t last_uptime_ms;
+    uint64_t uptime_wraps;
+    time_sync_t sync;
+
+    /* Interval statistics */
+    uint64_t records;
+    uint64_t log_lines;
+    uint64_t bytes;
+    uint64_t lag_sum_us;
+    uint64_t lag_max_us;
+    uint64_t total_records;
+} port_t;
+
+typedef struct {
+    uint64_t addr;
+    bool used;
+    uint64_t first_host_us;
+    uint64_t last_host_us;
+    uint64_t count;
+    float best_rssi;
+    uint8_t best_port;
+    uint64_t port_mask;
+} device_entry_t;
+
+static port_t ports[MAX_PORTS];
+static int port_count;
+static device_entry_t devices[DEVICE_TABLE_SIZE];
+static size_t device_count;
+static FILE *out;
+static volatile sig_atomic_t running = 1;
+
+static int64_t host_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static int open_port(port_t *port)
+{
+    port->fd = open(port->path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (port->fd < 0) {
+        return -errno;
+    }
+
+    /* Raw mode; the baud rate is ignored by CDC ACM but set for UARTs */
+    if (isatty(port->fd)) {
+        struct termios tio;
+        if (tcgetattr(port->fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            cfsetispeed(&tio, B115200);
+            cfsetospeed(&tio, B115200);
+            tio.c_cc[VMIN] = 1;
+            tio.c_cc[VTIME] = 0;
+            tcsetattr(port->fd, TCSANOW, &tio);
+        }
+    }
+
+    port->open = true;
+    port->len = 0;
+    return 0;
+}
+
+static void sync_reset(time_sync_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    linear_fit_init(&s->fit, SYNC_FORGET);
+}
+
+static int64_t sync_offset(const time_sync_t *s, int64_t host)
+{
+    return linear_fit_eval(&s->fit, host);
+}
+
+/* Four-timestamp exchange: t1/t4 on the host, t2/t3 on the scanner */
+static void handle_sync_response(port_t *port, const char *json, int64_t t4)
+{
+    const char *f1 = jsonl_find(json, "t1");
+    const char *f2 = jsonl_find(json, "t2");
+    const char *f3 = jsonl_find(json, "t3");
+    time_sync_t *s = &port->sync;
+
+    if (f1 == NULL || f2 == NULL || f3 == NULL) {
+        return;
+    }
+
+    int64_t t1 = strtoll(f1, NULL, 10);
+    int64_t t2 = strtoll(f2, NULL, 10);
+    int64_t t3 = strtoll(f3, NULL, 10);
+    int64_t delay = (t4 - t1) - (t3 - t2);
+    int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+
+    s->last_delay_us = delay;
+    if (s->fit.count == 0 && s->rejected == 0) {
+        s->min_delay_us = delay;
+    } else {
+        s->min_delay_us += SYNC_DELAY_RELAX_US;
+        if (delay < s->min_delay_us) {
+            s->min_delay_us = delay;
+        }
+    }
+
+    /* Exchanges delayed by USB scheduling or buffering carry skewed offsets */
+    if (delay > s->min_delay_us + SYNC_DELAY_SLACK_US) {
+        s->rejected++;
+        return;
+    }
+
+    linear_fit_add(&s->fit, t1 + (t4 - t1) / 2, offset);
+}
+
+static void send_sync_request(port_t *port)
+{
+    char req[48];
+    int len = snprintf(req, sizeof(req), "sync %lld\n", (long long)host_us());
+
+    /* Best effort: a full output queue just skips this exchange */
+    if (write(port->fd, req, (size_t)len) < 0 && errno != EAGAIN) {
+        fprintf(stderr, "%s: sync request failed: %s\n", port->path, strerror(errno));
+    }
+}
+
+/* Map a scanner timestamp_ms onto host time, returns the mapped value */
+static int64_t map_uptime(port_t *port, uint32_t uptime_ms, int64_t now_us)
+{
+    /* timestamp_ms is 32-bit and wraps after ~49.7 days */
+    if (port->mapped && uptime_ms < port->last_uptime_ms &&
+        port->last_uptime_ms - uptime_ms > 0x80000000u) {
+        port->uptime_wraps++;
+    }
+    port->last_uptime_ms = uptime_ms;
+
+    int64_t uptime_us = ((int64_t)(port->uptime_wraps << 32) + uptime_ms) * 1000;
+    int64_t sample = now_us - uptime_us;
+
+    if (!port->mapped) {
+        port->mapped = true;
+        port->offset_us = sample;
+        port->offset_updated_us = now_us;
+    } else {
+        int64_t elapsed = now_us - port->offset_updated_us;
+        int64_t relaxed = port->offset_us + elapsed * DRIFT_ALLOWANCE_PPM / 1000000;
+
+        port->offset_us = sample < relaxed ? sample : relaxed;
+        port->offset_updated_us = now_us;
+    }
+
+    uint64_t lag = (uint64_t)(sample - port->offset_us);
+    port->lag_sum_us += lag;
+    if (lag > port->lag_max_us) {
+        port->lag_max_us = lag;
+    }
+
+    return uptime_us + port->offset_us;
+}
+
+static device_entry_t *device_lookup(uint64_t addr)
+{
+    uint32_t slot = (uint32_t)((addr * 0x9E3779B97F4A7C15ULL) >> 32) & (DEVICE_TABLE_SIZE - 1);
+
+    for (uint32_t probe = 0; probe < DEVICE_TABLE_SIZE; probe++) {
+        device_entry_t *dev = &devices[(slot + probe) & (DEVICE_TABLE_SIZE - 1)];
+        if (!dev->used) {
+            if (device_count >= DEVICE_TABLE_SIZE * 3 / 4) {
+                return NULL;
+            }
+            dev->used = true;
+            dev->addr = addr;
+            device_count++;
+            return dev;
+        }
+        if (dev->addr == addr) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+static void handle_record(port_t *port, int index, const char *json, size_t len,
+                          int64_t now_us)
+{
+    int64_t mapped_us = now_us;
+    const char *ts = jsonl_find(json, "timestamp_ms");
+    const char *ts_us = jsonl_find(json, "timestamp_us");
+
+    if (jsonl_is_type(json, "sync_resp")) {
+        handle_sync_response(port, json, now_us);
+        return;
+    }
+
+    /* Journaled records were held back, so they must not move the mapping */
+    if (jsonl_find(json, "journaled") != NULL) {
+        if (ts_us != NULL && port->mapped) {
+            mapped_us = strtoll(ts_us, NULL, 10) + port->offset_us;
+        }
+    } else if (ts != NULL) {
+        mapped_us = map_uptime(port, (uint32_t)strtoul(ts, NULL, 10), now_us);
+    }
+
+    /* Prefer the precise mapping once the time sync has locked */
+    if (ts_us != NULL && port->sync.fit.count >= SYNC_MIN_SAMPLES) {
+        mapped_us = strtoll(ts_us, NULL, 10) - sync_offset(&port->sync, now_us);
+    }
+
+    /* Summary records stand for several sightings of one device */
+    bool summary = jsonl_is_type(json, "summary");
+
+    if (summary || jsonl_is_type(json, "device_found")) {
+        const char *addr = jsonl_find(json, "device_addr");
+        const char *rssi = jsonl_find(json, summary ? "rssi_max" : "rssi_dbm");
+        const char *count = summary ? jsonl_find(json, "count") : NULL;
+
+        if (addr != NULL && *addr == '"') {
+            device_entry_t *dev = device_lookup(strtoull(addr + 1, NULL, 16));
+            if (dev != NULL) {
+                float level = rssi != NULL ? strtof(rssi, NULL) : -200.0f;
+
+                if (dev->count == 0) {
+                    dev->first_host_us = (uint64_t)mapped_us;
+                    dev->best_rssi = level;
+                    dev->best_port = (uint8_t)index;
+                }
+                dev->count += count != NULL ? strtoull(count, NULL, 10) : 1;
+                dev->last_host_us = (uint64_t)mapped_us;
+                dev->port_mask |= 1ULL << index;
+                if (level > dev->best_rssi) {
+                    dev->best_rssi = level;
+                    dev->best_port = (uint8_t)index;
+                }
+            }
+        }
+    }
+
+    /* Re-emit with source port and host time prepended */
+    fprintf(out, "{\"port\":%d,\"host_us\":%lld,", index, (long long)mapped_us);
+    fwrite(json + 1, 1, len - 1, out);
+    fputc('\n', out);
+
+    port->records++;
+    port->total_records++;
+}
+
+/* Split complete lines out of the port buffer and decode them */
+static void process_lines(port_t *port, int index)
+{
+    int64_t now_us = host_us();
+    size_t start = 0;
+
+    for (size_t i = 0; i < port->len; i++) {
+        if (port->buf[i] != '\n') {
+            continue;
+        }
+
+        char *line = &port->buf[start];
+        size_t len = i - start;
+        start = i + 1;
+
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        line[len] = '\0';
+
+        /* Zephyr log lines may precede a record on the same line */
+        char *json = memchr(line, '{', len);
+        char *end = json != NULL ? strrchr(json, '}') : NULL;
+        if (json == NULL || end == NULL) {
+            if (len > 0) {
+                port->log_lines++;
+            }
+            continue;
+        }
+        if (json != line) {
+            port->log_lines++;
+        }
+
+        end[1] = '\0';
+        handle_record(port, index, json, (size_t)(end - json) + 1, now_us);
+    }
+
+    if (start > 0) {
+        memmove(port->buf, &port->buf[start], port->len - start);
+        port->len -= start;
+    }
+
+    /* Drop an overlong partial line rather than stall the port */
+    if (port->len >= sizeof(port->buf) - 1) {
+        port->len = 0;
+        port->log_lines++;
+    }
+}
+
+/* Per-port statistics as records in the unified stream, for -j */
+static bool stats_records;
+
+static void report(double interval_s)
+{
+    size_t total = 0;
+
+    fprintf(stderr, "--- %d ports, %zu devices ---\n", port_count, device_count);
+    for (int i = 0; i < port_count; i++) {
+        port_t *port = &ports[i];
+
+        fprintf(stderr,
+                "[%d] %s%s: %.0f rec/s, %.0f B/s, lag avg=%.1f ms max=%.1f ms, "
+                "%llu log lines\n",
+                i, port->path, port->open ? "" : " (closed)",
+                port->records / interval_s, port->bytes / interval_s,
+                port->records ? port->lag_sum_us / 1000.0 / port->records : 0.0,
+                port->lag_max_us / 1000.0,
+                (unsigned long long)port->log_lines);
+
+        if (port->sync.fit.count >= SYNC_MIN_SAMPLES) {
+            fprintf(stderr,
+                    "    sync: offset=%lld us drift=%.2f ppm delay=%lld us "
+                    "(min %lld us, %llu rejected)\n",
+                    (long long)sync_offset(&port->sync, host_us()),
+                    port->sync.fit.b * 1e6, (long long)port->sync.last_delay_us,
+                    (long long)port->sync.min_delay_us,
+                    (unsigned long long)port->sync.rejected);
+        }
+
+        if (stats_records) {
+            fprintf(out,
+                    "{\"type\":\"port_stats\",\"port\":%d,\"host_us\":%lld,"
+                    "\"open\":%s,\"records\":%llu,\"rec_per_s\":%.1f,\"bytes_per_s\":%.1f,"
+                    "\"lag_avg_ms\":%.3f,\"lag_max_ms\":%.3f,\"log_lines\":%llu}\n",
+                    i, (long long)host_us(), port->open ? "true" : "false",
+                    (unsigned long long)port->records, port->records / interval_s,
+                    port->bytes / interval_s,
+                    port->records ? port->lag_sum_us / 1000.0 / port->records : 0.0,
+                    port->lag_max_us / 1000.0, (unsigned long long)port->log_lines);
+        }
+
+        total += port->records;
+        port->records = 0;
+        port->bytes = 0;
+        port->lag_sum_us = 0;
+        port->lag_max_us = 0;
+        port->log_lines = 0;
+    }
+    fprintf(stderr, "Total: %.0f rec/s\n", total / interval_s);
+    fflush(out);
+}
+
+static void dump_device_table(void)
+{
+    for (size_t i = 0; i < DEVICE_TABLE_SIZE; i++) {
+        const device_entry_t *dev = &devices[i];
+        if (!dev->used) {
+            continue;
+        }
+        fprintf(out,
+                "{\"type\":\"device_summary\",\"device_addr\":\"%016llX\","
+                "\"count\":%llu,\"first_host_us\":%llu,\"last_host_us\":%llu,"
+                "\"best_rssi_dbm\":%.2f,\"best_port\":%u,\"port_mask\":%llu}\n",
+                (unsigned long long)dev->addr, (unsigned long long)dev->count,
+                (unsigned long long)dev->first_host_us,
+                (unsigned long long)dev->last_host_us,
+                (double)dev->best_rssi, dev->best_port,
+                (unsigned long long)dev->port_mask);
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-o out.jsonl] [-i report_s] [-s sync_ms] [-j] [-f] port [port ...]\n"
+            "  -o file   Write the unified stream to file (default: stdout)\n"
+            "  -i s      Statistics interval on stderr (default: %d s)\n"
+            "  -s ms     Time sync request interval, 0 to disable (default: %d ms)\n"
+            "  -j        Also write the statistics as port_stats records\n"
+            "  -f        Follow: reopen ports that hang up\n",
+            prog, DEFAULT_REPORT_S, DEFAULT_SYNC_MS);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL;
+    int report_s = DEFAULT_REPORT_S;
+    int sync_ms = DEFAULT_SYNC_MS;
+    bool follow = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:i:s:jfh")) != -1) {
+        switch (opt) {
+        case 'o':
+            out_path = optarg;
+            break;
+        case 'i':
+            report_s = atoi(optarg) > 0 ? atoi(optarg) : DEFAULT_REPORT_S;
+            break;
+        case 's':
+            sync_ms = atoi(optarg) >= 0 ? atoi(optarg) : DEFAULT_SYNC_MS;
+            break;
+        case 'j':
+            stats_records = true;
+            break;
+        case 'f':
+            follow = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind >= argc || argc - optind > MAX_PORTS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    out = out_path != NULL ? fopen(out_path, "w") : stdout;
+    if (out == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        port_t *port = &ports[port_count];
+        port->path = argv[i];
+        sync_reset(&port->sync);
+
+        int ret = open_port(port);
+        if (ret < 0) {
+            fprintf(stderr, "%s: %s\n", port->path, strerror(-ret));
+            return 1;
+        }
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)port_count};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, port->fd, &ev) < 0) {
+            perror("epoll_ctl");
+            return 1;
+        }
+        port_count++;
+    }
+
+    int open_ports = port_count;
+    int64_t last_report = monotonic_us();
+    int64_t last_retry = last_report;
+    int64_t last_sync = last_report;
+    static char chunk[READ_CHUNK];
+
+    while (running && (open_ports > 0 || follow)) {
+        struct epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(epfd, events, MAX_EVENTS, 200);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int e = 0; e < n; e++) {
+            int index = (int)events[e].data.u32;
+            port_t *port = &ports[index];
+            bool hangup = false;
+
+            /* Drain everything available before moving on */
+            for (;;) {
+                ssize_t got = read(port->fd, chunk, sizeof(chunk));
+                if (got > 0) {
+                    port->bytes += (uint64_t)got;
+                    size_t offset = 0;
+                    while (offset < (size_t)got) {
+                        size_t room = sizeof(port->buf) - 1 - port->len;
+                        size_t copy = MIN((size_t)got - offset, room);
+                        memcpy(&port->buf[port->len], &chunk[offset], copy);
+                        port->len += copy;
+                        offset += copy;
+                        process_lines(port, index);
+                    }
+                    continue;
+                }
+                if (got < 0 && (errno == EAGAIN || errno == EINTR)) {
+                    break;
+                }
+                /* EOF or EIO: the other end of the pty or USB went away */
+                hangup = true;
+                break;
+            }
+
+            if (hangup || (events[e].events & (EPOLLHUP | EPOLLERR))) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, port->fd, NULL);
+                close(port->fd);
+                port->open = false;
+                port->mapped = false;
+                sync_reset(&port->sync);
+                open_ports--;
+                fprintf(stderr, "[%d] %s closed\n", index, port->path);
+            }
+        }
+
+        /* Hand the batch on now rather than at the next report */
+        if (n > 0) {
+            fflush(out);
+        }
+
+        int64_t now = monotonic_us();
+
+        if (follow && open_ports < port_count && now - last_retry >= 1000000) {
+            last_retry = now;
+            for (int i = 0; i < port_count; i++) {
+                if (ports[i].open || open_port(&ports[i]) < 0) {
+                    continue;
+                }
+                struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)i};
+                epoll_ctl(epfd, EPOLL_CTL_ADD, ports[i].fd, &ev);
+                open_ports++;
+                fprintf(stderr, "[%d] %s reopened\n", i, ports[i].path);
+            }
+        }
+
+        if (sync_ms > 0 && now - last_sync >= (int64_t)sync_ms * 1000) {
+            last_sync = now;
+            for (int i = 0; i < port_count; i++) {
+                if (ports[i].open) {
+                    send_sync_request(&ports[i]);
+                }
+            }
+        }
+
+        if (now - last_report >= (int64_t)report_s * 1000000) {
+            report((now - last_report) / 1e6);
+            last_report = now;
+        }
+    }
+
+    report((monotonic_us() - last_report) / 1e6);
+    dump_device_table();
+
+    uint64_t total = 0;
+    for (int i = 0; i < port_count; i++) {
+        total += ports[i].total_records;
+    }
+    fprintf(stderr, "Processed %llu records from %d ports, %zu devices\n",
+            (unsigned long long)total, port_count, device_count);
+
+    if (out != stdout) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+    close(epfd);
+
+    return 0;
+}